@@ -0,0 +1,226 @@
+#include "active.h"
+
+/**
+ * @file active.c
+ * @breif Steps only the tiles of the board that can change, everything else is left alone
+ * @details The board is cut into tiles and a flag is kept for every tile that changed in the last generation. A tile can only change in the next generation if it or one of the tiles around it changed, where around follows the edge the same way the ghost border does. Those tiles get stepped and compared with what they were, every other tile is skipped. Skipping is safe because the two grids take turns, so the grid being written still holds the generation before the current one and a tile that did not change is already correct there. That means a board that is mostly empty or frozen costs about as much as the part of it that is moving. Before the first step, and any time the grids are changed from outside, every tile has to be marked with mark_all_active.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+struct tile_step_t {
+        struct grid_t *grid;
+        struct grid_t *next_grid;
+        struct active_t *active;
+};
+
+/**
+ * Intilizes the tile flags for a board of rows by cols, every tile starts out marked as changed
+ * @param rows the rows of the board
+ * @param cols the cols of the board
+ * @return the tile flags, or NULL if an allocation failed
+ */
+struct active_t *init_active(int rows, int cols)
+{
+        int tiles;
+        struct active_t *active = NULL;
+
+        active = malloc(sizeof(struct active_t));
+
+        if (!active) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        active->rows = rows;
+        active->cols = cols;
+        active->tile_rows = (rows + TILE_SIZE - 1) / TILE_SIZE;
+        active->tile_cols = (cols + TILE_SIZE - 1) / TILE_SIZE;
+        tiles = active->tile_rows * active->tile_cols;
+        active->changed = malloc(tiles);
+        active->next_changed = malloc(tiles);
+        active->dirty = malloc(tiles);
+        active->list = malloc(sizeof(int) * tiles);
+        active->active = 0;
+
+        if (!active->changed || !active->next_changed || !active->dirty || !active->list) {
+                printf("Malloc failed\n");
+                free_active(active);
+                return NULL;
+        }
+
+        mark_all_active(active);
+
+        return active;
+}
+
+/**
+ * frees the tile flags made by init_active
+ * @param *active the flags to free, may be NULL
+ */
+void free_active(struct active_t *active)
+{
+        if (!active) {
+                return;
+        }
+
+        free(active->changed);
+        free(active->next_changed);
+        free(active->dirty);
+        free(active->list);
+        free(active);
+}
+
+/**
+ * marks every tile as changed so the next step does the whole board, needed after the grids are filled or edited
+ * @param *active the tile flags
+ */
+void mark_all_active(struct active_t *active)
+{
+        memset(active->changed, 1, active->tile_rows * active->tile_cols);
+}
+
+/**
+ * marks the tile that holds a cell as dirty, cells off the board are moved onto it based on the edge
+ * @param *active the tile flags
+ * @param row the row of the cell, may be -1 or rows
+ * @param col the col of the cell, may be -1 or cols
+ * @param edge the edge either hedge torus klein or cross, 1 2 3 or 5
+ */
+static void mark_cell(struct active_t *active, int row, int col, int edge)
+{
+        if (row < 0 || row >= active->rows) {
+                if (edge == EDGE_HEDGE || (edge == EDGE_CROSS && (col < 0 || col >= active->cols))) {
+                        return; /* the cross surface leaves its corners dead */
+                }
+                row = (row + active->rows) % active->rows;
+                col = (edge == EDGE_KLEIN || edge == EDGE_CROSS) ? active->cols - 1 - col : col; /* same flip as the ghost rows */
+        }
+
+        if (col < 0 || col >= active->cols) {
+                if (edge == EDGE_HEDGE) {
+                        return;
+                }
+                col = (col + active->cols) % active->cols;
+                row = (edge == EDGE_CROSS) ? active->rows - 1 - row : row; /* same flip as the cross ghost cols */
+        }
+
+        active->dirty[(row / TILE_SIZE) * active->tile_cols + col / TILE_SIZE] = 1;
+}
+
+/**
+ * marks every tile that reads a cell of the tile at tile_row, tile_col as dirty
+ * @param *active the tile flags
+ * @param tile_row the row of the tile that changed
+ * @param tile_col the col of the tile that changed
+ * @param edge the edge either hedge torus klein or cross, 1 2 3 or 5
+ */
+static void mark_neighbors(struct active_t *active, int tile_row, int tile_col, int edge)
+{
+        int i;
+        int j;
+        int first = tile_row * TILE_SIZE;
+        int left = tile_col * TILE_SIZE;
+        int last = (first + TILE_SIZE > active->rows) ? active->rows - 1 : first + TILE_SIZE - 1;
+        int right = (left + TILE_SIZE > active->cols) ? active->cols - 1 : left + TILE_SIZE - 1;
+
+        if (tile_row > 0 && tile_row < active->tile_rows - 1 && tile_col > 0 && tile_col < active->tile_cols - 1) {
+                /* nowhere near an edge so the 3 by 3 tiles around it are all there is */
+                for (i = tile_row - 1; i <= tile_row + 1; i++) {
+                        for (j = tile_col - 1; j <= tile_col + 1; j++) {
+                                active->dirty[i * active->tile_cols + j] = 1;
+                        }
+                }
+                return;
+        }
+
+        /* on the edge of the board walk the ring of cells just outside the tile and let mark_cell wrap them */
+        active->dirty[tile_row * active->tile_cols + tile_col] = 1;
+
+        for (j = left - 1; j <= right + 1; j++) {
+                mark_cell(active, first - 1, j, edge);
+                mark_cell(active, last + 1, j, edge);
+        }
+
+        for (i = first; i <= last; i++) {
+                mark_cell(active, i, left - 1, edge);
+                mark_cell(active, i, right + 1, edge);
+        }
+}
+
+/**
+ * steps one tile and records whether any cell in it changed
+ * @param *arg the tile_step_t for the generation
+ * @param task the index into the list of dirty tiles
+ * @param id the thread stepping it
+ */
+static void step_tile(void *arg, int task, int id)
+{
+        int i;
+        struct tile_step_t *step = arg;
+        struct active_t *active = step->active;
+        int tile = active->list[task];
+        int first = (tile / active->tile_cols) * TILE_SIZE;
+        int col = (tile % active->tile_cols) * TILE_SIZE;
+        int last = (first + TILE_SIZE > active->rows) ? active->rows : first + TILE_SIZE;
+        int width = (col + TILE_SIZE > active->cols) ? active->cols - col : TILE_SIZE;
+        int changed = 0;
+
+        step_block(step->grid, step->next_grid, first, last, col, width);
+
+        for (i = first; i < last && !changed; i++) {
+                changed = memcmp(step->grid->cell[i] + col, step->next_grid->cell[i] + col, width) != 0;
+        }
+
+        active->next_changed[tile] = changed;
+}
+
+/**
+ * Does the same as check_board but only steps the tiles that changed in the last generation and the tiles next to them
+ * @param *grid the grid to be checked
+ * @param *next_grid the grid to be filled with the next generation, it must hold the generation before grid
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *active the tile flags, updated for the generation that was just made
+ * @param *pool the pool to step the tiles on, NULL to step them on this thread
+ */
+void check_board_active(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data, struct active_t *active, struct pool_t *pool)
+{
+        int i;
+        int j;
+        int tiles = active->tile_rows * active->tile_cols;
+        unsigned char *swap;
+        struct tile_step_t step = { grid, next_grid, active };
+
+        fill_ghost(grid, matrix_data->edge);
+        memset(active->dirty, 0, tiles);
+
+        for (i = 0; i < active->tile_rows; i++) {
+                for (j = 0; j < active->tile_cols; j++) {
+                        if (active->changed[i * active->tile_cols + j]) {
+                                mark_neighbors(active, i, j, matrix_data->edge);
+                        }
+                }
+        }
+
+        active->active = 0;
+        for (i = 0; i < tiles; i++) {
+                active->next_changed[i] = 0;
+
+                if (active->dirty[i]) {
+                        active->list[active->active++] = i;
+                }
+        }
+
+        if (pool) {
+                pool_run(pool, active->active, step_tile, &step);
+        } else {
+                for (i = 0; i < active->active; i++) {
+                        step_tile(&step, i, 0);
+                }
+        }
+
+        swap = active->changed;
+        active->changed = active->next_changed;
+        active->next_changed = swap;
+}
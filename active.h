@@ -0,0 +1,38 @@
+#include "life.h"
+#include "pool.h"
+
+/**
+ * @file active.h
+ * @breif headers for stepping only the parts of the board that are changing, in active.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef ACTIVE_H_
+#define ACTIVE_H_
+
+/* tiles are TILE_SIZE by TILE_SIZE cells, the last row and col of tiles may be smaller */
+#define TILE_SIZE 32
+
+struct active_t {
+        int rows;
+        int cols;
+        int tile_rows;
+        int tile_cols;
+        unsigned char *changed; /* tiles that changed in the last generation */
+        unsigned char *next_changed;
+        unsigned char *dirty; /* tiles that have to be stepped this generation */
+        int *list; /* the dirty tiles in order, handed to the pool */
+        int active; /* how many tiles were stepped in the last generation */
+};
+
+struct active_t *init_active(int rows, int cols);
+
+void free_active(struct active_t *active);
+
+void mark_all_active(struct active_t *active);
+
+void check_board_active(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data, struct active_t *active, struct pool_t *pool);
+
+#endif
@@ -0,0 +1,475 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <errno.h>
+#include <time.h>
+#include "life.h"
+#include "simd.h"
+#include "sim.h"
+#include "checkpoint.h"
+#include "stats.h"
+#include "cycle.h"
+#include "dist.h"
+
+/**
+ * @file batch.c
+ * @breif runs the game of life with no window and writes the final board out, for machines with no display
+ * @details Takes the same board options as gl.c, minus the ones that only matter to the window, and steps the board as fast as it can for the number of generations asked for. The final board is written as a life 106 file, so it can be read back in with -f, with the population and timing put in the # lines at the top.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * writes one alive cell as a life 106 line
+ * @param *target the FILE to write to
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+static void write_cell(void *target, long long row, long long col)
+{
+        fprintf(target, "%lld %lld\n", row, col);
+}
+
+/**
+ * writes the current board and the stats for the run as a life 106 file
+ * @param *out the file to write to
+ * @param *sim the sim holding the board
+ * @param generations how many generations were stepped cell by cell, not the ones a cycle jumped over
+ * @param seconds how long stepping took
+ * @param *found what the run settled into, NULL if it was not looked for or never settled
+ */
+static void write_board(FILE *out, struct sim_t *sim, unsigned long long generations, double seconds, const char *found)
+{
+        int i;
+        int j;
+        struct grid_t *grid;
+        double cells = (double) sim->matrix_data->row_matrix * sim->matrix_data->col_matrix;
+
+        fprintf(out, "#Life 1.06\n");
+        fprintf(out, "#generation %llu\n", sim->generation);
+        fprintf(out, "#population %lld\n", sim_population(sim));
+        fprintf(out, "#seconds %f\n", seconds);
+
+        if (found) {
+                fprintf(out, "#%s\n", found);
+        }
+
+        if (seconds > 0 && !sim->sparse) {
+                fprintf(out, "#cell updates per second %.0f\n", cells * generations / seconds);
+        }
+
+        if (sim->sparse) {
+                sparse_cells(sim->sparse, write_cell, out); /* the whole plane, not just the part a window would show */
+                return;
+        } else if (sim->packed[0]) {
+                packed_cells(sim->packed[sim->cur], write_cell, out); /* a mapped board has no grid to unpack into */
+                return;
+        }
+
+        grid = sim_view(sim);
+        for (i = 0; i < grid->rows; i++) {
+                for (j = 0; j < grid->cols; j++) {
+                        if (grid->cell[i][j] == 1) { /* dying cells of a generations rule are left out */
+                                write_cell(out, i, j);
+                        }
+                }
+        }
+}
+
+/**
+ * works out how many generations can be stepped before the board is wanted for something
+ * @param generation the generation the sim is on
+ * @param left the generations left in the run
+ * @param every the board is wanted on every multiple of this, 0 for never
+ * @return the generations to the next multiple of every, or left if that comes first
+ */
+static unsigned long long until_next(unsigned long long generation, unsigned long long left, unsigned long long every)
+{
+        unsigned long long next;
+
+        if (every == 0) {
+                return left;
+        }
+        next = every - generation % every;
+
+        return (next < left) ? next : left;
+}
+
+int main(int argc, char *argv[])
+{
+	int m = 9999;
+	int n = 9999;
+        struct sim_t *sim = NULL;
+        unsigned long long generations = 0; /* generations to step after loading */
+        unsigned long long jump = 0;
+        unsigned long long i;
+        unsigned long long stepped = 0; /* generations sim_advance stepped, the rest were jumped by cycle_forward */
+        unsigned long long chunk; /* generations stepped at once, sim_advance takes them in passes of the depth */
+        size_t megabytes = HASHLIFE_DEFAULT_MB;
+        char *filepath = NULL;
+        char *outpath = NULL;
+        char *resume = NULL; /* checkpoint to pick the run up from */
+        char *checkpoint = NULL; /* checkpoint to save to */
+        unsigned long long every = 0; /* generations between checkpoints, 0 for only at the end */
+        struct checkpoint_t header;
+        struct rule_t rule;
+        struct stats_t stats;
+        struct stats_t *timed = NULL; /* only set when the stats are logged, so an untimed run pays nothing */
+        unsigned long long stats_every = 0;
+        struct cycle_t cycle;
+        size_t history = 0; /* entries in the cycle history, 0 for not looking */
+        int moving = 0;
+        int stop = 0; /* stop when the run settles instead of skipping to the last generation */
+        char found[SIZE];
+        int settled = 0;
+        int procs = 1; /* worker processes to split the board over */
+        char line[SIZE];
+        double step_start;
+        struct option long_options[] = {
+                { "stats-every", required_argument, NULL, 'S' },
+                { "cycles", required_argument, NULL, 'c' },
+                { "translate", no_argument, NULL, 'T' },
+                { "stop", no_argument, NULL, 'x' },
+                { "map", required_argument, NULL, 'F' },
+                { "procs", required_argument, NULL, 'P' },
+                { NULL, 0, NULL, 0 }
+        };
+        FILE *out = stdout;
+        struct timespec start;
+        struct timespec end;
+        double seconds;
+        int c;
+        struct data_t *matrix_data = malloc(sizeof(struct data_t));
+
+        if (!matrix_data) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        init_struct(matrix_data);
+        select_kernel();
+
+        /*procsses all of the arguments */
+        while ((c = getopt_long(argc, argv, ":R:C:e:f:o:m:j:b:n:J:M:O:L:K:k:u:S:c:TxF:P:H", long_options, NULL)) != -1) {
+                        switch (c) {
+                        case 'R':
+                                if (atoi(optarg) > 1) {
+                                        matrix_data->row_matrix = atoi(optarg);
+                                }
+                                break; /*size of the board, there is no window to take it from */
+                        case 'C':
+                                if (atoi(optarg) > 1) {
+                                        matrix_data->col_matrix = atoi(optarg);
+                                }
+                                break;
+                        case 'e':
+                                if (strncmp("hedge", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->edge = EDGE_HEDGE;
+                                } else if (strncmp("torus", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->edge = EDGE_TORUS;
+                                } else if (strncmp("klein", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->edge = EDGE_KLEIN;
+                                } else if (strncmp("plane", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->edge = EDGE_PLANE;
+                                } else if (strncmp("cross", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->edge = EDGE_CROSS;
+                                }
+                                break;
+                        case 'f':
+                                filepath = optarg; /* taken as given, not from Conway_Life/ */
+                                break;
+                        case 'o':
+                                m = atoi(strtok(optarg, ","));
+                                n = atoi(strtok(NULL, ","));
+                                break;
+                        case 'm':
+                                if (strncmp("byte", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->engine = ENGINE_BYTE;
+                                } else if (strncmp("packed", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->engine = ENGINE_PACKED;
+                                } else if (strncmp("active", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->engine = ENGINE_ACTIVE;
+                                }
+                                break;
+                        case 'j':
+                                matrix_data->threads = atoi(optarg);
+
+                                if (matrix_data->threads < 1) {
+                                        printf("Thread count must be at least 1\nResetting to default\n");
+                                        matrix_data->threads = 1;
+                                }
+                                break;
+                        case 'b':
+                                matrix_data->depth = atoi(optarg);
+
+                                if (matrix_data->depth < 1 || matrix_data->depth > TEMPORAL_MAX_DEPTH) {
+                                        printf("Depth must be from 1 to %d\nResetting to default\n", TEMPORAL_MAX_DEPTH);
+                                        matrix_data->depth = 1;
+                                }
+                                break;
+                        case 'n':
+                                generations = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'J':
+                                jump = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'M':
+                                if (atoi(optarg) > 0) {
+                                        megabytes = atoi(optarg);
+                                }
+                                break;
+                        case 'O':
+                                outpath = optarg;
+                                break;
+                        case 'L':
+                                resume = optarg;
+                                break;
+                        case 'K':
+                                checkpoint = optarg;
+                                break;
+                        case 'k':
+                                every = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'u':
+                                if (parse_rule(optarg, &rule) == -1) {
+                                        fprintf(stderr, "%s: argument to option '-u' is not a rule\n", argv[0]);
+                                        exit(1);
+                                }
+                                strcpy(matrix_data->rule, rule.text);
+                                matrix_data->rule_given = 1;
+                                break;
+                        case 'S':
+                                stats_every = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'c':
+                                history = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'T':
+                                moving = 1;
+                                break;
+                        case 'x':
+                                stop = 1;
+                                break;
+                        case 'F':
+                                matrix_data->map = optarg;
+                                break;
+                        case 'P':
+                                procs = atoi(optarg);
+
+                                if (procs < 1) {
+                                        printf("Process count must be at least 1\nResetting to default\n");
+                                        procs = 1;
+                                }
+                                break;
+                        case 'H':
+                                printf("Usage: \n./life_batch -f filename -n generations -R rows -C cols -e edge");
+                                printf(" -o starting position -m engine -j threads -b depth -J generation -M megabytes -O output -L checkpoint -K checkpoint -k generations -u rule -S generations -c entries -T -x -F file -P processes -H help\n");
+                                printf("f: file from which the initial pattern will be taken, RLE, life 1.05, .cells or life 1.06\n");
+                                printf("n: number of generations to step\n");
+                                printf("R: number of rows on the board\nC: number of cols on the board\n");
+                                printf("e: type of edge either hedge, torus, klein, cross, or plane\n");
+                                printf("o: x,y starting positions, entered with no space and a comma\n");
+                                printf("m: engine used to step the board either byte, packed, or active\n");
+                                printf("j: number of threads to step the board with\n");
+                                printf("b: generations the byte engine steps for every pass over the board, up to %d, for boards too big for the\n",
+                                                TEMPORAL_MAX_DEPTH);
+                                printf("   cache on the torus or hedge, -c steps one generation at a time\n");
+                                printf("J: generation to jump to before stepping, uses HashLife on the hedge edge while the pattern is clear of it, and on the plane\n");
+                                printf("M: megabytes HashLife may use before it collects garbage\n");
+                                printf("O: file to write the final board to instead of stdout\n");
+                                printf("L: checkpoint to pick the run up from instead of -f, it sets the size and edge\n");
+                                printf("K: checkpoint to save to at the end of the run\n");
+                                printf("k: also save the checkpoint every this many generations\n");
+                                printf("u: rule as B/S, B36/S23 is HighLife, B/S/C for generations, B2/S/C3 is Brian's Brain, or R,C,M,S,B,NM for\n");
+                                printf("   larger than life, R5,C0,M1,S34..58,B34..45,NM is Bosco, it beats the rule in the file or checkpoint\n");
+                                printf("S: print the step time and board counts to stderr every this many generations, also --stats-every\n");
+                                printf("c: look for the board dying out, stopping or repeating, keeping this many past generations, %d is plenty\n",
+                                                CYCLE_DEFAULT_SIZE);
+                                printf("   for soups, once it repeats the run skips to the last generation, also --cycles\n");
+                                printf("T: with -c on the plane, also look for the cells repeating somewhere else, for spaceships, also --translate\n");
+                                printf("x: with -c, stop at the generation the repeat was found instead of skipping ahead, also --stop\n");
+                                printf("F: keep the board in the files file.0 and file.1 instead of memory, for boards too big for it, runs\n");
+                                printf("   the packed engine with two state rules on any edge but the plane and can not -J, also --map\n");
+                                printf("P: split the board into strips of rows over this many processes that swap their edge rows through shared\n");
+                                printf("   memory, on the hedge, torus or klein edge with a rule of radius 1, not with -L -K -J -c -S or -F, also --procs\n");
+                                printf("H: help menu display\n");
+                                exit(1);
+                                break;
+                        case ':':
+                                fprintf(stderr, "%s: option '-%c' requires an argument\n", argv[0], optopt);
+                                exit(1); /*error processing */
+                        case '?':
+                        default:
+                                printf("Illegal option %c - ignored\n", optopt);
+                                break;
+                        }
+        }
+
+        if (!filepath && !resume) {
+                fprintf(stderr, "%s: a starting file is needed, use -f or -L\n", argv[0]);
+                exit(1);
+        }
+
+        if (resume) {
+                /* the board has to be made the size and edge it was saved with */
+                if (read_checkpoint(resume, &header) == -1) {
+                        fprintf(stderr, "%s: argument to option '-L' is not a checkpoint\n", argv[0]);
+                        exit(1);
+                }
+                matrix_data->row_matrix = header.rows;
+                matrix_data->col_matrix = header.cols;
+                matrix_data->edge = header.edge;
+        }
+
+        if (matrix_data->map) {
+                if (matrix_data->edge == EDGE_PLANE || jump > 0) {
+                        fprintf(stderr, "%s: option '-F' needs an edge other than the plane and can not be used with -J\n", argv[0]);
+                        exit(1);
+                }
+                matrix_data->engine = ENGINE_PACKED; /* the only engine with a board that can be mapped */
+        }
+
+        if (m == 9999) {
+                m = matrix_data->row_matrix / 2;
+        }
+
+        if (n == 9999) {
+                n = matrix_data->col_matrix / 2;
+        }
+
+        if (procs > 1) {
+                if (resume || checkpoint || jump > 0 || history > 0 || stats_every > 0 || matrix_data->map || !dist_fits(matrix_data, procs)) {
+                        fprintf(stderr, "%s: option '-P' needs the hedge, torus or klein edge, a rule with a radius of 1 and no more processes\n"
+                                        "than rows, and can not be used with -L, -K, -J, -c, -S or -F\n", argv[0]);
+                        exit(1);
+                }
+
+                if (outpath) {
+                        errno = 0;
+                        out = fopen(outpath, "w");
+
+                        if (!out) {
+                                fprintf(stderr, "%s: argument to option '-O' failed: %s\n", argv[0], strerror(errno));
+                                exit(1);
+                        }
+                }
+
+                /* every process loads its own strip, no one of them holds the whole board */
+                c = dist_run(matrix_data, filepath, m, n, generations, procs, out);
+
+                if (outpath) {
+                        fclose(out);
+                }
+                free(matrix_data);
+                exit((c == -1) ? 1 : 0);
+        }
+
+        sim = init_sim(matrix_data);
+
+        if (!sim) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        if (matrix_data->rule_given && sim_rule(sim, matrix_data->rule) == -1) {
+                fprintf(stderr, "%s: rule %s can not be run on this edge, the plane only runs two state B/S rules without B0 and the cross\n"
+                                "surface only runs rules with a radius of 1, -F only runs two state rules with a radius of 1\n", argv[0], matrix_data->rule);
+                exit(1);
+        }
+
+        errno = 0;
+        if (resume) {
+                if (load_checkpoint(sim, resume) == -1) {
+                        fprintf(stderr, "%s: argument to option '-L' failed\n", argv[0]);
+                        exit(1);
+                }
+        } else if (sim_load(sim, filepath, m, n) == -1) {
+                fprintf(stderr, "%s: argument to option '-f' failed: %s\n", argv[0], strerror(errno));
+                exit(1);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        if (jump > 0) {
+                sim_jump(sim, jump, megabytes);
+        }
+
+        if (stats_every > 0) {
+                init_stats(&stats, stats_every);
+                timed = &stats;
+        }
+
+        if (history > 0) {
+                if (init_cycle(&cycle, history, moving) == -1) {
+                        exit(1);
+                }
+                cycle_start(&cycle, sim);
+        }
+
+        for (i = 0; i < generations; i += chunk) {
+                /* cycles are looked for after every generation, checkpoints and stats want the generations they are due on */
+                chunk = (history > 0) ? 1 : until_next(sim->generation, generations - i, (checkpoint) ? every : 0);
+                chunk = until_next(sim->generation, chunk, stats_every);
+
+                step_start = stats_begin();
+                sim_advance(sim, chunk);
+                stats_end_many(timed, STATS_STEP, step_start, chunk);
+                stepped += chunk;
+
+                if (history > 0 && cycle_step(&cycle, sim)) {
+                        settled = 1;
+                        cycle_line(&cycle, found, SIZE);
+                        fprintf(stderr, "%s\n", found);
+
+                        if (!stop) {
+                                cycle_forward(&cycle, sim, sim->generation + generations - i - chunk);
+                        }
+                        break;
+                }
+
+                if (stats_due(timed, sim->generation)) {
+                        stats_sample(timed, sim);
+                        stats_line(timed, line, SIZE);
+                        fprintf(stderr, "%s\n", line);
+                }
+
+                if (checkpoint && every > 0 && sim->generation % every == 0 && save_checkpoint(sim, checkpoint) == -1) {
+                        fprintf(stderr, "%s: could not save a checkpoint to %s\n", argv[0], checkpoint);
+                }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (checkpoint && save_checkpoint(sim, checkpoint) == -1) {
+                fprintf(stderr, "%s: could not save a checkpoint to %s\n", argv[0], checkpoint);
+        }
+        seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+        if (outpath) {
+                errno = 0;
+                out = fopen(outpath, "w");
+
+                if (!out) {
+                        fprintf(stderr, "%s: argument to option '-O' failed: %s\n", argv[0], strerror(errno));
+                        exit(1);
+                }
+        }
+
+        write_board(out, sim, stepped, seconds, (settled) ? found : NULL);
+
+        if (outpath) {
+                fclose(out);
+                printf("generation %llu population %lld seconds %f\n", sim->generation, sim_population(sim), seconds);
+        }
+
+        if (timed) {
+                free_stats(timed);
+        }
+        if (history > 0) {
+                free_cycle(&cycle);
+        }
+        free_sim(sim);
+        free(matrix_data);
+        return 0;
+}
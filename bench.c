@@ -0,0 +1,433 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/resource.h>
+#include "life.h"
+#include "load.h"
+#include "simd.h"
+#include "sim.h"
+
+/**
+ * @file bench.c
+ * @breif times every engine over a matrix of boards and writes what it found as JSON
+ * @details Every case is one engine, edge, thread count and board, either a random soup of a given density or a pattern from the pattern directory. The soups come from a fixed seed, so every engine steps the same cells and two runs of the same build step the same boards. A case is stepped one generation to warm up and then until it has run for the time asked for, so small boards get enough generations to time and big ones do not take forever. The plane has no edge and only the sparse engine runs it, its cell updates are counted over the area the soup was put down on. The JSON is one object with the kernel, rule and peak memory of the run and a results array with one object for each case.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#define BENCH_MOST 16 /* the most values any one list option takes */
+
+static const char *edge_names[] = { "", "hedge", "torus", "klein", "plane", "cross" };
+static const char *engine_names[] = { "", "byte", "packed", "active", "sparse" };
+
+/* what one case puts on the board and how long it runs */
+struct bench_t {
+        struct sim_t *sim;
+        int row; /* where the pattern or soup goes */
+        int col;
+        double seconds;
+        int first; /* 1 until the first result is written, for the commas */
+};
+
+/**
+ * reads a comma separated list of numbers
+ * @param *text the list, it is cut up by strtok
+ * @param *values filled with the numbers
+ * @return how many numbers were read
+ */
+static int read_numbers(char *text, double *values)
+{
+        int count = 0;
+        char *token = strtok(text, ",");
+
+        while (token && count < BENCH_MOST) {
+                values[count++] = atof(token);
+                token = strtok(NULL, ",");
+        }
+
+        return count;
+}
+
+/**
+ * reads a comma separated list of names, each one can be cut short the same way the other programs take them
+ * @param *text the list, it is cut up by strtok
+ * @param **names the names, the index of each one is what is stored
+ * @param known how many names there are
+ * @param *values filled with the index of each name
+ * @return how many names were read, or -1 if one is not known
+ */
+static int read_names(char *text, const char **names, int known, int *values)
+{
+        int i;
+        int count = 0;
+        char *token = strtok(text, ",");
+
+        while (token && count < BENCH_MOST) {
+                for (i = 1; i < known && strncmp(names[i], token, strlen(token)) != 0; i++) {
+                }
+
+                if (i == known) {
+                        return -1;
+                }
+                values[count++] = i;
+                token = strtok(NULL, ",");
+        }
+
+        return count;
+}
+
+/**
+ * puts one alive cell on the board of the case, cells that land off a board with an edge are dropped
+ * @param *target the bench_t
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+static void put_cell(void *target, long long row, long long col)
+{
+        struct bench_t *bench = target;
+        struct grid_t *grid = bench->sim->grid[bench->sim->cur];
+
+        row += bench->row;
+        col += bench->col;
+
+        if (bench->sim->sparse) {
+                sparse_set(bench->sim->sparse, row, col);
+        } else if (row >= 0 && row < grid->rows && col >= 0 && col < grid->cols) {
+                grid->cell[row][col] = 1;
+        }
+}
+
+/**
+ * seconds on the monotonic clock
+ * @return the time
+ */
+static double now(void)
+{
+        struct timespec time;
+
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * steps the board of a case and writes its result
+ * @param *out the file the JSON goes to
+ * @param *bench the case, its board already filled
+ * @param *key what the case is told apart by, density or pattern
+ * @param *what the soup density or the pattern name, as plain text
+ * @param string 1 to write what in the JSON as a string, 0 as a number
+ */
+static void run_case(FILE *out, struct bench_t *bench, const char *key, const char *what, int string)
+{
+        struct sim_t *sim = bench->sim;
+        struct data_t *matrix_data = sim->matrix_data;
+        unsigned long long generations = 0;
+        double cells = (double)matrix_data->row_matrix * matrix_data->col_matrix;
+        double start;
+        double seconds;
+
+        sim_step(sim); /* the first step pays for faulting the boards in */
+
+        start = now();
+        do {
+                sim_advance(sim, matrix_data->depth); /* a whole pass at a time when the byte engine steps in tiles */
+                generations += matrix_data->depth;
+                seconds = now() - start;
+        } while (seconds < bench->seconds);
+
+        fprintf(out, "%s\n    {\"engine\": \"%s\", \"edge\": \"%s\", \"threads\": %d, \"depth\": %d, \"rows\": %d, \"cols\": %d, ",
+                        bench->first ? "" : ",", engine_names[matrix_data->engine], edge_names[matrix_data->edge],
+                        matrix_data->threads, matrix_data->depth, matrix_data->row_matrix, matrix_data->col_matrix);
+        fprintf(out, string ? "\"%s\": \"%s\", " : "\"%s\": %s, ", key, what);
+        fprintf(out, "\"generations\": %llu, \"seconds\": %.6f, \"generations_per_second\": %.3f, ",
+                        generations, seconds, generations / seconds);
+        fprintf(out, "\"cell_updates_per_second\": %.0f, \"ns_per_cell\": %.4f, \"population\": %lld, \"bytes\": %zu}",
+                        cells * generations / seconds, seconds * 1e9 / (cells * generations), sim_population(sim), sim_memory(sim));
+        fflush(out);
+        bench->first = 0;
+
+        fprintf(stderr, "%s %s %dx%d j%d %s %s: %.3g cell updates a second\n", engine_names[matrix_data->engine],
+                        edge_names[matrix_data->edge], matrix_data->row_matrix, matrix_data->col_matrix,
+                        matrix_data->threads, key, what, cells * generations / seconds);
+}
+
+/**
+ * makes the sim for one case, with the rule the user asked for
+ * @param *matrix_data the size, edge, engine and threads of the case
+ * @param *rule the rule to step with
+ * @return the sim, or NULL if it could not be made or can not run the rule
+ */
+static struct sim_t *make_sim(struct data_t *matrix_data, const char *rule)
+{
+        struct sim_t *sim = init_sim(matrix_data);
+
+        if (sim && matrix_data->rule_given && sim_rule(sim, rule) == -1) {
+                free_sim(sim);
+                return NULL;
+        }
+
+        return sim;
+}
+
+/**
+ * runs one soup case
+ * @param *out the file the JSON goes to
+ * @param *bench the case, its sim is made here
+ * @param *matrix_data the size, edge, engine and threads of the case
+ * @param density the chance each cell starts alive
+ * @param seed the seed for the soup
+ */
+static void soup_case(FILE *out, struct bench_t *bench, struct data_t *matrix_data, double density, long seed)
+{
+        int i;
+        int j;
+        char what[64];
+        struct data_t data = *matrix_data; /* init_sim changes the engine for the plane */
+
+        bench->sim = make_sim(&data, matrix_data->rule);
+        if (!bench->sim) {
+                fprintf(stderr, "could not make a %dx%d board for %s\n", data.row_matrix, data.col_matrix, matrix_data->rule);
+                return;
+        }
+
+        srand48(seed);
+        bench->row = 0;
+        bench->col = 0;
+        for (i = 0; i < data.row_matrix; i++) {
+                for (j = 0; j < data.col_matrix; j++) {
+                        if (drand48() < density) {
+                                put_cell(bench, i, j);
+                        }
+                }
+        }
+        sim_file_rule(bench->sim, ""); /* packs it or marks it active the same way a load does */
+
+        snprintf(what, sizeof(what), "%g", density);
+        run_case(out, bench, "density", what, 0);
+        free_sim(bench->sim);
+}
+
+/**
+ * runs one pattern case, the pattern is put in the middle of the board
+ * @param *out the file the JSON goes to
+ * @param *bench the case, its sim is made here
+ * @param *matrix_data the size, edge, engine and threads of the case
+ * @param *pattern the pattern, already loaded
+ * @param *name the file name of the pattern
+ */
+static void pattern_case(FILE *out, struct bench_t *bench, struct data_t *matrix_data, struct pattern_t *pattern, const char *name)
+{
+        struct data_t data = *matrix_data;
+
+        bench->sim = make_sim(&data, matrix_data->rule);
+        if (!bench->sim) {
+                fprintf(stderr, "could not make a %dx%d board for %s\n", data.row_matrix, data.col_matrix, name);
+                return;
+        }
+
+        bench->row = data.row_matrix / 2 - (pattern->min_row + pattern->max_row) / 2;
+        bench->col = data.col_matrix / 2 - (pattern->min_col + pattern->max_col) / 2;
+        pattern_cells(pattern, put_cell, bench);
+        sim_file_rule(bench->sim, pattern->rule);
+
+        run_case(out, bench, "pattern", name, 1);
+        free_sim(bench->sim);
+}
+
+int main(int argc, char *argv[])
+{
+        int a;
+        int b;
+        int c;
+        int e;
+        int t;
+        int sizes = 3;
+        int densities = 2;
+        int edges = 5;
+        int engines = 3;
+        int threads = 1;
+        int online = sysconf(_SC_NPROCESSORS_ONLN);
+        double size[BENCH_MOST] = { 256, 1024, 4096 };
+        double density[BENCH_MOST] = { 0.05, 0.35 };
+        double thread[BENCH_MOST] = { 1 };
+        int edge[BENCH_MOST] = { EDGE_HEDGE, EDGE_TORUS, EDGE_KLEIN, EDGE_CROSS, EDGE_PLANE };
+        int engine[BENCH_MOST] = { ENGINE_BYTE, ENGINE_PACKED, ENGINE_ACTIVE };
+        int pattern_size = 1024;
+        long seed = 1;
+        char *dirpath = "Conway_Life/";
+        char *outpath = NULL;
+        char path[SIZE];
+        const char *kernel;
+        struct bench_t bench = { NULL, 0, 0, 0.25, 1 };
+        struct pattern_t pattern;
+        struct rule_t rule;
+        struct rusage usage;
+        struct dirent *entry;
+        DIR *dir;
+        FILE *out = stdout;
+        struct data_t *matrix_data = malloc(sizeof(struct data_t));
+
+        if (!matrix_data) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        init_struct(matrix_data);
+        kernel = select_kernel();
+
+        if (online > 1) {
+                thread[threads++] = online;
+        }
+
+        /*procsses all of the arguments */
+        while ((c = getopt(argc, argv, ":s:d:e:m:j:b:t:p:P:S:O:u:H")) != -1) {
+                        switch (c) {
+                        case 's':
+                                sizes = read_numbers(optarg, size);
+                                break; /* each size is the rows and the cols of a square board */
+                        case 'd':
+                                densities = read_numbers(optarg, density);
+                                break;
+                        case 'e':
+                                edges = read_names(optarg, edge_names, 6, edge);
+                                if (edges == -1) {
+                                        fprintf(stderr, "%s: argument to option '-e' is not a list of edges\n", argv[0]);
+                                        exit(1);
+                                }
+                                break;
+                        case 'm':
+                                engines = read_names(optarg, engine_names, 4, engine);
+                                if (engines == -1) {
+                                        fprintf(stderr, "%s: argument to option '-m' is not a list of engines\n", argv[0]);
+                                        exit(1);
+                                }
+                                break;
+                        case 'b':
+                                matrix_data->depth = atoi(optarg);
+
+                                if (matrix_data->depth < 1 || matrix_data->depth > TEMPORAL_MAX_DEPTH) {
+                                        printf("Depth must be from 1 to %d\nResetting to default\n", TEMPORAL_MAX_DEPTH);
+                                        matrix_data->depth = 1;
+                                }
+                                break;
+                        case 'j':
+                                threads = read_numbers(optarg, thread);
+                                break;
+                        case 't':
+                                bench.seconds = atof(optarg);
+                                break;
+                        case 'p':
+                                dirpath = optarg;
+                                break;
+                        case 'P':
+                                pattern_size = atoi(optarg);
+                                break;
+                        case 'S':
+                                seed = atol(optarg);
+                                break;
+                        case 'O':
+                                outpath = optarg;
+                                break;
+                        case 'u':
+                                if (parse_rule(optarg, &rule) == -1) {
+                                        fprintf(stderr, "%s: argument to option '-u' is not a rule\n", argv[0]);
+                                        exit(1);
+                                }
+                                strcpy(matrix_data->rule, rule.text);
+                                matrix_data->rule_given = 1;
+                                break;
+                        case 'H':
+                                printf("Usage: \n./life_bench -s sizes -d densities -e edges -m engines -j threads -b depth -t seconds");
+                                printf(" -p directory -P size -S seed -O output -u rule -H help\n");
+                                printf("every list is comma separated with no spaces, every combination of them is a case\n");
+                                printf("s: sizes of the square boards the soups are put on, 256,1024,4096 by default\n");
+                                printf("d: densities of the soups, 0.05,0.35 by default\n");
+                                printf("e: edges, any of hedge, torus, klein, cross and plane, all of them by default\n");
+                                printf("m: engines, any of byte, packed and active, the plane always uses sparse, byte,packed,active by default\n");
+                                printf("j: thread counts, 1 and the number of cores by default\n");
+                                printf("b: generations the byte engine steps for every pass over the board on the torus and hedge, 1 by default\n");
+                                printf("t: seconds to step each case for, 0.25 by default\n");
+                                printf("p: directory of patterns to run on top of the soups, Conway_Life/ by default, skipped if it is not there\n");
+                                printf("P: size of the square board the patterns are put on, 1024 by default\n");
+                                printf("S: seed for the soups, 1 by default\n");
+                                printf("O: file to write the JSON to instead of stdout\n");
+                                printf("u: rule to step with, in any notation -u takes in life_batch\n");
+                                printf("H: help menu display\n");
+                                exit(1);
+                                break;
+                        case ':':
+                                fprintf(stderr, "%s: option '-%c' requires an argument\n", argv[0], optopt);
+                                exit(1); /*error processing */
+                        case '?':
+                        default:
+                                printf("Illegal option %c - ignored\n", optopt);
+                                break;
+                        }
+        }
+
+        if (outpath) {
+                errno = 0;
+                out = fopen(outpath, "w");
+
+                if (!out) {
+                        fprintf(stderr, "%s: argument to option '-O' failed: %s\n", argv[0], strerror(errno));
+                        exit(1);
+                }
+        }
+
+        fprintf(out, "{\n  \"kernel\": \"%s\",\n  \"rule\": \"%s\",\n  \"cores\": %d,\n  \"seed\": %ld,\n  \"results\": [",
+                        kernel, matrix_data->rule, online, seed);
+
+        /* the plane has no engine or threads to pick, it gets one case for each board */
+        for (e = 0; e < edges; e++) {
+                for (b = 0; b < engines; b++) {
+                        for (t = 0; t < threads; t++) {
+                                if (edge[e] == EDGE_PLANE && (b > 0 || t > 0)) {
+                                        continue;
+                                }
+
+                                matrix_data->edge = edge[e];
+                                matrix_data->engine = engine[b];
+                                matrix_data->threads = (thread[t] < 1) ? 1 : thread[t];
+
+                                for (a = 0; a < sizes; a++) {
+                                        for (c = 0; c < densities; c++) {
+                                                matrix_data->row_matrix = size[a];
+                                                matrix_data->col_matrix = size[a];
+                                                soup_case(out, &bench, matrix_data, density[c], seed);
+                                        }
+                                }
+
+                                dir = opendir(dirpath);
+                                while (dir && (entry = readdir(dir))) {
+                                        if (snprintf(path, SIZE, "%s/%s", dirpath, entry->d_name) >= SIZE
+                                                        || entry->d_name[0] == '.' || load_pattern(path, &pattern) == -1) {
+                                                continue;
+                                        }
+
+                                        matrix_data->row_matrix = pattern_size;
+                                        matrix_data->col_matrix = pattern_size;
+                                        pattern_case(out, &bench, matrix_data, &pattern, entry->d_name);
+                                        free_pattern(&pattern);
+                                }
+
+                                if (dir) {
+                                        closedir(dir);
+                                }
+                        }
+                }
+        }
+
+        getrusage(RUSAGE_SELF, &usage);
+        fprintf(out, "\n  ],\n  \"peak_kilobytes\": %ld\n}\n", usage.ru_maxrss);
+
+        if (outpath) {
+                fclose(out);
+        }
+
+        free(matrix_data);
+        return 0;
+}
@@ -0,0 +1,410 @@
+#include "census.h"
+
+/**
+ * @file census.c
+ * @breif Counts the objects on a board by kind, for recording what a soup settled into
+ * @details An object is a group of alive cells that touch, sides or corners, followed around the torus when the board is one. A board that settled into a short period is stepped through it first and an object is a group that touches in any phase, so an oscillator whose parts only touch in some phases, like a beacon, is still one object, and it is named by whichever of its phases has a name. Each object is turned and flipped all 8 ways and the way that compares lowest is kept, so a blinker standing up and one lying down count as the same kind. The common still lifes, oscillators and the glider have names, both shapes of the ones whose phases are not turns of each other, anything else is named by its population and its rows in hex. Objects bigger than CENSUS_SIDE across are only named by population.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* the objects with a name, in rows of . and O split by / */
+static struct {
+        const char *name;
+        const char *cells;
+        struct shape_t shape;
+} known[] = {
+        { "block", "OO/OO" },
+        { "blinker", "OOO" },
+        { "beehive", ".OO./O..O/.OO." },
+        { "loaf", ".OO./O..O/.O.O/..O." },
+        { "boat", "OO./O.O/.O." },
+        { "ship", "OO./O.O/.OO" },
+        { "tub", ".O./O.O/.O." },
+        { "pond", ".OO./O..O/O..O/.OO." },
+        { "longboat", "OO../O.O./.O.O/..O." },
+        { "barge", ".O../O.O./.O.O/..O." },
+        { "mango", ".OO../O..O./.O..O/..OO." },
+        { "carrier", "OO../O..O/..OO" },
+        { "snake", "OO.O/O.OO" },
+        { "eater", "OO../O.O./..O./..OO" },
+        { "glider", ".O./..O/OOO" },
+        { "glider", "O.O/.OO/.O." },
+        { "toad", ".OOO/OOO." },
+        { "toad", "..O./O..O/O..O/.O.." },
+        { "beacon", "OO../O.../...O/..OO" },
+        { "beacon", "OO../OO../..OO/..OO" },
+};
+
+#define KNOWN (int)(sizeof(known) / sizeof(known[0]))
+
+/**
+ * compares two shapes, first by size and then a row at a time
+ * @param *a the first shape
+ * @param *b the second shape
+ * @return less than 0 if a is lower, 0 if they are the same, more than 0 if b is lower
+ */
+static int compare_shapes(const struct shape_t *a, const struct shape_t *b)
+{
+        int i;
+
+        if (a->rows != b->rows) {
+                return a->rows - b->rows;
+        }
+        if (a->cols != b->cols) {
+                return a->cols - b->cols;
+        }
+
+        for (i = 0; i < a->rows; i++) {
+                if (a->bits[i] != b->bits[i]) {
+                        return (a->bits[i] < b->bits[i]) ? -1 : 1;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * works out the shape of an object, the lowest of its 8 turns and flips
+ * @param *cells the row and col of every cell, two ints each, from anywhere on the board
+ * @param count how many cells
+ * @param *shape set to the shape
+ * @return 0, or -1 if the object is more than CENSUS_SIDE across
+ */
+static int find_shape(const int *cells, int count, struct shape_t *shape)
+{
+        int n;
+        int t;
+        int r;
+        int c;
+        int top = cells[0];
+        int left = cells[1];
+        int height;
+        int width;
+        struct shape_t turned;
+
+        for (n = 0; n < count; n++) {
+                top = (cells[2 * n] < top) ? cells[2 * n] : top;
+                left = (cells[2 * n + 1] < left) ? cells[2 * n + 1] : left;
+        }
+
+        height = 0;
+        width = 0;
+        for (n = 0; n < count; n++) {
+                height = (cells[2 * n] - top + 1 > height) ? cells[2 * n] - top + 1 : height;
+                width = (cells[2 * n + 1] - left + 1 > width) ? cells[2 * n + 1] - left + 1 : width;
+        }
+
+        if (height > CENSUS_SIDE || width > CENSUS_SIDE) {
+                return -1;
+        }
+
+        /* bit 0 flips it top to bottom, bit 1 left to right and bit 2 swaps the rows and cols */
+        for (t = 0; t < 8; t++) {
+                turned.rows = (t & 4) ? width : height;
+                turned.cols = (t & 4) ? height : width;
+                memset(turned.bits, 0, sizeof(turned.bits));
+
+                for (n = 0; n < count; n++) {
+                        r = cells[2 * n] - top;
+                        c = cells[2 * n + 1] - left;
+                        r = (t & 1) ? height - 1 - r : r;
+                        c = (t & 2) ? width - 1 - c : c;
+                        if (t & 4) {
+                                turned.bits[c] |= 1ULL << r;
+                        } else {
+                                turned.bits[r] |= 1ULL << c;
+                        }
+                }
+
+                if (t == 0 || compare_shapes(&turned, shape) < 0) {
+                        *shape = turned;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * works out the shapes of the objects with names, before any census is taken
+ */
+void init_census(void)
+{
+        int i;
+        int n;
+        int r;
+        int c;
+        int cells[2 * CENSUS_SIDE];
+        const char *at;
+
+        for (i = 0; i < KNOWN; i++) {
+                n = 0;
+                r = 0;
+                c = 0;
+                for (at = known[i].cells; *at; at++) {
+                        if (*at == '/') {
+                                r++;
+                                c = 0;
+                                continue;
+                        }
+                        if (*at == 'O') {
+                                cells[2 * n] = r;
+                                cells[2 * n + 1] = c;
+                                n++;
+                        }
+                        c++;
+                }
+                find_shape(cells, n, &known[i].shape);
+        }
+}
+
+/**
+ * names an object from its cells in every phase, by the first phase that has a name, otherwise by the
+ * lowest shape of them all so an oscillator gets the same name whichever phase it was caught in
+ * @param *alive the phases of the board, cell i, j of phase p is alive[(p * rows + i) * cols + j]
+ * @param phases how many phases there are
+ * @param rows the rows of the board
+ * @param cols the cols of the board
+ * @param *cells the row and col of every cell alive in any phase, two ints each, from where it started
+ * @param count how many cells
+ * @param *scratch room for count cells
+ * @param *name where the name goes, CENSUS_NAME chars
+ */
+static void name_object(const unsigned char *alive, int phases, int rows, int cols, const int *cells, int count, int *scratch, char *name)
+{
+        int i;
+        int n;
+        int p;
+        int r;
+        int c;
+        int used;
+        int population = 0;
+        int big = 0;
+        struct shape_t shape;
+        struct shape_t lowest = { 0, 0, { 0 } };
+
+        for (p = 0; p < phases; p++) {
+                n = 0;
+                for (i = 0; i < count; i++) {
+                        r = ((cells[2 * i] % rows) + rows) % rows;
+                        c = ((cells[2 * i + 1] % cols) + cols) % cols;
+                        if (alive[((size_t)p * rows + r) * cols + c]) {
+                                scratch[2 * n] = cells[2 * i];
+                                scratch[2 * n + 1] = cells[2 * i + 1];
+                                n++;
+                        }
+                }
+
+                if (n == 0) {
+                        continue;
+                }
+                if (find_shape(scratch, n, &shape) == -1) {
+                        big = (n > big) ? n : big;
+                        continue;
+                }
+
+                for (i = 0; i < KNOWN; i++) {
+                        if (compare_shapes(&shape, &known[i].shape) == 0) {
+                                snprintf(name, CENSUS_NAME, "%s", known[i].name);
+                                return;
+                        }
+                }
+
+                if (population == 0 || compare_shapes(&shape, &lowest) < 0) {
+                        lowest = shape;
+                        population = n;
+                }
+        }
+
+        if (population == 0) {
+                snprintf(name, CENSUS_NAME, "big%d", big);
+                return;
+        }
+
+        /* its population and its rows, the ones too long to fit are cut off */
+        used = snprintf(name, CENSUS_NAME, "x%d_", population);
+        for (i = 0; i < lowest.rows && used < CENSUS_NAME - 1; i++) {
+                used += snprintf(name + used, CENSUS_NAME - used, (i == 0) ? "%llx" : ".%llx", (unsigned long long)lowest.bits[i]);
+        }
+}
+
+/**
+ * puts every phase of a board in alive, stepping a copy of it with the rule every engine steps with
+ * @param *grid the board
+ * @param edge the edge of the board
+ * @param phases how many phases
+ * @param *alive filled the way name_object reads it
+ * @return 0, or -1 if an allocation failed
+ */
+static int find_phases(struct grid_t *grid, int edge, int phases, unsigned char *alive)
+{
+        int i;
+        int j;
+        int p;
+        struct grid_t *here = grid;
+        struct grid_t *next[2] = { NULL, NULL };
+
+        if (phases > 1) {
+                next[0] = init_grid(grid->rows, grid->cols);
+                next[1] = init_grid(grid->rows, grid->cols);
+
+                if (!next[0] || !next[1]) {
+                        if (next[0]) {
+                                free_grid(next[0]);
+                        }
+                        if (next[1]) {
+                                free_grid(next[1]);
+                        }
+                        return -1;
+                }
+        }
+
+        for (p = 0; p < phases; p++) {
+                if (p > 0) {
+                        /* here is the board or a copy and never the grid it is stepped into */
+                        fill_ghost(here, edge);
+                        step_rows(here, next[p % 2], 0, grid->rows);
+                        here = next[p % 2];
+                }
+
+                for (i = 0; i < grid->rows; i++) {
+                        for (j = 0; j < grid->cols; j++) {
+                                alive[((size_t)p * grid->rows + i) * grid->cols + j] = here->cell[i][j] == 1;
+                        }
+                }
+        }
+
+        if (phases > 1) {
+                free_grid(next[0]);
+                free_grid(next[1]);
+        }
+
+        return 0;
+}
+
+/**
+ * counts the objects on a board by kind. With a short period the phases are put together first and an
+ * object is the cells that touch in any of them, so the halves of a beacon, which only touch every other
+ * generation, are one object
+ * @param *grid the board, cells that are 1 are alive, it is not changed
+ * @param edge the edge of the board, objects are followed around the torus and stop at anything else
+ * @param period the period the board settled into, 0 or more than CENSUS_PHASES to only look at it as it is
+ * @param *text set to the kinds and how many of each, like "block 3 blinker 2", empty if there is nothing
+ * @param size the room in text
+ * @return how many objects there are, or -1 if an allocation failed
+ */
+int census_board(struct grid_t *grid, int edge, long long period, char *text, size_t size)
+{
+        int i;
+        int j;
+        int k;
+        int p;
+        int r;
+        int c;
+        int dr;
+        int dc;
+        int head;
+        int tail;
+        int objects = 0;
+        int kinds = 0;
+        int other = 0;
+        int used = 0;
+        int rows = grid->rows;
+        int cols = grid->cols;
+        int phases = (period > 1 && period <= CENSUS_PHASES) ? period : 1;
+        size_t area = (size_t)rows * cols;
+        char name[CENSUS_NAME];
+        char names[CENSUS_KINDS][CENSUS_NAME];
+        int counts[CENSUS_KINDS];
+        unsigned char *alive = malloc(area * phases);
+        unsigned char *any = calloc(area, 1); /* alive in any phase, cleared as the objects are followed */
+        int *cells = malloc(sizeof(int) * 2 * area); /* the cells of the object being followed, from where it started */
+        int *scratch = malloc(sizeof(int) * 2 * area);
+
+        text[0] = '\0';
+
+        if (!alive || !any || !cells || !scratch || find_phases(grid, edge, phases, alive) == -1) {
+                printf("Malloc failed\n");
+                free(alive);
+                free(any);
+                free(cells);
+                free(scratch);
+                return -1;
+        }
+
+        for (p = 0; p < phases; p++) {
+                for (i = 0; i < (int)area; i++) {
+                        any[i] |= alive[p * area + i];
+                }
+        }
+
+        for (i = 0; i < rows; i++) {
+                for (j = 0; j < cols; j++) {
+                        if (!any[(size_t)i * cols + j]) {
+                                continue;
+                        }
+
+                        /* follow the object out from this cell, the list of its cells is the queue */
+                        any[(size_t)i * cols + j] = 0;
+                        cells[0] = i;
+                        cells[1] = j;
+                        head = 0;
+                        tail = 1;
+
+                        while (head < tail) {
+                                for (dr = -1; dr <= 1; dr++) {
+                                        for (dc = -1; dc <= 1; dc++) {
+                                                r = cells[2 * head] + dr;
+                                                c = cells[2 * head + 1] + dc;
+
+                                                if (edge == EDGE_TORUS) {
+                                                        r = ((r % rows) + rows) % rows;
+                                                        c = ((c % cols) + cols) % cols;
+                                                } else if (r < 0 || r >= rows || c < 0 || c >= cols) {
+                                                        continue;
+                                                }
+
+                                                if (any[(size_t)r * cols + c]) {
+                                                        any[(size_t)r * cols + c] = 0;
+                                                        /* kept where it is next to the cell it was found from, not where it wrapped to */
+                                                        cells[2 * tail] = cells[2 * head] + dr;
+                                                        cells[2 * tail + 1] = cells[2 * head + 1] + dc;
+                                                        tail++;
+                                                }
+                                        }
+                                }
+                                head++;
+                        }
+
+                        name_object(alive, phases, rows, cols, cells, tail, scratch, name);
+                        objects++;
+
+                        for (k = 0; k < kinds && strcmp(names[k], name) != 0; k++) {
+                        }
+
+                        if (k < kinds) {
+                                counts[k]++;
+                        } else if (kinds < CENSUS_KINDS) {
+                                strcpy(names[kinds], name);
+                                counts[kinds++] = 1;
+                        } else {
+                                other++;
+                        }
+                }
+        }
+
+        for (k = 0; k < kinds && used >= 0 && (size_t)used < size; k++) {
+                used += snprintf(text + used, size - used, (k == 0) ? "%s %d" : " %s %d", names[k], counts[k]);
+        }
+        if (other > 0 && used >= 0 && (size_t)used < size) {
+                snprintf(text + used, size - used, " other %d", other);
+        }
+
+        free(alive);
+        free(any);
+        free(cells);
+        free(scratch);
+
+        return objects;
+}
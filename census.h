@@ -0,0 +1,35 @@
+#include "life.h"
+
+/**
+ * @file census.h
+ * @breif headers for counting the objects a board settled into, in census.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef CENSUS_H_
+#define CENSUS_H_
+
+/* the widest and tallest object told apart by its shape, bigger ones are only counted by population */
+#define CENSUS_SIDE 64
+/* the kinds of object one census keeps apart, any more are counted together as other */
+#define CENSUS_KINDS 32
+/* the longest period whose phases are put together into objects, a longer one like a glider going around the torus is taken as it is */
+#define CENSUS_PHASES 16
+/* room for the name of one kind */
+#define CENSUS_NAME 48
+
+/* an object turned and flipped into the one way of all 8 that compares lowest, so every
+ * orientation of the same object ends up the same. Bit c of bits[r] is the cell at r, c */
+struct shape_t {
+        int rows;
+        int cols;
+        uint64_t bits[CENSUS_SIDE];
+};
+
+void init_census(void);
+
+int census_board(struct grid_t *grid, int edge, long long period, char *text, size_t size);
+
+#endif
@@ -0,0 +1,364 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+
+/**
+ * @file checkpoint.c
+ * @breif Saves the board of a sim to a binary file and puts it back, so a long run can pick up where it stopped
+ * @details A checkpoint is a fixed size header with the size, edge, rule and generation of the board followed by the cells one bit each, or one byte each for a rule with more than two states. A board with an edge is saved a row at a time in 64 bit words, the infinite plane is saved as its chunks with their coordinates. The file is written next to where it goes and renamed over it, so a run killed part way through a save still has the checkpoint before it. Loading maps the file and unpacks the bits straight out of the mapping.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * writes the rows of a grid one bit a cell
+ * @param *file the file to write to
+ * @param *grid the grid to write
+ * @param words the words in each row
+ * @return 0, or -1 if a write failed
+ */
+static int write_grid(FILE *file, struct grid_t *grid, int words)
+{
+        int i;
+        int j;
+        uint64_t *row = calloc(words, sizeof(uint64_t));
+
+        if (!row) {
+                printf("Malloc failed\n");
+                return -1;
+        }
+
+        for (i = 0; i < grid->rows; i++) {
+                memset(row, 0, sizeof(uint64_t) * words);
+
+                for (j = 0; j < grid->cols; j++) {
+                        row[j / 64] |= (uint64_t)(grid->cell[i][j] & 1) << (j % 64);
+                }
+
+                if (fwrite(row, sizeof(uint64_t), words, file) != (size_t)words) {
+                        free(row);
+                        return -1;
+                }
+        }
+
+        free(row);
+        return 0;
+}
+
+/**
+ * writes the rows of a packed board one bit a cell, without the ghost bits
+ * @param *file the file to write to
+ * @param *packed the board to write
+ * @param words the words in each row
+ * @return 0, or -1 if a write failed
+ */
+static int write_packed(FILE *file, struct packed_t *packed, int words)
+{
+        int i;
+        int w;
+        const uint64_t *from;
+        uint64_t *row = calloc(words, sizeof(uint64_t));
+
+        if (!row) {
+                printf("Malloc failed\n");
+                return -1;
+        }
+
+        for (i = 0; i < packed->rows; i++) {
+                from = PACKED_ROW(packed, i);
+
+                for (w = 0; w < words; w++) { /* col j is at bit j + 1 of the board and bit j of the file */
+                        row[w] = (from[w] >> 1) | ((w + 1 < packed->words) ? from[w + 1] << 63 : 0);
+                }
+                if (packed->cols % 64 != 0) {
+                        row[words - 1] &= (1ULL << (packed->cols % 64)) - 1;
+                }
+
+                if (fwrite(row, sizeof(uint64_t), words, file) != (size_t)words) {
+                        free(row);
+                        return -1;
+                }
+        }
+
+        free(row);
+        return 0;
+}
+
+/**
+ * writes the rows of a grid one byte a cell, padded out to whole words
+ * @param *file the file to write to
+ * @param *grid the grid to write
+ * @param words the words in each row
+ * @return 0, or -1 if a write failed
+ */
+static int write_grid_bytes(FILE *file, struct grid_t *grid, int words)
+{
+        int i;
+        uint64_t *row = calloc(words, sizeof(uint64_t));
+
+        if (!row) {
+                printf("Malloc failed\n");
+                return -1;
+        }
+
+        for (i = 0; i < grid->rows; i++) {
+                memcpy(row, grid->cell[i], grid->cols);
+
+                if (fwrite(row, sizeof(uint64_t), words, file) != (size_t)words) {
+                        free(row);
+                        return -1;
+                }
+        }
+
+        free(row);
+        return 0;
+}
+
+/**
+ * writes every chunk of the plane that has an alive cell
+ * @param *file the file to write to
+ * @param *sparse the plane
+ * @param *count set to the number of chunks written
+ * @return 0, or -1 if a write failed
+ */
+static int write_chunks(FILE *file, struct sparse_t *sparse, uint64_t *count)
+{
+        int i;
+        int alive;
+        size_t n;
+        struct chunk_record_t record;
+
+        *count = 0;
+        for (n = 0; n < sparse->count; n++) {
+                alive = 0;
+                for (i = 0; i < CHUNK_SIZE; i++) {
+                        record.cells[i] = sparse->list[n]->cells[i];
+                        alive |= record.cells[i] != 0;
+                }
+
+                if (!alive) {
+                        continue;
+                }
+
+                record.row = sparse->list[n]->row;
+                record.col = sparse->list[n]->col;
+
+                if (fwrite(&record, sizeof(struct chunk_record_t), 1, file) != 1) {
+                        return -1;
+                }
+                (*count)++;
+        }
+
+        return 0;
+}
+
+/**
+ * copies rows of cells one bit each from a checkpoint onto a packed board
+ * @param *packed the board to fill
+ * @param *row the first row in the checkpoint
+ * @param words the words in each row of the checkpoint
+ */
+static void read_packed(struct packed_t *packed, const uint64_t *row, int words)
+{
+        int i;
+        int w;
+        uint64_t *to;
+
+        for (i = 0; i < packed->rows; i++, row += words) {
+                to = PACKED_ROW(packed, i);
+
+                for (w = 0; w < packed->words; w++) {
+                        to[w] = ((w < words) ? row[w] << 1 : 0) | ((w > 0) ? row[w - 1] >> 63 : 0);
+                }
+        }
+}
+
+/**
+ * saves the current board of a sim
+ * @param *sim the sim
+ * @param *filepath the file to save to, replaced whole once the save is done
+ * @return 0 on success, -1 if the file could not be written
+ */
+int save_checkpoint(struct sim_t *sim, char *filepath)
+{
+        char temp[SIZE];
+        int result;
+        FILE *file;
+        struct checkpoint_t header;
+
+        if (snprintf(temp, SIZE, "%s.tmp", filepath) >= SIZE) {
+                return -1;
+        }
+
+        file = fopen(temp, "wb");
+        if (!file) {
+                return -1;
+        }
+
+        memset(&header, 0, sizeof(struct checkpoint_t));
+        memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.version = CHECKPOINT_VERSION;
+        header.rows = sim->matrix_data->row_matrix;
+        header.cols = sim->matrix_data->col_matrix;
+        header.edge = sim->matrix_data->edge;
+        header.generation = sim->generation;
+        strcpy(header.rule, get_rule()->text);
+
+        if (sim->sparse) {
+                header.layout = CHECKPOINT_CHUNKS;
+                header.words = CHUNK_SIZE;
+        } else if (get_rule()->states > 2) {
+                header.layout = CHECKPOINT_BYTES;
+                header.words = (header.cols + 7) / 8;
+                header.count = header.rows;
+        } else {
+                header.layout = CHECKPOINT_GRID;
+                header.words = (header.cols + 63) / 64;
+                header.count = header.rows;
+        }
+
+        /* the header goes first to save the room, the chunk count is only known after the chunks */
+        result = fwrite(&header, sizeof(struct checkpoint_t), 1, file) == 1 ? 0 : -1;
+
+        if (result == 0 && sim->sparse) {
+                result = write_chunks(file, sim->sparse, &header.count);
+                if (result == 0) {
+                        rewind(file);
+                        result = fwrite(&header, sizeof(struct checkpoint_t), 1, file) == 1 ? 0 : -1;
+                }
+        } else if (result == 0 && header.layout == CHECKPOINT_BYTES) {
+                result = write_grid_bytes(file, sim_view(sim), header.words);
+        } else if (result == 0 && sim->packed[0]) {
+                result = write_packed(file, sim->packed[sim->cur], header.words); /* no unpacking, a mapped board has no grid */
+        } else if (result == 0) {
+                result = write_grid(file, sim_view(sim), header.words);
+        }
+
+        if (fclose(file) != 0 || result == -1) {
+                remove(temp);
+                return -1;
+        }
+
+        return rename(temp, filepath);
+}
+
+/**
+ * reads just the header of a checkpoint, so a sim of the right size can be made for it
+ * @param *filepath the checkpoint
+ * @param *header set to the header
+ * @return 0 on success, -1 if the file could not be read, is not a checkpoint or is on an edge this build does not know
+ */
+int read_checkpoint(char *filepath, struct checkpoint_t *header)
+{
+        FILE *file = fopen(filepath, "rb");
+        size_t read;
+
+        if (!file) {
+                return -1;
+        }
+
+        read = fread(header, sizeof(struct checkpoint_t), 1, file);
+        fclose(file);
+
+        /* the callers size the sim from the header, so an edge this build does not know is turned away here */
+        if (read != 1 || memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0
+                        || header->version != CHECKPOINT_VERSION || header->edge < EDGE_HEDGE || header->edge > EDGE_CROSS) {
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * puts the board from a checkpoint into a sim and steps it with the rule it was saved with, unless the user picked one
+ * @param *sim a sim made for the size and edge in the checkpoint header, still empty
+ * @param *filepath the checkpoint
+ * @return 0 on success, -1 if the file could not be read or does not fit the sim
+ */
+int load_checkpoint(struct sim_t *sim, char *filepath)
+{
+        int fd;
+        int i;
+        int j;
+        int per_word; /* cells in each word of a row */
+        uint64_t n;
+        size_t size;
+        struct stat info;
+        const struct checkpoint_t *header;
+        const uint64_t *row;
+        const struct chunk_record_t *record;
+        struct grid_t *grid = sim->grid[0]; /* NULL for a mapped board, which is read straight into its bits */
+        int rows = sim->matrix_data->row_matrix;
+        int cols = sim->matrix_data->col_matrix;
+        char rule[RULE_SIZE];
+        void *map;
+
+        fd = open(filepath, O_RDONLY);
+        if (fd == -1) {
+                return -1;
+        }
+
+        if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(struct checkpoint_t)) {
+                close(fd);
+                return -1;
+        }
+
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (map == MAP_FAILED) {
+                return -1;
+        }
+
+        header = map;
+        size = (header->layout == CHECKPOINT_CHUNKS) ? sizeof(struct chunk_record_t) : sizeof(uint64_t) * header->words;
+        per_word = (header->layout == CHECKPOINT_BYTES) ? 8 : 64;
+
+        /* the file has to be a checkpoint in a layout and on an edge this build knows, be for a board like this one and hold all
+         * the cells it says it does. The rows are only sized once words is known to be right, so size is never 0 */
+        if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0 || header->version != CHECKPOINT_VERSION
+                        || header->edge < EDGE_HEDGE || header->edge > EDGE_CROSS
+                        || (header->layout != CHECKPOINT_GRID && header->layout != CHECKPOINT_CHUNKS && header->layout != CHECKPOINT_BYTES)
+                        || (header->layout == CHECKPOINT_CHUNKS) != (sim->sparse != NULL)
+                        || (!sim->sparse && (header->rows != rows || header->cols != cols || header->words == 0
+                                        || header->words != (cols + per_word - 1) / per_word || header->count != (uint64_t)rows))
+                        || (sim->mapped && header->layout == CHECKPOINT_BYTES)
+                        || header->count > (info.st_size - sizeof(struct checkpoint_t)) / size) {
+                munmap(map, info.st_size);
+                return -1;
+        }
+
+        if (sim->sparse) {
+                record = (const struct chunk_record_t *)(header + 1);
+                for (n = 0; n < header->count; n++) {
+                        sparse_set_chunk(sim->sparse, record[n].row, record[n].col, record[n].cells);
+                }
+                sim->sparse->generation = header->generation;
+        } else if (sim->mapped) {
+                read_packed(sim->packed[sim->cur], (const uint64_t *)(header + 1), header->words);
+        } else if (header->layout == CHECKPOINT_BYTES) {
+                row = (const uint64_t *)(header + 1);
+                for (i = 0; i < grid->rows; i++, row += header->words) {
+                        memcpy(grid->cell[i], row, grid->cols); /* states the rule does not have are fixed by sim_file_rule */
+                }
+        } else {
+                row = (const uint64_t *)(header + 1);
+                for (i = 0; i < grid->rows; i++, row += header->words) {
+                        for (j = 0; j < grid->cols; j++) {
+                                grid->cell[i][j] = row[j / 64] >> (j % 64) & 1;
+                        }
+                }
+        }
+
+        sim->generation = header->generation;
+        memcpy(rule, header->rule, RULE_SIZE);
+        rule[RULE_SIZE - 1] = '\0';
+        munmap(map, info.st_size);
+
+        sim_file_rule(sim, rule); /* carrying on with another rule is only done when the user asks for it */
+
+        return 0;
+}
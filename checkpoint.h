@@ -0,0 +1,51 @@
+#include <stdint.h>
+#include "sim.h"
+
+/**
+ * @file checkpoint.h
+ * @breif headers for saving a running board to a file and picking it back up, in checkpoint.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#define CHECKPOINT_MAGIC "LIFECKP1"
+#define CHECKPOINT_VERSION 1
+/* how the cells after the header are laid out */
+#define CHECKPOINT_GRID 1 /* count rows of words words each, bit j % 64 of word j / 64 is col j */
+#define CHECKPOINT_CHUNKS 2 /* count chunk_record_t, every chunk of the plane with an alive cell */
+#define CHECKPOINT_BYTES 3 /* count rows of words words each, byte j is the state of col j, for rules with more than two states */
+
+/* the start of every checkpoint file, 128 bytes so the cells after it stay lined up for mmap.
+ * everything is in the byte order of the machine that wrote it */
+struct checkpoint_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t layout;
+        int32_t rows;
+        int32_t cols;
+        int32_t edge;
+        int32_t words;
+        uint64_t generation;
+        uint64_t count;
+        char rule[RULE_SIZE];
+        char pad[16];
+};
+
+/* one chunk of the plane as it is saved */
+struct chunk_record_t {
+        int64_t row;
+        int64_t col;
+        uint64_t cells[CHUNK_SIZE];
+};
+
+int save_checkpoint(struct sim_t *sim, char *filepath);
+
+int read_checkpoint(char *filepath, struct checkpoint_t *header);
+
+int load_checkpoint(struct sim_t *sim, char *filepath);
+
+#endif
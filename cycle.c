@@ -0,0 +1,386 @@
+#include "cycle.h"
+
+/**
+ * @file cycle.c
+ * @breif finds when a run dies out, stops changing or starts repeating, so the rest of it can be skipped
+ * @details Keeps a hash of the board, the hash_word of every word of cells XORed together, and brings it up to date after every generation from only the words that changed. Those are found the same way sim_changes finds the cells born and dead: by comparing both grids for the byte engine, the tiles that changed for the active engine and every word of the packed engine, while the plane keeps its hash itself as it steps. The hash and population of every generation go in a table with one entry per slot picked by the hash, so the table never grows and older generations are just written over. Finding the hash and population of the board already in the table means the board is what it was back then, and since each generation only depends on the one before, it repeats with that period from then on. Up to translation the plane is hashed from where its cells are inside the box around them instead, which costs a pass over the cells every generation but finds spaceships.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* the box around the cells of the plane and their hash inside it, while hashing up to translation */
+struct cycle_box_t {
+        long long row;
+        long long col;
+        uint64_t hash;
+        long long population;
+};
+
+/**
+ * Intilizes an empty history
+ * @param *cycle the history
+ * @param size entries in the table, rounded up to a power of 2
+ * @param moving 1 to match the plane up to translation, 0 to only match the same cells
+ * @return 0, or -1 if an allocation failed
+ */
+int init_cycle(struct cycle_t *cycle, size_t size, int moving)
+{
+        memset(cycle, 0, sizeof(struct cycle_t));
+
+        cycle->size = 1;
+        while (cycle->size < size) {
+                cycle->size *= 2;
+        }
+        cycle->moving = moving;
+        cycle->table = calloc(cycle->size, sizeof(struct cycle_entry_t));
+
+        if (!cycle->table) {
+                printf("Malloc failed\n");
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * frees what init_cycle set up
+ * @param *cycle the history
+ */
+void free_cycle(struct cycle_t *cycle)
+{
+        free(cycle->table);
+}
+
+/**
+ * counts the alive cells in a word of a byte grid, only state 1 is alive
+ * @param word 8 cells, one a byte
+ * @return how many of them are 1
+ */
+static inline int word_alive(uint64_t word)
+{
+        uint64_t x = word ^ 0x0101010101010101ULL; /* alive bytes are now 0 */
+        uint64_t zero = ~(((x & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | x | 0x7f7f7f7f7f7f7f7fULL);
+
+        return ((zero >> 7) * 0x0101010101010101ULL) >> 56; /* adds up the top bit of every byte */
+}
+
+/**
+ * reads 8 cells of a row of a byte grid as a word, past the last col is dead
+ * @param *row the first cell of the row
+ * @param k which 8 cells
+ * @param cols the cols on the grid
+ * @return the cells, one a byte
+ */
+static inline uint64_t grid_word(const unsigned char *row, int k, int cols)
+{
+        uint64_t word = 0;
+
+        memcpy(&word, row + k * 8, (cols - k * 8 < 8) ? cols - k * 8 : 8);
+        return word;
+}
+
+/**
+ * hashes a byte grid from nothing
+ * @param *cycle the history
+ * @param *grid the grid
+ */
+static void hash_grid_all(struct cycle_t *cycle, struct grid_t *grid)
+{
+        int i;
+        int k;
+        uint64_t now;
+        int words = (grid->cols + 7) / 8;
+
+        for (i = 0; i < grid->rows; i++) {
+                for (k = 0; k < words; k++) {
+                        now = grid_word(grid->cell[i], k, grid->cols);
+                        cycle->hash ^= hash_word(now, hash_key((uint64_t) i * words + k));
+                        cycle->population += word_alive(now);
+                }
+        }
+}
+
+/**
+ * brings the hash up to date for a block of a byte grid
+ * @param *cycle the history
+ * @param *grid the current generation
+ * @param *last the generation before
+ * @param first the first row of the block
+ * @param last_row one past the last row
+ * @param word the first word of 8 cells in each row
+ * @param last_word one past the last word
+ */
+static void hash_grid(struct cycle_t *cycle, struct grid_t *grid, struct grid_t *last, int first, int last_row, int word, int last_word)
+{
+        int i;
+        int k;
+        uint64_t now;
+        uint64_t before;
+        uint64_t key;
+        uint64_t hash = cycle->hash; /* kept in locals, the grids are chars and could alias the cycle */
+        long long population = cycle->population;
+        int words = (grid->cols + 7) / 8;
+        int whole = (grid->cols / 8 < last_word) ? grid->cols / 8 : last_word; /* words with all 8 cells on the grid */
+        const unsigned char *here;
+        const unsigned char *there;
+
+        for (i = first; i < last_row; i++) {
+                here = grid->cell[i];
+                there = last->cell[i];
+
+                for (k = word; k < last_word; k++) {
+                        if (k < whole) {
+                                memcpy(&now, here + k * 8, 8);
+                                memcpy(&before, there + k * 8, 8);
+                        } else {
+                                now = grid_word(here, k, grid->cols);
+                                before = grid_word(there, k, grid->cols);
+                        }
+
+                        if (now != before) {
+                                key = hash_key((uint64_t) i * words + k);
+                                hash ^= hash_word(before, key) ^ hash_word(now, key);
+                                population += word_alive(now) - word_alive(before);
+                        }
+                }
+        }
+
+        cycle->hash = hash;
+        cycle->population = population;
+}
+
+/**
+ * brings the hash up to date for a packed board
+ * @param *cycle the history
+ * @param *packed the current generation
+ * @param *last the generation before, NULL to hash the board from nothing
+ */
+static void hash_packed(struct cycle_t *cycle, struct packed_t *packed, struct packed_t *last)
+{
+        int i;
+        int w;
+        int top;
+        uint64_t mask;
+        uint64_t now;
+        uint64_t before;
+        uint64_t key;
+
+        for (i = 0; i < packed->rows; i++) {
+                for (w = 0; w < packed->words; w++) {
+                        /* only bits 1 to cols are cells, the rest are the ghost border and padding */
+                        top = packed->cols - w * 64;
+                        mask = (top >= 63) ? ~0ULL : (top < 0) ? 0 : (2ULL << top) - 1;
+                        mask &= (w == 0) ? ~1ULL : ~0ULL;
+                        now = PACKED_ROW(packed, i)[w] & mask;
+                        before = (last) ? PACKED_ROW(last, i)[w] & mask : 0;
+
+                        if (now != before) {
+                                key = hash_key((uint64_t) i * packed->words + w);
+                                cycle->hash ^= hash_word(before, key) ^ hash_word(now, key);
+                                cycle->population += __builtin_popcountll(now) - __builtin_popcountll(before);
+                        }
+                }
+        }
+}
+
+/**
+ * grows the box around the cells of the plane to take in one more
+ * @param *target the cycle_box_t
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+static void box_cell(void *target, long long row, long long col)
+{
+        struct cycle_box_t *box = target;
+
+        if (box->population == 0 || row < box->row) {
+                box->row = row;
+        }
+        if (box->population == 0 || col < box->col) {
+                box->col = col;
+        }
+        box->population++;
+}
+
+/**
+ * hashes one cell of the plane by where it is inside the box
+ * @param *target the cycle_box_t
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+static void box_hash_cell(void *target, long long row, long long col)
+{
+        struct cycle_box_t *box = target;
+
+        box->hash ^= hash_key(hash_mix((uint64_t) (row - box->row)) + (uint64_t) (col - box->col));
+}
+
+/**
+ * hashes the plane from where its cells are inside the box around them, so the same cells
+ * anywhere on the plane hash the same
+ * @param *cycle the history, given the hash, population and top left of the box
+ * @param *sparse the plane
+ */
+static void hash_moving(struct cycle_t *cycle, struct sparse_t *sparse)
+{
+        struct cycle_box_t box = { 0, 0, 0, 0 };
+
+        sparse_cells(sparse, box_cell, &box);
+        sparse_cells(sparse, box_hash_cell, &box);
+        cycle->hash = box.hash;
+        cycle->population = box.population;
+        cycle->row = box.row;
+        cycle->col = box.col;
+}
+
+/**
+ * looks the current generation up in the table and puts it in if it is not there
+ * @param *cycle the history
+ * @param generation the current generation
+ * @return 1 if the board has been this before, which sets period, start, drow and dcol, or 0
+ */
+static int check_cycle(struct cycle_t *cycle, unsigned long long generation)
+{
+        struct cycle_entry_t *entry = &cycle->table[cycle->hash & (cycle->size - 1)];
+
+        if (entry->used && entry->hash == cycle->hash && entry->population == cycle->population && entry->generation < generation) {
+                cycle->period = generation - entry->generation;
+                cycle->start = entry->generation;
+                cycle->drow = cycle->row - entry->row;
+                cycle->dcol = cycle->col - entry->col;
+                return 1;
+        }
+
+        entry->used = 1;
+        entry->hash = cycle->hash;
+        entry->population = cycle->population;
+        entry->row = cycle->row;
+        entry->col = cycle->col;
+        entry->generation = generation;
+        return 0;
+}
+
+/**
+ * forgets the history and hashes the board from nothing, for after it was loaded or jumped
+ * @param *cycle the history
+ * @param *sim the sim
+ */
+void cycle_start(struct cycle_t *cycle, struct sim_t *sim)
+{
+        struct grid_t *grid = sim->grid[sim->cur];
+
+        memset(cycle->table, 0, cycle->size * sizeof(struct cycle_entry_t));
+        cycle->hash = 0;
+        cycle->population = 0;
+        cycle->row = 0;
+        cycle->col = 0;
+        cycle->period = 0;
+
+        if (sim->sparse && cycle->moving) {
+                hash_moving(cycle, sim->sparse);
+        } else if (sim->sparse) {
+                cycle->hash = sim->sparse->hash;
+                cycle->population = sparse_population(sim->sparse);
+        } else if (sim->packed[0]) {
+                hash_packed(cycle, sim->packed[sim->cur], NULL);
+        } else {
+                hash_grid_all(cycle, grid);
+        }
+
+        check_cycle(cycle, sim->generation);
+}
+
+/**
+ * brings the hash up to date after sim_step and looks for the board in the history
+ * @param *cycle the history, cycle_start has to have been called on the sim
+ * @param *sim the sim, stepped one generation since cycle_start or the last cycle_step
+ * @return 1 if the board has been this before, which sets period, start, drow and dcol, or 0
+ */
+int cycle_step(struct cycle_t *cycle, struct sim_t *sim)
+{
+        int t;
+        int u;
+        int row;
+        int words;
+        struct grid_t *grid = sim->grid[sim->cur];
+        struct grid_t *last = sim->grid[!sim->cur];
+        struct active_t *active = sim->active;
+
+        if (sim->sparse && cycle->moving) {
+                hash_moving(cycle, sim->sparse);
+        } else if (sim->sparse) {
+                cycle->hash = sim->sparse->hash;
+                cycle->population += sim->sparse->births - sim->sparse->deaths;
+        } else if (sim->packed[0]) {
+                hash_packed(cycle, sim->packed[sim->cur], sim->packed[!sim->cur]);
+        } else if (!active) {
+                hash_grid(cycle, grid, last, 0, grid->rows, 0, (grid->cols + 7) / 8);
+        } else {
+                words = (grid->cols + 7) / 8;
+
+                for (t = 0; t < active->tile_rows; t++) {
+                        for (u = 0; u < active->tile_cols; u++) {
+                                if (!active->changed[t * active->tile_cols + u]) {
+                                        continue; /* the same in both grids */
+                                }
+                                row = t * TILE_SIZE;
+                                hash_grid(cycle, grid, last, row, (row + TILE_SIZE < grid->rows) ? row + TILE_SIZE : grid->rows,
+                                                u * TILE_SIZE / 8, ((u + 1) * TILE_SIZE / 8 < words) ? (u + 1) * TILE_SIZE / 8 : words);
+                        }
+                }
+        }
+
+        return check_cycle(cycle, sim->generation);
+}
+
+/**
+ * skips the sim ahead to a generation once cycle_step has found the period, stepping only
+ * what is left over after the whole periods and moving the plane as far as they would have
+ * @param *cycle the history, with the period found
+ * @param *sim the sim, at the generation cycle_step found the period on
+ * @param generation the generation to end on
+ */
+void cycle_forward(struct cycle_t *cycle, struct sim_t *sim, unsigned long long generation)
+{
+        unsigned long long left;
+        unsigned long long periods;
+        unsigned long long k;
+
+        if (cycle->period == 0 || generation <= sim->generation) {
+                return;
+        }
+
+        left = generation - sim->generation;
+        periods = left / cycle->period;
+
+        for (k = 0; k < left % cycle->period; k++) {
+                sim_step(sim);
+        }
+
+        if (sim->sparse) {
+                sparse_shift(sim->sparse, (long long) periods * cycle->drow, (long long) periods * cycle->dcol);
+                sim->sparse->generation += periods * cycle->period;
+        }
+        sim->generation += periods * cycle->period;
+}
+
+/**
+ * writes what was found as one line
+ * @param *cycle the history, with the period found
+ * @param *line where the line goes, without a newline
+ * @param size the room in line
+ */
+void cycle_line(struct cycle_t *cycle, char *line, size_t size)
+{
+        if (cycle->population == 0 && cycle->period == 1) {
+                snprintf(line, size, "died out at generation %llu", cycle->start);
+        } else if (cycle->period == 1) {
+                snprintf(line, size, "still from generation %llu", cycle->start);
+        } else if (cycle->drow != 0 || cycle->dcol != 0) {
+                snprintf(line, size, "spaceship of period %llu moving %lld,%lld from generation %llu", cycle->period,
+                                cycle->drow, cycle->dcol, cycle->start);
+        } else {
+                snprintf(line, size, "oscillator of period %llu from generation %llu", cycle->period, cycle->start);
+        }
+}
@@ -0,0 +1,57 @@
+#include <stdint.h>
+#include "sim.h"
+
+/**
+ * @file cycle.h
+ * @breif headers for finding when a run dies out, stops changing or repeats, in cycle.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef CYCLE_H_
+#define CYCLE_H_
+
+/* entries in the history table when none is asked for */
+#define CYCLE_DEFAULT_SIZE 4096
+
+/* one generation in the history table */
+struct cycle_entry_t {
+        uint64_t hash;
+        long long population;
+        long long row; /* top left of the box around the cells, only kept when matching up to translation */
+        long long col;
+        unsigned long long generation;
+        int used;
+};
+
+/* the hash of the current board and the history of the ones before it. The table has one entry
+ * per slot, picked by the hash, so it stays size entries long and older generations are written
+ * over. period stays 0 until the board repeats, then period, start, drow and dcol say how */
+struct cycle_t {
+        struct cycle_entry_t *table;
+        size_t size; /* a power of 2 */
+        int moving; /* match the plane up to translation */
+        uint64_t hash;
+        long long population;
+        long long row;
+        long long col;
+        unsigned long long period;
+        unsigned long long start; /* the generation the board first was what it repeats */
+        long long drow; /* how far the cells move every period */
+        long long dcol;
+};
+
+int init_cycle(struct cycle_t *cycle, size_t size, int moving);
+
+void free_cycle(struct cycle_t *cycle);
+
+void cycle_start(struct cycle_t *cycle, struct sim_t *sim);
+
+int cycle_step(struct cycle_t *cycle, struct sim_t *sim);
+
+void cycle_forward(struct cycle_t *cycle, struct sim_t *sim, unsigned long long generation);
+
+void cycle_line(struct cycle_t *cycle, char *line, size_t size);
+
+#endif
@@ -0,0 +1,407 @@
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "dist.h"
+#include "load.h"
+
+/**
+ * @file dist.c
+ * @breif Runs one board split over several worker processes, each holding a strip of its rows, so a board can use more cores and memory than one process has
+ * @details The board is cut across into one strip of rows for each worker, no strip holds more than its share of the board and the ghost rows around it. Every generation a worker fills the ghost columns of its strip itself, the sides of a strip are the sides of the board, then sends its first row to the worker above it and its last row to the worker below, ghost columns included, and reads theirs into its ghost rows. The strips at the top and bottom of the board swap rows around the torus and the klein bottle the same way fill_ghost does, the klein bottle sending them backwards, and on the hedge they keep their dead ghost rows. The cross surface would need every row from the strip across the board and is not run here. Rows go through a transport_t, so the workers can be moved off the machine by swapping the shared memory rings for something else. At the end the population and the time are added up from worker to worker, and the workers write their cells in order, each handing the output on to the next.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* one worker and its strip of the board */
+struct dist_t {
+        struct data_t *matrix_data;
+        struct transport_t *transport;
+        int procs;
+        int id;
+        int first; /* the row of the board the strip starts on */
+        struct grid_t *grid[2];
+        int cur;
+        unsigned char *flipped; /* a row turned backwards for the klein bottle */
+};
+
+/* what is added up over the workers once the run is done */
+struct dist_total_t {
+        long long population;
+        double seconds; /* the slowest worker */
+};
+
+/* where load_strip is putting the cells of a pattern */
+struct strip_place_t {
+        struct dist_t *dist;
+        int x;
+        int y;
+        int min;
+        const unsigned char *states; /* the state of every cell of the pattern in order, NULL for all alive */
+        long long index;
+};
+
+/**
+ * says whether a board can be run over several workers
+ * @param *matrix_data a pointer to the main data for the matrix, with the rule the user picked
+ * @param procs how many workers
+ * @return 1 if it can, 0 if the edge or rule needs more than the rows next to a strip or there are more workers than rows
+ */
+int dist_fits(struct data_t *matrix_data, int procs)
+{
+        struct rule_t rule;
+
+        return (matrix_data->edge == EDGE_HEDGE || matrix_data->edge == EDGE_TORUS || matrix_data->edge == EDGE_KLEIN)
+                && parse_rule(matrix_data->rule, &rule) == 0 && rule.radius == 1 && procs <= matrix_data->row_matrix;
+}
+
+/**
+ * puts one cell from a file on the strip, if it lands there, where parse_file would put it on the whole board
+ * @param *target the strip_place_t
+ * @param row the row from the file
+ * @param col the col from the file
+ */
+static void place_strip(void *target, long long row, long long col)
+{
+        struct strip_place_t *place = target;
+        struct grid_t *grid = place->dist->grid[0];
+        unsigned char state = (place->states) ? place->states[place->index++] : 1;
+        int i = row;
+        int j = col;
+
+        board_position(place->dist->matrix_data->row_matrix, place->dist->matrix_data->col_matrix, place->dist->matrix_data->edge,
+                        &i, &j, place->x, place->y, place->min);
+
+        if (i >= place->dist->first && i < place->dist->first + grid->rows) {
+                grid->cell[i - place->dist->first][j] = (state < get_rule()->states) ? state : 1;
+        }
+}
+
+/**
+ * reads the pattern file and keeps the cells that land on the strip of the worker, using the rule it names unless the user picked one
+ * @param *dist the worker
+ * @param *filepath the file to load
+ * @param x the offset for the x value that the user entered
+ * @param y the offset for the y value that the user entered
+ * @return 0 on success, -1 if the file could not be read
+ */
+static int load_strip(struct dist_t *dist, char *filepath, int x, int y)
+{
+        struct strip_place_t place = { dist, x, y, 1000, NULL, 0 };
+        struct pattern_t pattern;
+        struct rule_t rule;
+
+        if (load_pattern(filepath, &pattern) == -1) {
+                return -1;
+        }
+
+        if (pattern.rule[0] != '\0' && !dist->matrix_data->rule_given) {
+                if (parse_rule(pattern.rule, &rule) == 0 && rule.radius == 1) {
+                        set_rule(&rule);
+                        strcpy(dist->matrix_data->rule, rule.text);
+                } else if (dist->id == 0) {
+                        printf("The rule %s from the file can not be run, using %s\n", pattern.rule, dist->matrix_data->rule);
+                }
+        }
+
+        if (pattern.count > 0) {
+                place.min = (pattern.min_row < place.min) ? pattern.min_row : place.min;
+                place.min = (pattern.min_col < place.min) ? pattern.min_col : place.min;
+        }
+
+        place.states = pattern.states;
+        pattern_cells(&pattern, place_strip, &place);
+        free_pattern(&pattern);
+
+        return 0;
+}
+
+/**
+ * sends a row to a neighbor, ghost columns included
+ * @param *dist the worker
+ * @param link LINK_UP or LINK_DOWN
+ * @param *row the row, starting at its ghost column
+ * @param flip 1 to send it backwards, for the klein bottle
+ * @return 0, or -1 if the link broke
+ */
+static int send_row(struct dist_t *dist, int link, const unsigned char *row, int flip)
+{
+        int j;
+        int width = dist->matrix_data->col_matrix + 2;
+
+        if (flip) {
+                for (j = 0; j < width; j++) {
+                        dist->flipped[j] = row[width - 1 - j];
+                }
+                row = dist->flipped;
+        }
+
+        return dist->transport->send(dist->transport, dist->id, link, row, width);
+}
+
+/**
+ * fills the ghost border of the strip for the next generation, the ghost columns from the strip itself and the ghost rows from its neighbors
+ * @param *dist the worker
+ * @return 0, or -1 if a link broke
+ */
+static int exchange(struct dist_t *dist)
+{
+        struct grid_t *grid = dist->grid[dist->cur];
+        int edge = dist->matrix_data->edge;
+        int width = grid->cols + 2;
+        int klein = edge == EDGE_KLEIN;
+        int up = edge != EDGE_HEDGE || dist->id > 0;
+        int down = edge != EDGE_HEDGE || dist->id < dist->procs - 1;
+
+        /* the sides wrap the same way on the klein bottle as on the torus, and the hedge leaves the ghost rows dead */
+        fill_ghost(grid, (edge == EDGE_HEDGE) ? EDGE_HEDGE : EDGE_TORUS);
+
+        /* both rows go out before either is waited on, so no two workers wait on each other */
+        if ((up && send_row(dist, LINK_UP, grid->cell[0] - 1, klein && dist->id == 0) == -1)
+                        || (down && send_row(dist, LINK_DOWN, grid->cell[grid->rows - 1] - 1, klein && dist->id == dist->procs - 1) == -1)) {
+                return -1;
+        }
+
+        if ((up && dist->transport->recv(dist->transport, dist->id, LINK_UP, grid->cell[-1] - 1, width) == -1)
+                        || (down && dist->transport->recv(dist->transport, dist->id, LINK_DOWN, grid->cell[grid->rows] - 1, width) == -1)) {
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * adds up the totals of every worker, passing them down from worker 0 to the last and back around to worker 0
+ * @param *dist the worker
+ * @param *total the totals of this worker, set to the totals of the whole board on the first and the last worker
+ * @return 0, or -1 if a link broke
+ */
+static int add_totals(struct dist_t *dist, struct dist_total_t *total)
+{
+        struct dist_total_t part;
+        struct transport_t *transport = dist->transport;
+
+        if (dist->id > 0) {
+                if (transport->recv(transport, dist->id, LINK_UP, &part, sizeof(part)) == -1) {
+                        return -1;
+                }
+                total->population += part.population;
+                total->seconds = (part.seconds > total->seconds) ? part.seconds : total->seconds;
+        }
+
+        if (transport->send(transport, dist->id, LINK_DOWN, total, sizeof(*total)) == -1) {
+                return -1;
+        }
+
+        if (dist->id == 0 && transport->recv(transport, dist->id, LINK_UP, total, sizeof(*total)) == -1) {
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * writes the cells of the strip in the life 106 format of life_batch, worker 0 writes the # lines first and
+ * each worker waits for the one above it to finish, so the rows come out in order
+ * @param *dist the worker
+ * @param *total the totals for the whole board, only read on worker 0
+ * @param generations how many generations were stepped
+ * @param *out the file to write to, shared by every worker
+ * @return 0, or -1 if a link broke
+ */
+static int write_strip(struct dist_t *dist, struct dist_total_t *total, unsigned long long generations, FILE *out)
+{
+        int i;
+        int j;
+        char turn = 0;
+        struct grid_t *grid = dist->grid[dist->cur];
+        double cells = (double) dist->matrix_data->row_matrix * dist->matrix_data->col_matrix;
+
+        if (dist->id > 0 && dist->transport->recv(dist->transport, dist->id, LINK_UP, &turn, 1) == -1) {
+                return -1;
+        }
+
+        if (dist->id == 0) {
+                fprintf(out, "#Life 1.06\n");
+                fprintf(out, "#generation %llu\n", generations);
+                fprintf(out, "#population %lld\n", total->population);
+                fprintf(out, "#seconds %f\n", total->seconds);
+
+                if (total->seconds > 0) {
+                        fprintf(out, "#cell updates per second %.0f\n", cells * generations / total->seconds);
+                }
+        }
+
+        for (i = 0; i < grid->rows; i++) {
+                for (j = 0; j < grid->cols; j++) {
+                        if (grid->cell[i][j] == 1) { /* dying cells of a generations rule are left out */
+                                fprintf(out, "%d %d\n", dist->first + i, j);
+                        }
+                }
+        }
+        fflush(out); /* all of it has to be out before the next worker starts writing */
+
+        if (dist->id < dist->procs - 1 && dist->transport->send(dist->transport, dist->id, LINK_DOWN, &turn, 1) == -1) {
+                return -1;
+        }
+
+        return 0;
+}
+
+/**
+ * loads, steps and writes out the strip of one worker, run in the process forked for it
+ * @param *dist the worker, with its id, transport and data set
+ * @param *filepath the file to load
+ * @param x the offset for the x value that the user entered
+ * @param y the offset for the y value that the user entered
+ * @param generations how many generations to step
+ * @param *out the file the board is written to
+ * @return 0 on success, -1 if the strip could not be made or loaded or a link broke
+ */
+static int run_worker(struct dist_t *dist, char *filepath, int x, int y, unsigned long long generations, FILE *out)
+{
+        int i;
+        int j;
+        unsigned long long g;
+        int rows = dist->matrix_data->row_matrix;
+        int last = (long long)rows * (dist->id + 1) / dist->procs;
+        struct dist_total_t total;
+        struct timespec start;
+        struct timespec end;
+
+        dist->first = (long long)rows * dist->id / dist->procs;
+        dist->grid[0] = init_grid(last - dist->first, dist->matrix_data->col_matrix);
+        dist->grid[1] = init_grid(last - dist->first, dist->matrix_data->col_matrix);
+        dist->flipped = malloc(dist->matrix_data->col_matrix + 2);
+        dist->cur = 0;
+
+        if (!dist->grid[0] || !dist->grid[1] || !dist->flipped) {
+                printf("Malloc failed\n");
+                return -1;
+        }
+
+        if (load_strip(dist, filepath, x, y) == -1) {
+                fprintf(stderr, "worker %d: could not read %s\n", dist->id, filepath);
+                return -1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        for (g = 0; g < generations; g++) {
+                if (exchange(dist) == -1) {
+                        return -1;
+                }
+                step_rows(dist->grid[dist->cur], dist->grid[!dist->cur], 0, dist->grid[0]->rows);
+                dist->cur = !dist->cur;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        total.population = 0;
+        total.seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        for (i = 0; i < dist->grid[0]->rows; i++) {
+                for (j = 0; j < dist->grid[0]->cols; j++) {
+                        total.population += dist->grid[dist->cur]->cell[i][j] == 1;
+                }
+        }
+
+        if (add_totals(dist, &total) == -1 || write_strip(dist, &total, generations, out) == -1) {
+                return -1;
+        }
+
+        if (dist->id == dist->procs - 1 && out != stdout) {
+                printf("generation %llu population %lld seconds %f\n", generations, total.population, total.seconds);
+        }
+
+        free_grid(dist->grid[0]);
+        free_grid(dist->grid[1]);
+        free(dist->flipped);
+
+        return 0;
+}
+
+/**
+ * runs a board over procs worker processes and writes the last generation to out, the board is never
+ * held whole by any one process. If a worker fails the rest are stopped
+ * @param *matrix_data a pointer to the main data for the matrix, dist_fits has to say it can be split
+ * @param *filepath the file to load
+ * @param x the offset for the x value that the user entered
+ * @param y the offset for the y value that the user entered
+ * @param generations how many generations to step
+ * @param procs how many workers, at least 2
+ * @param *out the file to write the board to
+ * @return 0 on success, -1 if the workers could not be started or one of them failed
+ */
+int dist_run(struct data_t *matrix_data, char *filepath, int x, int y, unsigned long long generations, int procs, FILE *out)
+{
+        int i;
+        int j;
+        int status;
+        int started;
+        int failed = 0;
+        pid_t pid;
+        pid_t *pids;
+        struct rule_t rule;
+        struct dist_t dist;
+        /* a worker can be a row ahead of its neighbor, the totals go through the same rings after the last row */
+        struct transport_t *transport = init_ring_transport(procs, 2 * ((size_t)matrix_data->col_matrix + 2) + 2 * sizeof(struct dist_total_t));
+
+        if (!transport) {
+                return -1;
+        }
+
+        pids = malloc(sizeof(pid_t) * procs);
+        if (!pids) {
+                printf("Malloc failed\n");
+                transport->close(transport);
+                return -1;
+        }
+
+        parse_rule(matrix_data->rule, &rule);
+        set_rule(&rule);
+        fflush(NULL); /* or whatever is still buffered would be written by every worker */
+
+        for (started = 0; started < procs; started++) {
+                pid = fork();
+
+                if (pid == -1) {
+                        printf("Could not start worker %d\n", started);
+                        failed = 1;
+                        break;
+                } else if (pid == 0) {
+                        memset(&dist, 0, sizeof(struct dist_t));
+                        dist.matrix_data = matrix_data;
+                        dist.transport = transport;
+                        dist.procs = procs;
+                        dist.id = started;
+                        exit((run_worker(&dist, filepath, x, y, generations, out) == -1) ? 1 : 0);
+                }
+                pids[started] = pid;
+        }
+
+        if (failed) { /* the ones that did start would wait forever on the ones that did not */
+                for (j = 0; j < started; j++) {
+                        kill(pids[j], SIGTERM);
+                }
+        }
+
+        for (i = 0; i < started; i++) {
+                if (wait(&status) == -1) {
+                        break;
+                }
+
+                if ((!WIFEXITED(status) || WEXITSTATUS(status) != 0) && !failed) {
+                        failed = 1;
+                        for (j = 0; j < started; j++) {
+                                kill(pids[j], SIGTERM);
+                        }
+                }
+        }
+
+        free(pids);
+        transport->close(transport);
+
+        return failed ? -1 : 0;
+}
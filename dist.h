@@ -0,0 +1,20 @@
+#include <stdio.h>
+#include "life.h"
+#include "transport.h"
+
+/**
+ * @file dist.h
+ * @breif headers for running one board over several worker processes, in dist.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef DIST_H_
+#define DIST_H_
+
+int dist_fits(struct data_t *matrix_data, int procs);
+
+int dist_run(struct data_t *matrix_data, char *filepath, int x, int y, unsigned long long generations, int procs, FILE *out);
+
+#endif
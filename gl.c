@@ -1,35 +1,271 @@
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "SDL2/SDL.h" 
 #include "sdl.h"
 #include "life.h"
+#include "simd.h"
+#include "sim.h"
+#include "checkpoint.h"
+#include "pace.h"
+#include "triple.h"
+#include "render.h"
+#include "stats.h"
+#include "history.h"
 
 /** 
  * @file gl.c
  * @breif implements the game of life and renders it to the screen, uses command line arguments for anything the user wants to enter
- * @details A structure is used to hold most of the data for the matrices and some base values are set inside of that structure if the user does not enter any command line arguments. Rendering is done by displaying one grid and figuring out the next generation on the other then displaying the second grid. Each grid is cleared before being filled with the next generation.
+ * @details A structure is used to hold most of the data for the matrices and some base values are set inside of that structure if the user does not enter any command line arguments. The board is stepped on its own thread and each finished generation is handed to the window through a triple buffer, so a slow step never holds up the window and a slow frame never holds up the stepping. The window keeps the board in one texture and only uploads the tiles that changed. Every generation stepped is also kept in a history, and while the run is paused the window can step back and forward through it and drag across itself to scrub. The window only asks for a generation, the stepping thread builds it from the history and hands it over the same way, and carrying on from a past generation puts the run back to it.
  * @author Elijah Johnson
  * @date 12/5/2016
  * @bug Klein does not work with starting coordinates on the edges, otherwise everything works as intended
  * @todo get klein working on edges and break up this file into better functions
  */
 
+/* what the stepping thread needs, quit, paused, move and seek are the only things the window changes once
+ * it is running. checkpoint is saved every every generations when both are set. stats is shared with the window.
+ * While paused the window adds to move or sets seek to go through the history, and shown is the generation in view */
+struct stepper_t {
+        struct sim_t *sim;
+        struct triple_t *triple;
+        struct stats_t *stats;
+        struct history_t *history; /* NULL when no history is kept */
+        double rate;
+        char *checkpoint;
+        unsigned long long every;
+        struct grid_t *view; /* the board of generation shown, from the history or the sim */
+        atomic_ullong shown;
+        atomic_llong move;
+        atomic_llong seek; /* -1 for nothing to seek to */
+        atomic_int paused;
+        atomic_int quit;
+};
+
+/**
+ * steps the board one generation and saves a checkpoint if one is due
+ * @param *stepper the stepper_t
+ */
+static void step_once(struct stepper_t *stepper)
+{
+        char line[SIZE];
+        int due;
+        double start = stats_begin();
+
+        sim_step(stepper->sim);
+        stats_end(stepper->stats, STATS_STEP, start);
+
+        if (stepper->history) {
+                start = stats_begin();
+                history_record(stepper->history, sim_view(stepper->sim), stepper->sim->generation); /* empty again if it failed */
+                stats_end(stepper->stats, STATS_HISTORY, start);
+        }
+
+        due = stats_due(stepper->stats, stepper->sim->generation);
+        if (due) {
+                stats_sample(stepper->stats, stepper->sim);
+        }
+
+        if (due == 1) {
+                stats_line(stepper->stats, line, SIZE);
+                fprintf(stderr, "%s\n", line);
+        }
+
+        if (stepper->checkpoint && stepper->every > 0 && stepper->sim->generation % stepper->every == 0
+                        && save_checkpoint(stepper->sim, stepper->checkpoint) == -1) {
+                fprintf(stderr, "could not save a checkpoint to %s\n", stepper->checkpoint);
+        }
+}
+
+/**
+ * moves the paused view to the generation the window asked for, from the history, going past the newest one steps the run
+ * @param *stepper the stepper_t
+ * @return 1 if there is a generation to hand to the window, 0 if nothing was asked for
+ */
+static int scrub(struct stepper_t *stepper)
+{
+        long long seek = atomic_exchange(&stepper->seek, -1);
+        long long move = atomic_exchange(&stepper->move, 0);
+        unsigned long long shown = atomic_load(&stepper->shown);
+        unsigned long long target;
+        unsigned long long oldest = 0;
+        unsigned long long newest;
+        struct grid_t *view = NULL;
+        double start;
+
+        if (seek < 0 && move == 0) {
+                return 0;
+        }
+
+        if (seek >= 0) {
+                target = seek;
+        } else {
+                target = (move < 0 && (unsigned long long)-move > shown) ? 0 : shown + move;
+        }
+
+        while (target > stepper->sim->generation) {
+                step_once(stepper);
+        }
+
+        if (stepper->history && target < stepper->sim->generation && history_range(stepper->history, &oldest, &newest) == 0) {
+                start = stats_begin();
+                view = history_seek(stepper->history, (target < oldest) ? oldest : target);
+                stats_end(stepper->stats, STATS_HISTORY, start);
+        }
+
+        if (view) {
+                target = (target < oldest) ? oldest : target;
+        } else {
+                view = sim_view(stepper->sim); /* the newest generation, or all there is with no history */
+                target = stepper->sim->generation;
+        }
+
+        stepper->view = view;
+        atomic_store(&stepper->shown, target);
+
+        return 1;
+}
+
+/**
+ * carries on from the generation in view after a pause, going back to it if it is in the past. The plane
+ * can not go back, a grid only holds part of it, so it carries on from where it was
+ * @param *stepper the stepper_t
+ */
+static void resume(struct stepper_t *stepper)
+{
+        struct sim_t *sim = stepper->sim;
+        unsigned long long shown = atomic_load(&stepper->shown);
+
+        if (shown < sim->generation) {
+                if (sim_restore(sim, stepper->view, shown) == 0) {
+                        history_truncate(stepper->history, shown);
+                } else {
+                        fprintf(stderr, "this edge can not go back, carrying on from generation %llu\n", sim->generation);
+                }
+        }
+
+        stepper->view = NULL;
+        atomic_store(&stepper->shown, sim->generation);
+}
+
+/**
+ * steps the board on its own thread and hands generations to the window through the triple buffer
+ * @param *arg the stepper_t
+ * @return NULL
+ */
+static void *step_thread(void *arg)
+{
+        struct stepper_t *stepper = arg;
+        struct pace_t generations;
+        unsigned long long due;
+        int pending = 0; /* a generation has been stepped that the window has not been handed */
+        int paused = 0;
+        double wake;
+        double start;
+
+        init_pace(&generations, stepper->rate);
+
+        while (!atomic_load(&stepper->quit)) {
+                if (atomic_load(&stepper->paused)) {
+                        if (!paused) {
+                                paused = 1;
+                                stepper->view = sim_view(stepper->sim);
+                        }
+                        pending = scrub(stepper) || pending;
+                } else if (paused) {
+                        /* the generations due while paused are not made up */
+                        paused = 0;
+                        resume(stepper);
+                        init_pace(&generations, stepper->rate);
+                        pending = 1;
+                } else if (stepper->rate > 0) {
+                        due = pace_due(&generations, PACE_MAX_BEHIND);
+                        pending = pending || due > 0;
+
+                        for (; due > 0; due--) {
+                                step_once(stepper);
+                        }
+                } else {
+                        step_once(stepper);
+                        pending = 1;
+                }
+
+                if (!paused) {
+                        atomic_store(&stepper->shown, stepper->sim->generation);
+                }
+
+                /* only hand a generation over once the window has taken the last one, so the
+                 * window never skips one and can redraw just the tiles that changed. One the window
+                 * wants the cells of another region of is handed over again */
+                if ((pending || triple_moved(stepper->triple)) && triple_wanted(stepper->triple)) {
+                        start = stats_begin();
+                        if (paused) {
+                                triple_publish(stepper->triple, stepper->view, atomic_load(&stepper->shown));
+                        } else {
+                                triple_publish(stepper->triple, sim_view(stepper->sim), stepper->sim->generation);
+                        }
+                        stats_end(stepper->stats, STATS_PUBLISH, start);
+                        pending = 0;
+                }
+
+                if (paused) {
+                        pace_sleep_until(pace_now() + (pending ? 0.002 : 0.01));
+                } else if (stepper->rate > 0) {
+                        /* check back soon for a generation still waiting, and do not sleep so long that quitting waits on a slow rate */
+                        wake = pace_next(&generations);
+                        if (wake > pace_now() + (pending ? 0.002 : 0.05)) {
+                                wake = pace_now() + (pending ? 0.002 : 0.05);
+                        }
+                        pace_sleep_until(wake);
+                }
+        }
+
+        return NULL;
+}
+
 int main(int argc, char *argv[])
 {
         /* intial settings for game of life */
         /* either 2, 4, 8, or 16 */
 	int m = 9999;
 	int n = 9999;
-        int i;
-        unsigned char **first_matrix = NULL; /* matrices being used to store 1's and 0's what will be rendered to the screen */
-        unsigned char **second_matrix = NULL;
+        char *resume = NULL; /* checkpoint to pick the run up from */
+        struct checkpoint_t header;
+        struct rule_t rule;
+        int rows = 0; /* size of the board, 0 to take it from the window */
+        int cols = 0;
+        struct sim_t *sim = NULL; /* the board and whichever engine steps it */
+        unsigned long long jump = 0; /* generation to jump to before the window starts */
+        size_t megabytes = HASHLIFE_DEFAULT_MB;
+        size_t history_megabytes = HISTORY_DEFAULT_MB; /* 0 to keep no history */
+        unsigned long long oldest; /* the generations the history holds, for the keys and the mouse */
+        unsigned long long newest;
+        int across; /* how far across the window the mouse is */
+        double generation_rate = 30; /* generations a second, 0 for as fast as possible, about what the old 35 ms tick gave */
+        double frame_rate = 60; /* frames a second drawn to the window */
+        struct pace_t frames; /* the generations are paced on the stepping thread */
+        struct stepper_t stepper;
+        struct render_t *render = NULL; /* draws what the stepping thread hands over */
+        struct stats_t stats; /* phase timings and board counts, for the log line and the overlay */
+        unsigned long long stats_every = 0; /* generations between stats lines */
+        int overlay = 0;
+        char overlay_text[SIZE];
+        double start;
+        /* the long names the options have, only the stats and history ones have no letter people would guess */
+        struct option long_options[] = {
+                { "stats-every", required_argument, NULL, 'S' },
+                { "history", required_argument, NULL, 'Y' },
+                { NULL, 0, NULL, 0 }
+        };
+        pthread_t thread;
+        int quit = 0;
         FILE *starting_condition = NULL; /*file the user wants */
-        char buf[SIZE];
         char *filepath = NULL;
         char directory[SIZE] = "Conway_Life/";
         int c;
-        int matrix = 0;
         struct sdl_info_t sdl_info; /* this is needed to graphically display the game */
         struct data_t *matrix_data = malloc(sizeof(struct data_t));
 
@@ -39,15 +275,18 @@ int main(int argc, char *argv[])
         }
 
         init_struct(matrix_data);
+        stepper.checkpoint = NULL;
+        stepper.every = 0;
+        select_kernel(); /* use the widest vector kernel this cpu has for the byte engine */
 
         if (argc == 1) {
-                printf("Usage: \n./life -w width -h height -e edge -r red -g green -b blue");
-                printf(" -s sprite size -f filename -o starting position -H help\n");
+                printf("Usage: \n./life -w width -h height -R rows -C cols -e edge -r red -g green -b blue");
+                printf(" -s sprite size -f filename -o starting position -m engine -j threads -J generation -M megabytes -G rate -F fps -L checkpoint -K checkpoint -k generations -u rule -S generations -Y megabytes -H help\n");
         } /*print usage if no other args were entered */
         
 
         /*procsses all of the arguments */
-        while ((c = getopt(argc, argv, ":w:h:e:r:g:b:s:f:o:H")) != -1) {
+        while ((c = getopt_long(argc, argv, ":w:h:R:C:e:r:g:b:s:f:o:m:j:J:M:G:F:L:K:k:u:S:Y:H", long_options, NULL)) != -1) {
                         switch (c) {
                         case 'w':
                                 if (atoi(optarg) > 1) {
@@ -59,6 +298,12 @@ int main(int argc, char *argv[])
                                         matrix_data->height = atoi(optarg);
                                 }
                                 break;
+                        case 'R':
+                                rows = atoi(optarg);
+                                break;
+                        case 'C':
+                                cols = atoi(optarg);
+                                break;
                         case 'e':
                                 if (strncmp("hedge", optarg, strlen(optarg)) == 0) {
                                         matrix_data->edge = 1;
@@ -66,6 +311,10 @@ int main(int argc, char *argv[])
                                         matrix_data->edge = 2; /*sets the edge */
                                 } else if (strncmp("klein", optarg, strlen(optarg)) == 0) {
                                         matrix_data->edge = 3;
+                                } else if (strncmp("plane", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->edge = EDGE_PLANE; /* no edge at all */
+                                } else if (strncmp("cross", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->edge = EDGE_CROSS;
                                 }
 
                                 break;
@@ -92,9 +341,6 @@ int main(int argc, char *argv[])
                                         printf("Resetting to default size\n");
                                         matrix_data->sprite_size = 8; /*size of sprite they want */
                                 }
-
-                                m = matrix_data->row_matrix / 2;
-                                n = matrix_data->col_matrix / 2;
                                 break;
                         case 'f':
                                 errno = 0;
@@ -109,29 +355,99 @@ int main(int argc, char *argv[])
                                 break;
                         case 'o':
                                 m = atoi(strtok(optarg, ","));
-                                n = atoi(strtok(NULL, ","));
-                                
-                                if ((m < 0 || m >= matrix_data->row_matrix) && matrix_data->edge == 1) {
-                                        printf("Invalid starting x coordinate for the hedge edge\nResetting to default\n");
-                                        m = matrix_data->row_matrix / 2;
+                                n = atoi(strtok(NULL, ",")); /*starting coordinates for the file, checked once the board size is known */
+                                break;
+                        case 'm':
+                                if (strncmp("byte", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->engine = ENGINE_BYTE;
+                                } else if (strncmp("packed", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->engine = ENGINE_PACKED; /* one bit per cell */
+                                } else if (strncmp("active", optarg, strlen(optarg)) == 0) {
+                                        matrix_data->engine = ENGINE_ACTIVE; /* only steps the tiles that are changing */
                                 }
-                                if ((n < 0 || n >= matrix_data->col_matrix) && matrix_data->edge == 1) {
-                                        printf("Invalid starting y coordinate for the hedge edge\nResetting to default\n");
-                                        n = matrix_data->col_matrix / 2;
-                                } /*starting coordinates for the file */
 
+                                break;
+                        case 'j':
+                                matrix_data->threads = atoi(optarg);
 
+                                if (matrix_data->threads < 1) {
+                                        printf("Thread count must be at least 1\nResetting to default\n");
+                                        matrix_data->threads = 1;
+                                }
+                                break;
+                        case 'J':
+                                jump = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'M':
+                                if (atoi(optarg) > 0) {
+                                        megabytes = atoi(optarg); /* memory cap for HashLife */
+                                }
+                                break;
+                        case 'G':
+                                generation_rate = atof(optarg);
+
+                                if (generation_rate < 0) {
+                                        printf("Generation rate can not be negative\nResetting to default\n");
+                                        generation_rate = 30;
+                                }
+                                break;
+                        case 'F':
+                                if (atof(optarg) > 0) {
+                                        frame_rate = atof(optarg);
+                                }
+                                break;
+                        case 'L':
+                                resume = optarg;
+                                break;
+                        case 'K':
+                                stepper.checkpoint = optarg;
+                                break;
+                        case 'k':
+                                stepper.every = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'u':
+                                if (parse_rule(optarg, &rule) == -1) {
+                                        fprintf(stderr, "%s: argument to option '-u' is not a rule\n", argv[0]);
+                                        exit(1);
+                                }
+                                strcpy(matrix_data->rule, rule.text);
+                                matrix_data->rule_given = 1;
+                                break;
+                        case 'S':
+                                stats_every = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'Y':
+                                if (atoi(optarg) >= 0) {
+                                        history_megabytes = atoi(optarg); /* memory cap for the history */
+                                }
                                 break;
                         case 'H':
-                                printf("Usage: \n./life -w width -h height -e edge -r red -g green -b blue");
-                                printf(" -s sprite size -f filename -o starting position -H help\n");
+                                printf("Usage: \n./life -w width -h height -R rows -C cols -e edge -r red -g green -b blue");
+                                printf(" -s sprite size -f filename -o starting position -m engine -j threads -J generation -M megabytes -G rate -F fps -L checkpoint -K checkpoint -k generations -u rule -S generations -Y megabytes -H help\n");
                                 printf("w: width of screen that you want\nh: height of screen that you want\n");
-                                printf("e: type of edge either hedge, torus, or klein\n");
+                                printf("R: number of rows on the board, defaults to what fits the screen\nC: number of cols on the board\n");
+                                printf("e: type of edge either hedge, torus, klein, cross, or plane\n");
                                 printf("r: red value in rgb, between 255 and 0\n");
                                 printf("g: green value in rgb, between 255 and 0\nb: blue value in rgb, between 255 and 0\n");
                                 printf("s: size of the sprite you want can be 2, 4, 8, or 16\n");
-                                printf("f: file from which the initial pattern will be taken\n");
+                                printf("f: file from which the initial pattern will be taken, RLE, life 1.05, .cells or life 1.06\n");
                                 printf("o: x,y starting positions, entered with no space and a comma\n");
+                                printf("m: engine used to step the board either byte, packed, or active\n");
+                                printf("j: number of threads to step the board with\n");
+                                printf("J: generation to jump to before starting, uses HashLife on the hedge edge while the pattern is clear of it, and on the plane\n");
+                                printf("M: megabytes HashLife may use before it collects garbage\n");
+                                printf("G: generations a second, 0 to step as fast as possible\n");
+                                printf("F: frames a second drawn to the window\n");
+                                printf("L: checkpoint to pick the run up from instead of -f, it sets the size and edge\n");
+                                printf("K: checkpoint to save to when the window is closed\n");
+                                printf("k: also save the checkpoint every this many generations\n");
+                                printf("u: rule as B/S, B36/S23 is HighLife, B/S/C for generations, B2/S/C3 is Brian's Brain, or R,C,M,S,B,NM for\n");
+                                printf("   larger than life, R5,C0,M1,S34..58,B34..45,NM is Bosco, it beats the rule in the file or checkpoint\n");
+                                printf("S: print the phase timings and board counts every this many generations, also --stats-every\n");
+                                printf("Y: megabytes of past generations to keep for going back through, 64 by default, 0 for none, also --history\n");
+                                printf("arrow keys move the view, + and - or the mouse wheel zoom it, tab shows the same numbers over the board\n");
+                                printf("space pauses, then , and . step back and forward, page up and down go %d generations, home and end go\n", HISTORY_KEYFRAME);
+                                printf("   to the oldest and newest kept and dragging across the window scrubs through them, carrying on goes back to the one shown\n");
                                 printf("H: help menu display\n");
                                 exit(1);
                                 break;
@@ -141,13 +457,28 @@ int main(int argc, char *argv[])
                         case '?':
                         default:
                                 printf("Illegal option %c - ignored\n", optopt);
-                                printf("Usage: \n./life -w width -h height -e edge -r red -g green -b blue");
-                                printf(" -s sprite size -f filename -o starting position -H help\n");
+                                printf("Usage: \n./life -w width -h height -R rows -C cols -e edge -r red -g green -b blue");
+                                printf(" -s sprite size -f filename -o starting position -m engine -j threads -J generation -M megabytes -G rate -F fps -L checkpoint -K checkpoint -k generations -u rule -S generations -Y megabytes -H help\n");
 
                                 break;
                         }
         }
 
+        /* the board is the size of the window unless the user asked for a size, the window shows part of it */
+        matrix_data->row_matrix = (rows > 1) ? rows : matrix_data->width / matrix_data->sprite_size;
+        matrix_data->col_matrix = (cols > 1) ? cols : matrix_data->height / matrix_data->sprite_size;
+
+        if (resume) {
+                /* the board has to be made the size and edge it was saved with */
+                if (read_checkpoint(resume, &header) == -1) {
+                        fprintf(stderr, "%s: argument to option '-L' is not a checkpoint\n", argv[0]);
+                        exit(1);
+                }
+                matrix_data->row_matrix = header.rows;
+                matrix_data->col_matrix = header.cols;
+                matrix_data->edge = header.edge;
+        }
+
         if (m == 9999) {
                 m = matrix_data->row_matrix / 2;
         }
@@ -156,6 +487,15 @@ int main(int argc, char *argv[])
                 n = matrix_data->col_matrix / 2;
         }
 
+        if ((m < 0 || m >= matrix_data->row_matrix) && matrix_data->edge == 1) {
+                printf("Invalid starting x coordinate for the hedge edge\nResetting to default\n");
+                m = matrix_data->row_matrix / 2;
+        }
+        if ((n < 0 || n >= matrix_data->col_matrix) && matrix_data->edge == 1) {
+                printf("Invalid starting y coordinate for the hedge edge\nResetting to default\n");
+                n = matrix_data->col_matrix / 2;
+        }
+
         if (!starting_condition) {
                 /*default file is a glider */
                  filepath = strncat(directory, "glider_106.lif", strlen("glider_106.lif"));
@@ -163,43 +503,101 @@ int main(int argc, char *argv[])
 
 
         /* intilize the matrices */
-        first_matrix = init_matrix(matrix_data->row_matrix, matrix_data->col_matrix);
-        second_matrix = init_matrix(matrix_data->row_matrix, matrix_data->col_matrix);
+        sim = init_sim(matrix_data);
+
+        if (!sim) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        if (matrix_data->rule_given && sim_rule(sim, matrix_data->rule) == -1) {
+                fprintf(stderr, "%s: rule %s can not be run on this edge, the plane only runs two state B/S rules without B0 and the cross\n"
+                                "surface only runs rules with a radius of 1\n", argv[0], matrix_data->rule);
+                exit(1);
+        }
         /* set up SDL -- works with SDL2 */
 	init_sdl_info(&sdl_info, matrix_data->width, matrix_data->height, matrix_data->sprite_size, matrix_data->red, matrix_data->green, matrix_data->blue);
 
 	/* your life initialization code here */
 
-        starting_condition = fopen(filepath, "r");
+        if (starting_condition) {
+                fclose(starting_condition);
+        }
+
         if (matrix_data->edge == 1 && n == (matrix_data->col_matrix) / 2) {
                 n = 2 * matrix_data->sprite_size;
         }
 
-        parse_file(starting_condition, buf, first_matrix, filepath, m, n, matrix_data);
+        if (resume) {
+                if (load_checkpoint(sim, resume) == -1) {
+                        fprintf(stderr, "%s: argument to option '-L' failed\n", argv[0]);
+                        exit(1);
+                }
+        } else if (sim_load(sim, filepath, m, n) == -1) {
+                fprintf(stderr, "%s: could not open %s: %s\n", argv[0], filepath, strerror(errno));
+                exit(1);
+        }
+
+        if (jump > 0) {
+                sim_jump(sim, jump, megabytes);
+        }
+
+        /* the window starts on the loaded board, after that the stepping thread hands it generations */
+        stepper.sim = sim;
+        stepper.triple = init_triple(matrix_data->row_matrix, matrix_data->col_matrix, matrix_data->width * RENDER_CELLS, matrix_data->height * RENDER_CELLS);
+        stepper.rate = generation_rate;
+        stepper.stats = &stats;
+        stepper.history = (history_megabytes > 0) ? init_history(matrix_data->row_matrix, matrix_data->col_matrix, history_megabytes) : NULL;
+        stepper.view = NULL;
+        init_stats(&stats, stats_every);
+        atomic_init(&stepper.shown, sim->generation);
+        atomic_init(&stepper.move, 0);
+        atomic_init(&stepper.seek, -1);
+        atomic_init(&stepper.paused, 0);
+        atomic_init(&stepper.quit, 0);
+
+        if (!stepper.triple || (history_megabytes > 0 && !stepper.history)) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        if (stepper.history) {
+                history_record(stepper.history, sim_view(sim), sim->generation);
+        }
+        triple_publish(stepper.triple, sim_view(sim), sim->generation);
+
+        if (pthread_create(&thread, NULL, step_thread, &stepper) != 0) {
+                printf("Could not start the stepping thread exiting\n");
+                exit(1);
+        }
+
+        render = init_render(&sdl_info, matrix_data->row_matrix, matrix_data->col_matrix);
+
+        if (!render) {
+                exit(1);
+        }
 
-        sdl_render_life(&sdl_info, first_matrix);
-        check_board(first_matrix, second_matrix, matrix_data);
-        matrix = 1;
-        /* Main loop: loop forever. */
-	while (1)
+        init_pace(&frames, frame_rate);
+
+        /* Main loop: loop until the window is closed. */
+	while (!quit)
 	{
-		/* your game of life code goes here  */		
-
-		/* change the  modulus value to slow the rendering */
-		if (SDL_GetTicks() % 35 == 0) {
-                        if (matrix == 0) {
-                                /*filp back and forth between the two matrices */
-                                set_zero(second_matrix, matrix_data->row_matrix, matrix_data->col_matrix);
-			        sdl_render_life(&sdl_info, first_matrix);
-                                check_board(first_matrix, second_matrix, matrix_data);
-                                matrix = 1;
-                        } else {
-                                set_zero(first_matrix, matrix_data->row_matrix, matrix_data->col_matrix);
-                                sdl_render_life(&sdl_info, second_matrix);
-                                check_board(second_matrix, first_matrix, matrix_data);
-                                matrix = 0;
+                if (pace_due(&frames, 1) > 0) {
+                        overlay_text[0] = '\0';
+                        if (atomic_load(&stepper.paused)) {
+                                snprintf(overlay_text, SIZE, "PAUSED AT %llu%s", (unsigned long long)atomic_load(&stepper.shown), overlay ? "\n" : "");
+                        }
+                        if (overlay) {
+                                stats_overlay(&stats, overlay_text + strlen(overlay_text), SIZE - strlen(overlay_text));
+                        }
+
+                        /* for the plane the window shows the same cells a hedge board would, the plane goes on past it */
+                        start = stats_begin();
+                        if (render_frame(render, stepper.triple, overlay_text[0] ? overlay_text : NULL)) {
+                                stats_end(&stats, STATS_RENDER, start);
                         }
                 }
+                start = stats_begin();
                  /* Poll for events, and handle the ones we care about. 
                   * You can click the X button to close the window
                   */
@@ -209,25 +607,81 @@ int main(int argc, char *argv[])
 			switch (event.type) 
 			{
 			case SDL_KEYDOWN:
+                                /* the arrows move the view an eighth of the window, + and - zoom around its middle */
+                                if (event.key.keysym.sym == SDLK_LEFT) {
+                                        render_pan(render, -matrix_data->width / 8, 0);
+                                } else if (event.key.keysym.sym == SDLK_RIGHT) {
+                                        render_pan(render, matrix_data->width / 8, 0);
+                                } else if (event.key.keysym.sym == SDLK_UP) {
+                                        render_pan(render, 0, -matrix_data->height / 8);
+                                } else if (event.key.keysym.sym == SDLK_DOWN) {
+                                        render_pan(render, 0, matrix_data->height / 8);
+                                } else if (event.key.keysym.sym == SDLK_PLUS || event.key.keysym.sym == SDLK_EQUALS) {
+                                        render_zoom(render, 1);
+                                } else if (event.key.keysym.sym == SDLK_MINUS) {
+                                        render_zoom(render, -1);
+                                } else if (event.key.keysym.sym == SDLK_TAB) {
+                                        overlay = !overlay;
+                                        stats_show(&stats, overlay);
+                                } else if (event.key.keysym.sym == SDLK_SPACE) {
+                                        atomic_store(&stepper.paused, !atomic_load(&stepper.paused));
+                                } else if (event.key.keysym.sym == SDLK_COMMA || event.key.keysym.sym == SDLK_PERIOD) {
+                                        /* stepping either way pauses the run first */
+                                        atomic_store(&stepper.paused, 1);
+                                        atomic_fetch_add(&stepper.move, (event.key.keysym.sym == SDLK_COMMA) ? -1 : 1);
+                                } else if (event.key.keysym.sym == SDLK_PAGEUP || event.key.keysym.sym == SDLK_PAGEDOWN) {
+                                        atomic_store(&stepper.paused, 1);
+                                        atomic_fetch_add(&stepper.move, (event.key.keysym.sym == SDLK_PAGEUP) ? -HISTORY_KEYFRAME : HISTORY_KEYFRAME);
+                                } else if ((event.key.keysym.sym == SDLK_HOME || event.key.keysym.sym == SDLK_END) && stepper.history
+                                                && history_range(stepper.history, &oldest, &newest) == 0) {
+                                        atomic_store(&stepper.paused, 1);
+                                        atomic_store(&stepper.seek, (event.key.keysym.sym == SDLK_HOME) ? oldest : newest);
+                                }
 				break;
+                        case SDL_MOUSEBUTTONDOWN:
+                        case SDL_MOUSEMOTION:
+                                /* while paused the left button picks a generation by how far across the window it is, oldest on the left */
+                                if (atomic_load(&stepper.paused) && stepper.history && history_range(stepper.history, &oldest, &newest) == 0
+                                                && ((event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT)
+                                                        || (event.type == SDL_MOUSEMOTION && (event.motion.state & SDL_BUTTON_LMASK)))) {
+                                        across = (event.type == SDL_MOUSEBUTTONDOWN) ? event.button.x : event.motion.x;
+                                        across = (across < 0) ? 0 : (across >= matrix_data->width) ? matrix_data->width - 1 : across;
+                                        atomic_store(&stepper.seek, oldest + (long long)((double)(newest - oldest) * across / (matrix_data->width - 1)));
+                                }
+                                break;
+                        case SDL_MOUSEWHEEL:
+                                render_zoom(render, event.wheel.y);
+                                break;
 			case SDL_KEYUP:
-                        /* If escape is pressed, return (and thus, quit) */
+                        /* If escape is pressed, quit */
 				if (event.key.keysym.sym == SDLK_ESCAPE)
-					return 0;
+					quit = 1;
 				break;
 			case SDL_QUIT:
-				return(0);
+				quit = 1;
+                                break;
 			}
 		}
+
+                stats_end(&stats, STATS_EVENTS, start);
+
+                /* stepping is on its own thread, so this only has to wait for the next frame */
+                pace_sleep_until(pace_next(&frames));
 	}
 
-        /* free all allocated memory */
-        fclose(starting_condition);
-        for (i = matrix_data->col_matrix; i > 0; i--) {
-                free(first_matrix[i]);
-                free(second_matrix[i]);
+        atomic_store(&stepper.quit, 1);
+        pthread_join(thread, NULL);
+
+        if (stepper.checkpoint && save_checkpoint(sim, stepper.checkpoint) == -1) {
+                fprintf(stderr, "%s: could not save a checkpoint to %s\n", argv[0], stepper.checkpoint);
         }
-        free(first_matrix);
-        free(second_matrix);
+
+        /* free all allocated memory */
+        free_render(render);
+        free_triple(stepper.triple);
+        free_history(stepper.history);
+        free_stats(&stats);
+        free_sim(sim);
+        free(matrix_data);
 	return 0;
 }
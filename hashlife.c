@@ -0,0 +1,641 @@
+#include "hashlife.h"
+
+/**
+ * @file hashlife.c
+ * @breif HashLife, a quadtree engine that can jump a pattern ahead by huge numbers of generations
+ * @details The universe is a quadtree whose root is centered on 0, 0. Every node is made canonical through a hash table keyed on its four children, so a pattern that repeats in space is only stored once. Each node also remembers its result, the middle half of the node after 2^k generations, which is exact because nothing outside the node can reach the middle in that time. A result is built from nine overlapping results one level down, so a pattern that repeats in time is only computed once too. hashlife_advance breaks the number of generations into powers of two and makes the root big enough for each one. When the table grows past the cap given to init_hashlife the nodes that cannot be reached from the root are collected between steps, and if that is not enough the cached results are dropped as well. The tree has no edge, so a pattern that reaches the edge of a hedge board carries on past it instead of being cut off. The level 2 nodes are stepped with the rule from get_rule, which must leave empty space empty, so rules with B0 can not be run here.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * hashes the four children of a node
+ * @return the hash
+ */
+static size_t hash_children(struct node_t *nw, struct node_t *ne, struct node_t *sw, struct node_t *se)
+{
+        uint64_t h = (uint64_t)(uintptr_t)nw * 0x9e3779b97f4a7c15ULL;
+
+        h = (h ^ (uint64_t)(uintptr_t)ne) * 0xc2b2ae3d27d4eb4fULL;
+        h = (h ^ (uint64_t)(uintptr_t)sw) * 0x165667b19e3779f9ULL;
+        h = (h ^ (uint64_t)(uintptr_t)se) * 0x94d049bb133111ebULL;
+
+        return (size_t)(h ^ (h >> 29));
+}
+
+/**
+ * takes a node off the free list, getting a new block of nodes when it is empty
+ * @param *life the universe
+ * @return the node, or NULL if the allocation failed
+ */
+static struct node_t *alloc_node(struct hashlife_t *life)
+{
+        int i;
+        struct node_t *node;
+        struct node_block_t *block;
+
+        if (!life->free_list) {
+                block = malloc(sizeof(struct node_block_t));
+
+                if (!block) {
+                        return NULL;
+                }
+
+                block->next = life->blocks;
+                life->blocks = block;
+
+                for (i = HASHLIFE_BLOCK - 1; i >= 0; i--) {
+                        block->nodes[i].next = life->free_list;
+                        life->free_list = &block->nodes[i];
+                }
+        }
+
+        node = life->free_list;
+        life->free_list = node->next;
+
+        return node;
+}
+
+/**
+ * doubles the number of buckets when the table gets too full
+ * @param *life the universe
+ */
+static void grow_table(struct hashlife_t *life)
+{
+        size_t i;
+        size_t buckets = life->buckets * 2;
+        struct node_t *node;
+        struct node_t *next;
+        struct node_t **table = calloc(buckets, sizeof(struct node_t *));
+
+        if (!table) {
+                return; /* longer chains are slower but still correct */
+        }
+
+        for (i = 0; i < life->buckets; i++) {
+                for (node = life->table[i]; node; node = next) {
+                        next = node->next;
+                        node->next = table[hash_children(node->nw, node->ne, node->sw, node->se) & (buckets - 1)];
+                        table[hash_children(node->nw, node->ne, node->sw, node->se) & (buckets - 1)] = node;
+                }
+        }
+
+        free(life->table);
+        life->table = table;
+        life->buckets = buckets;
+}
+
+/**
+ * finds the one node made of these four children, making it if it does not exist yet
+ * @param *life the universe
+ * @param *nw the north west child, all four must be the same level
+ * @return the canonical node, exits if memory runs out
+ */
+static struct node_t *join(struct hashlife_t *life, struct node_t *nw, struct node_t *ne, struct node_t *sw, struct node_t *se)
+{
+        size_t bucket = hash_children(nw, ne, sw, se) & (life->buckets - 1);
+        struct node_t *node;
+
+        for (node = life->table[bucket]; node; node = node->next) {
+                if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se) {
+                        return node;
+                }
+        }
+
+        node = alloc_node(life);
+
+        if (!node) {
+                printf("Malloc failed, out of memory for HashLife nodes\n");
+                exit(1);
+        }
+
+        node->nw = nw;
+        node->ne = ne;
+        node->sw = sw;
+        node->se = se;
+        node->result = NULL;
+        node->result_log = -1;
+        node->mark = 0;
+        node->level = nw->level + 1;
+        node->population = nw->population + ne->population + sw->population + se->population;
+        node->next = life->table[bucket];
+        life->table[bucket] = node;
+
+        if (++life->nodes > life->buckets) {
+                grow_table(life);
+        }
+
+        return node;
+}
+
+/**
+ * gets the empty node of a level
+ * @param *life the universe
+ * @param level the level wanted
+ * @return the empty node
+ */
+static struct node_t *empty_node(struct hashlife_t *life, int level)
+{
+        struct node_t *below;
+
+        if (level == 0) {
+                return &life->dead;
+        }
+
+        if (!life->empty[level]) {
+                below = empty_node(life, level - 1);
+                life->empty[level] = join(life, below, below, below, below);
+        }
+
+        return life->empty[level];
+}
+
+/**
+ * puts a node in the middle of an empty node one level up
+ * @param *life the universe
+ * @param *node the node to center, at least level 1
+ * @return the bigger node
+ */
+static struct node_t *centre(struct hashlife_t *life, struct node_t *node)
+{
+        struct node_t *e = empty_node(life, node->level - 1);
+
+        return join(life, join(life, e, e, e, node->nw), join(life, e, e, node->ne, e),
+                        join(life, e, node->sw, e, e), join(life, node->se, e, e, e));
+}
+
+/**
+ * checks that everything alive in a node is in its middle quarter, so it can be stepped without losing anything
+ * @param *node the node, at least level 3
+ * @return 1 if the node is padded
+ */
+static int is_padded(struct node_t *node)
+{
+        return node->nw->population == node->nw->se->se->population
+                && node->ne->population == node->ne->sw->sw->population
+                && node->sw->population == node->sw->ne->ne->population
+                && node->se->population == node->se->nw->nw->population;
+}
+
+/**
+ * steps the middle 2 by 2 of a 4 by 4 node one generation
+ * @param *life the universe
+ * @param *node a level 2 node
+ * @return the level 1 node in the middle one generation later
+ */
+static struct node_t *life_4x4(struct hashlife_t *life, struct node_t *node)
+{
+        int i;
+        int j;
+        int y;
+        int x;
+        int count;
+        int cell[4][4];
+        struct node_t *quad[2][2] = { { node->nw, node->ne }, { node->sw, node->se } };
+        struct node_t *next[2][2];
+        const struct rule_t *rule = get_rule();
+
+        for (i = 0; i < 4; i++) { /* unpack the 16 cells, rows go south and cols go east */
+                for (j = 0; j < 4; j++) {
+                        struct node_t *q = quad[i / 2][j / 2];
+                        struct node_t *leaf = (i % 2) ? ((j % 2) ? q->se : q->sw) : ((j % 2) ? q->ne : q->nw);
+
+                        cell[i][j] = (leaf == &life->alive);
+                }
+        }
+
+        for (i = 1; i < 3; i++) {
+                for (j = 1; j < 3; j++) {
+                        count = 0;
+
+                        for (y = i - 1; y <= i + 1; y++) {
+                                for (x = j - 1; x <= j + 1; x++) {
+                                        count += cell[y][x];
+                                }
+                        }
+                        count -= cell[i][j];
+                        next[i - 1][j - 1] = rule->next[cell[i][j]][count] ? &life->alive : &life->dead;
+                }
+        }
+
+        return join(life, next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+/**
+ * works out the middle half of a node after 2^step_log generations, step_log is capped at level - 2
+ * @param *life the universe
+ * @param *node the node to step, at least level 2
+ * @param step_log log base 2 of the generations to step
+ * @return the node one level down in the middle of node after stepping
+ */
+static struct node_t *successor(struct hashlife_t *life, struct node_t *node, int step_log)
+{
+        struct node_t *n00, *n01, *n02, *n10, *n11, *n12, *n20, *n21, *n22;
+        struct node_t *c00, *c01, *c02, *c10, *c11, *c12, *c20, *c21, *c22;
+        struct node_t *result;
+
+        if (step_log > node->level - 2) {
+                step_log = node->level - 2;
+        }
+
+        if (node->result && node->result_log == step_log) {
+                return node->result;
+        }
+
+        if (node->population == 0) {
+                return empty_node(life, node->level - 1);
+        }
+
+        if (node->level == 2) {
+                result = life_4x4(life, node);
+        } else {
+                /* nine overlapping nodes one level down, each stepped on its own */
+                n00 = node->nw;
+                n01 = join(life, node->nw->ne, node->ne->nw, node->nw->se, node->ne->sw);
+                n02 = node->ne;
+                n10 = join(life, node->nw->sw, node->nw->se, node->sw->nw, node->sw->ne);
+                n11 = join(life, node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+                n12 = join(life, node->ne->sw, node->ne->se, node->se->nw, node->se->ne);
+                n20 = node->sw;
+                n21 = join(life, node->sw->ne, node->se->nw, node->sw->se, node->se->sw);
+                n22 = node->se;
+
+                c00 = successor(life, n00, step_log);
+                c01 = successor(life, n01, step_log);
+                c02 = successor(life, n02, step_log);
+                c10 = successor(life, n10, step_log);
+                c11 = successor(life, n11, step_log);
+                c12 = successor(life, n12, step_log);
+                c20 = successor(life, n20, step_log);
+                c21 = successor(life, n21, step_log);
+                c22 = successor(life, n22, step_log);
+
+                if (step_log < node->level - 2) {
+                        /* already stepped far enough, just cut the middle out of the nine */
+                        result = join(life,
+                                        join(life, c00->se, c01->sw, c10->ne, c11->nw),
+                                        join(life, c01->se, c02->sw, c11->ne, c12->nw),
+                                        join(life, c10->se, c11->sw, c20->ne, c21->nw),
+                                        join(life, c11->se, c12->sw, c21->ne, c22->nw));
+                } else {
+                        /* step the four overlapping quarters again for the second half of the time */
+                        result = join(life,
+                                        successor(life, join(life, c00, c01, c10, c11), step_log),
+                                        successor(life, join(life, c01, c02, c11, c12), step_log),
+                                        successor(life, join(life, c10, c11, c20, c21), step_log),
+                                        successor(life, join(life, c11, c12, c21, c22), step_log));
+                }
+        }
+
+        node->result = result;
+        node->result_log = step_log;
+
+        return result;
+}
+
+/**
+ * Intilizes an empty universe
+ * @param megabytes roughly how much memory the nodes may use before garbage is collected
+ * @return the universe, or NULL if an allocation failed
+ */
+struct hashlife_t *init_hashlife(size_t megabytes)
+{
+        struct hashlife_t *life = calloc(1, sizeof(struct hashlife_t));
+
+        if (!life) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        life->buckets = 1 << 16;
+        life->table = calloc(life->buckets, sizeof(struct node_t *));
+
+        if (!life->table) {
+                printf("Malloc failed\n");
+                free(life);
+                return NULL;
+        }
+
+        life->max_nodes = megabytes * 1024 * 1024 / (sizeof(struct node_t) + 2 * sizeof(struct node_t *));
+        life->dead.population = 0;
+        life->alive.population = 1;
+        life->root = empty_node(life, 3);
+
+        return life;
+}
+
+/**
+ * frees a universe made by init_hashlife
+ * @param *life the universe to free, may be NULL
+ */
+void free_hashlife(struct hashlife_t *life)
+{
+        struct node_block_t *block;
+        struct node_block_t *next;
+
+        if (!life) {
+                return;
+        }
+
+        for (block = life->blocks; block; block = next) {
+                next = block->next;
+                free(block);
+        }
+
+        free(life->table);
+        free(life);
+}
+
+/**
+ * builds the node of a level whose north west corner is at row, col from a grid placed with its middle on 0, 0
+ * @param *life the universe
+ * @param *grid the grid to read
+ * @param level the level of the node to build
+ * @param row the row of the north west corner
+ * @param col the col of the north west corner
+ * @return the node
+ */
+static struct node_t *build(struct hashlife_t *life, struct grid_t *grid, int level, long long row, long long col)
+{
+        long long half = 1LL << (level - 1);
+        long long grid_row = row + grid->rows / 2;
+        long long grid_col = col + grid->cols / 2;
+
+        if (grid_row >= grid->rows || grid_col >= grid->cols || grid_row + (1LL << level) <= 0 || grid_col + (1LL << level) <= 0) {
+                return empty_node(life, level);
+        }
+
+        if (level == 0) {
+                return grid->cell[grid_row][grid_col] ? &life->alive : &life->dead;
+        }
+
+        return join(life, build(life, grid, level - 1, row, col), build(life, grid, level - 1, row, col + half),
+                        build(life, grid, level - 1, row + half, col), build(life, grid, level - 1, row + half, col + half));
+}
+
+/**
+ * loads a grid into the universe, the middle of the grid goes on 0, 0
+ * @param *life the universe, anything already in it is replaced
+ * @param *grid the grid to load
+ * @return 0 on success
+ */
+int hashlife_load(struct hashlife_t *life, struct grid_t *grid)
+{
+        int level = 3;
+
+        while ((1LL << (level - 1)) < grid->rows || (1LL << (level - 1)) < grid->cols) {
+                level++;
+        }
+
+        life->root = build(life, grid, level, -(1LL << (level - 1)), -(1LL << (level - 1)));
+        life->generation = 0;
+
+        return 0;
+}
+
+/**
+ * marks a node and everything under it as reachable
+ * @param *node the node to mark
+ */
+static void mark(struct node_t *node)
+{
+        if (node->mark || node->level == 0) {
+                return;
+        }
+
+        node->mark = 1;
+        mark(node->nw);
+        mark(node->ne);
+        mark(node->sw);
+        mark(node->se);
+}
+
+/**
+ * frees every node that cannot be reached from the root
+ * @param *life the universe
+ * @param keep_results 1 to keep the cached results of the nodes that stay, 0 to drop them too
+ */
+void hashlife_gc(struct hashlife_t *life, int keep_results)
+{
+        int i;
+        size_t bucket;
+        struct node_t *node;
+        struct node_t **link;
+
+        mark(life->root);
+
+        for (i = 1; i <= HASHLIFE_MAX_LEVEL; i++) {
+                if (life->empty[i]) {
+                        mark(life->empty[i]);
+                }
+        }
+
+        for (bucket = 0; bucket < life->buckets; bucket++) {
+                for (node = life->table[bucket]; node; node = node->next) {
+                        if (node->mark && node->result) {
+                                if (keep_results) { /* keep the result and everything under it */
+                                        mark(node->result);
+                                } else {
+                                        node->result = NULL;
+                                }
+                        }
+                }
+        }
+
+        /* a node marked while keeping results can still point at a result that is about to go */
+        for (bucket = 0; bucket < life->buckets; bucket++) {
+                for (node = life->table[bucket]; node; node = node->next) {
+                        if (node->mark && node->result && !node->result->mark) {
+                                node->result = NULL;
+                        }
+                }
+        }
+
+        for (bucket = 0; bucket < life->buckets; bucket++) {
+                link = &life->table[bucket];
+
+                while ((node = *link)) {
+                        if (node->mark) {
+                                node->mark = 0;
+                                link = &node->next;
+                        } else {
+                                *link = node->next;
+                                node->next = life->free_list;
+                                life->free_list = node;
+                                life->nodes--;
+                        }
+                }
+        }
+}
+
+/**
+ * Advances the universe by any number of generations, one power of two at a time
+ * @param *life the universe
+ * @param generations how many generations to advance
+ * @return 0 on success, -1 if the pattern got too big for the tree
+ */
+int hashlife_advance(struct hashlife_t *life, unsigned long long generations)
+{
+        int k;
+
+        for (k = 0; generations >> k; k++) {
+                if (!((generations >> k) & 1)) {
+                        continue;
+                }
+
+                /* the pattern has to sit in the middle quarter and the root must be big enough to step 2^k at once */
+                while (life->root->level < k + 3 || !is_padded(life->root)) {
+                        if (life->root->level >= HASHLIFE_MAX_LEVEL) {
+                                return -1;
+                        }
+                        life->root = centre(life, life->root);
+                }
+
+                life->root = successor(life, life->root, k);
+                life->generation += 1ULL << k;
+
+                if (life->nodes > life->max_nodes) {
+                        hashlife_gc(life, 1);
+
+                        if (life->nodes > life->max_nodes / 2) {
+                                hashlife_gc(life, 0);
+                        }
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * writes the cells of a node into a grid placed with its middle on 0, 0, anything off the grid is dropped
+ * @param *grid the grid to write
+ * @param *node the node to write
+ * @param row the row of the north west corner of node
+ * @param col the col of the north west corner of node
+ */
+static void store(struct grid_t *grid, struct node_t *node, long long row, long long col)
+{
+        long long half;
+        long long grid_row = row + grid->rows / 2;
+        long long grid_col = col + grid->cols / 2;
+
+        if (node->population == 0 || grid_row >= grid->rows || grid_col >= grid->cols
+                        || grid_row + (1LL << node->level) <= 0 || grid_col + (1LL << node->level) <= 0) {
+                return;
+        }
+
+        if (node->level == 0) {
+                grid->cell[grid_row][grid_col] = 1;
+                return;
+        }
+
+        half = 1LL << (node->level - 1);
+        store(grid, node->nw, row, col);
+        store(grid, node->ne, row, col + half);
+        store(grid, node->sw, row + half, col);
+        store(grid, node->se, row + half, col + half);
+}
+
+/**
+ * writes the universe back into a grid, the same way hashlife_load placed it
+ * @param *life the universe
+ * @param *grid the grid, cleared first
+ */
+void hashlife_store(struct hashlife_t *life, struct grid_t *grid)
+{
+        long long half = 1LL << (life->root->level - 1);
+
+        set_zero(grid);
+        store(grid, life->root, -half, -half);
+}
+
+/**
+ * makes one cell alive inside a node
+ * @param *life the universe
+ * @param *node the node the cell is in
+ * @param row the row of the cell measured from the north west corner of node
+ * @param col the col of the cell measured from the north west corner of node
+ * @return the node with the cell alive
+ */
+static struct node_t *set_node(struct hashlife_t *life, struct node_t *node, long long row, long long col)
+{
+        long long half;
+
+        if (node->level == 0) {
+                return &life->alive;
+        }
+
+        half = 1LL << (node->level - 1);
+
+        if (row < half) {
+                if (col < half) {
+                        return join(life, set_node(life, node->nw, row, col), node->ne, node->sw, node->se);
+                }
+                return join(life, node->nw, set_node(life, node->ne, row, col - half), node->sw, node->se);
+        }
+
+        if (col < half) {
+                return join(life, node->nw, node->ne, set_node(life, node->sw, row - half, col), node->se);
+        }
+        return join(life, node->nw, node->ne, node->sw, set_node(life, node->se, row - half, col - half));
+}
+
+/**
+ * makes one cell of the universe alive, growing the root until it covers the cell
+ * @param *life the universe
+ * @param row the row of the cell, 0 is the middle of the root
+ * @param col the col of the cell
+ */
+void hashlife_set(struct hashlife_t *life, long long row, long long col)
+{
+        long long half = 1LL << (life->root->level - 1);
+
+        while (row < -half || row >= half || col < -half || col >= half) {
+                life->root = centre(life, life->root);
+                half = 1LL << (life->root->level - 1);
+        }
+
+        life->root = set_node(life, life->root, row + half, col + half);
+}
+
+/**
+ * hands every alive cell under a node to fn
+ * @param *node the node to walk
+ * @param row the row of the north west corner of node
+ * @param col the col of the north west corner of node
+ * @param fn called with target and the row and col of every alive cell
+ * @param *target passed to fn
+ */
+static void node_cells(struct node_t *node, long long row, long long col, cell_fn fn, void *target)
+{
+        long long half;
+
+        if (node->population == 0) {
+                return;
+        }
+
+        if (node->level == 0) {
+                fn(target, row, col);
+                return;
+        }
+
+        half = 1LL << (node->level - 1);
+        node_cells(node->nw, row, col, fn, target);
+        node_cells(node->ne, row, col + half, fn, target);
+        node_cells(node->sw, row + half, col, fn, target);
+        node_cells(node->se, row + half, col + half, fn, target);
+}
+
+/**
+ * hands the row and col of every alive cell in the universe to fn, in the same coordinates hashlife_set takes
+ * @param *life the universe
+ * @param fn called with target and the row and col of every alive cell
+ * @param *target passed to fn
+ */
+void hashlife_cells(struct hashlife_t *life, cell_fn fn, void *target)
+{
+        long long half = 1LL << (life->root->level - 1);
+
+        node_cells(life->root, -half, -half, fn, target);
+}
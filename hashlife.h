@@ -0,0 +1,72 @@
+#include <stdint.h>
+#include "life.h"
+
+/**
+ * @file hashlife.h
+ * @breif headers for the HashLife engine in hashlife.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef HASHLIFE_H_
+#define HASHLIFE_H_
+
+/* default cap on the memory used by nodes, in megabytes */
+#define HASHLIFE_DEFAULT_MB 512
+/* the deepest a tree can get, a node at this level is 2^60 cells across */
+#define HASHLIFE_MAX_LEVEL 60
+/* nodes are handed out of blocks this many at a time */
+#define HASHLIFE_BLOCK 65536
+
+/* a square of 2^level by 2^level cells. Level 0 nodes are single cells and
+ * have no children, every other node is made of four nodes one level down */
+struct node_t {
+        struct node_t *nw;
+        struct node_t *ne;
+        struct node_t *sw;
+        struct node_t *se;
+        struct node_t *result; /* the center after 2^result_log generations */
+        struct node_t *next; /* next node in the same hash bucket */
+        double population;
+        int level;
+        int result_log;
+        int mark;
+};
+
+struct node_block_t {
+        struct node_block_t *next;
+        struct node_t nodes[HASHLIFE_BLOCK];
+};
+
+struct hashlife_t {
+        struct node_t **table;
+        size_t buckets;
+        size_t nodes; /* nodes in the table */
+        size_t max_nodes; /* collect garbage past this many */
+        struct node_t *free_list;
+        struct node_block_t *blocks;
+        struct node_t dead;
+        struct node_t alive;
+        struct node_t *empty[HASHLIFE_MAX_LEVEL + 1]; /* the empty node of each level, made when first needed */
+        struct node_t *root; /* always centered on 0, 0 */
+        unsigned long long generation;
+};
+
+struct hashlife_t *init_hashlife(size_t megabytes);
+
+void free_hashlife(struct hashlife_t *life);
+
+int hashlife_load(struct hashlife_t *life, struct grid_t *grid);
+
+int hashlife_advance(struct hashlife_t *life, unsigned long long generations);
+
+void hashlife_store(struct hashlife_t *life, struct grid_t *grid);
+
+void hashlife_set(struct hashlife_t *life, long long row, long long col);
+
+void hashlife_cells(struct hashlife_t *life, cell_fn fn, void *target);
+
+void hashlife_gc(struct hashlife_t *life, int keep_results);
+
+#endif
@@ -0,0 +1,504 @@
+#include "history.h"
+
+/**
+ * @file history.c
+ * @breif Keeps the past generations of a board in little space, to step back through and seek to any of them
+ * @details Every generation recorded is a frame in one growing arena. Most frames only hold the cells that changed from the generation before, as runs: how many cells went by unchanged, how many changed in a row, and the XOR of the old and new state of each of those. XOR goes both ways, so the same frame takes the board a generation forward or a generation back. Every HISTORY_KEYFRAME generations the frame is the whole board as well, as runs of cells in the same state, so a seek never has to go through more than half that many frames. A keyframe keeps its delta after the board, so going back past it is no different from going back past any other frame. There is only one board, it is the newest generation while recording and a seek takes it back from there, starting from whichever is closest, the keyframe below, the keyframe above or the board as it is, so scrubbing a little way is only a few deltas. Recording again first takes it forward to the newest generation. When the arena is past its limit the oldest keyframe and the deltas after it are dropped. The stepping thread records and seeks and the window only asks for the range, lock keeps them apart.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * copies the cells of one grid into another the same size
+ * @param *to the grid to copy into
+ * @param *from the grid to copy
+ */
+static void copy_cells(struct grid_t *to, struct grid_t *from)
+{
+        int i;
+
+        for (i = 0; i < from->rows; i++) {
+                memcpy(to->cell[i], from->cell[i], from->cols);
+        }
+}
+
+/**
+ * forgets every generation recorded
+ * @param *history the history, locked
+ */
+static void forget(struct history_t *history)
+{
+        history->count = 0;
+        history->used = 0;
+        history->shown = (size_t)-1;
+}
+
+/**
+ * makes sure the arena has room for more bytes
+ * @param *history the history
+ * @param bytes how many more bytes
+ * @return 0, or -1 if the arena could not grow
+ */
+static int reserve(struct history_t *history, size_t bytes)
+{
+        size_t size = history->size;
+        unsigned char *arena;
+
+        if (history->used + bytes <= size) {
+                return 0;
+        }
+
+        while (history->used + bytes > size) {
+                size *= 2;
+        }
+
+        arena = realloc(history->arena, size);
+        if (!arena) {
+                return -1;
+        }
+
+        history->arena = arena;
+        history->size = size;
+        return 0;
+}
+
+/**
+ * puts a number in the arena 7 bits a byte, the high bit set on all but the last, the room must be reserved
+ * @param *history the history
+ * @param n the number
+ */
+static void put_number(struct history_t *history, size_t n)
+{
+        while (n >= 0x80) {
+                history->arena[history->used++] = (n & 0x7f) | 0x80;
+                n >>= 7;
+        }
+        history->arena[history->used++] = n;
+}
+
+/**
+ * reads a number put_number wrote
+ * @param **at where the number is, moved past it
+ * @return the number
+ */
+static size_t get_number(const unsigned char **at)
+{
+        int shift = 0;
+        size_t n = 0;
+
+        while (**at & 0x80) {
+                n |= (size_t)(**at & 0x7f) << shift;
+                shift += 7;
+                (*at)++;
+        }
+        n |= (size_t)**at << shift;
+        (*at)++;
+
+        return n;
+}
+
+/**
+ * puts the whole board in the arena as runs of cells in the same state, a run can go on from one row to the next
+ * @param *history the history
+ * @param *grid the board
+ * @return 0, or -1 if the arena could not grow
+ */
+static int put_full(struct history_t *history, struct grid_t *grid)
+{
+        int i;
+        int j;
+        size_t run = 0;
+        unsigned char state = grid->cell[0][0];
+
+        for (i = 0; i < grid->rows; i++) {
+                /* every cell of the row could start a run of its own */
+                if (reserve(history, 2 * (size_t)grid->cols * 11 + 11) == -1) {
+                        return -1;
+                }
+
+                for (j = 0; j < grid->cols; j++) {
+                        if (grid->cell[i][j] != state) {
+                                put_number(history, run);
+                                history->arena[history->used++] = state;
+                                state = grid->cell[i][j];
+                                run = 0;
+                        }
+                        run++;
+                }
+        }
+
+        if (reserve(history, 11) == -1) {
+                return -1;
+        }
+        put_number(history, run);
+        history->arena[history->used++] = state;
+
+        return 0;
+}
+
+/**
+ * puts the cells that changed since the board in the arena as runs and brings the board up to grid. A run
+ * of changed cells ends with its row, a run of unchanged ones goes on for as many rows as it takes
+ * @param *history the history
+ * @param *grid the board
+ * @return 0, or -1 if the arena could not grow
+ */
+static int put_delta(struct history_t *history, struct grid_t *grid)
+{
+        int i;
+        int j;
+        int k;
+        int cols = grid->cols;
+        size_t skip = 0;
+        unsigned char *here;
+        unsigned char *before;
+
+        for (i = 0; i < grid->rows; i++) {
+                here = grid->cell[i];
+                before = history->board->cell[i];
+
+                if (memcmp(here, before, cols) == 0) {
+                        skip += cols;
+                        continue;
+                }
+
+                if (reserve(history, 3 * (size_t)cols * 11) == -1) {
+                        return -1;
+                }
+
+                j = 0;
+                while (j < cols) {
+                        if (here[j] == before[j]) {
+                                skip++;
+                                j++;
+                                continue;
+                        }
+
+                        for (k = j; k < cols && here[k] != before[k]; k++) {
+                        }
+
+                        put_number(history, skip);
+                        put_number(history, k - j);
+                        for (; j < k; j++) {
+                                history->arena[history->used++] = here[j] ^ before[j];
+                                before[j] = here[j];
+                        }
+                        skip = 0;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * builds the board of a keyframe
+ * @param *history the history
+ * @param n the frame, a multiple of HISTORY_KEYFRAME
+ * @param *grid the grid to build it in
+ */
+static void get_full(struct history_t *history, size_t n, struct grid_t *grid)
+{
+        int i = 0;
+        int j = 0;
+        int part;
+        size_t run;
+        unsigned char state;
+        const unsigned char *at = history->arena + history->frame[n] + 1 + sizeof(size_t);
+
+        while (i < grid->rows) {
+                run = get_number(&at);
+                state = *at++;
+
+                while (run > 0) {
+                        part = (run < (size_t)(grid->cols - j)) ? (int)run : grid->cols - j;
+                        memset(grid->cell[i] + j, state, part);
+                        run -= part;
+                        j += part;
+                        if (j == grid->cols) {
+                                i++;
+                                j = 0;
+                        }
+                }
+        }
+}
+
+/**
+ * XORs the cells a delta changed into a board, taking it a generation forward or back
+ * @param *history the history
+ * @param n the frame, not frame 0
+ * @param *grid the board of frame n - 1 or frame n
+ */
+static void apply_delta(struct history_t *history, size_t n, struct grid_t *grid)
+{
+        int i = 0;
+        int j = 0;
+        size_t skip;
+        size_t run;
+        size_t full;
+        unsigned char *cell;
+        const unsigned char *at = history->arena + history->frame[n] + 1;
+        const unsigned char *end = history->arena + ((n + 1 < history->count) ? history->frame[n + 1] : history->used);
+
+        /* the delta of a keyframe is after its board */
+        if (at[-1] == HISTORY_FULL) {
+                memcpy(&full, at, sizeof(size_t));
+                at += sizeof(size_t) + full;
+        }
+
+        while (at < end) {
+                skip = get_number(&at) + j;
+                run = get_number(&at);
+                i += skip / grid->cols;
+                j = skip % grid->cols;
+
+                for (cell = grid->cell[i] + j; run > 0; run--, j++) {
+                        *cell++ ^= *at++;
+                }
+        }
+}
+
+/**
+ * builds a frame in the board, from whichever keyframe or the board as it is is fewest deltas away
+ * @param *history the history, locked
+ * @param n the frame
+ */
+static void build_board(struct history_t *history, size_t n)
+{
+        size_t at;
+        size_t below = n - n % HISTORY_KEYFRAME;
+        size_t above = below + HISTORY_KEYFRAME;
+        size_t from_board = (history->shown < history->count) ? ((history->shown > n) ? history->shown - n : n - history->shown) : (size_t)-1;
+        size_t from_below = n - below + 1; /* a keyframe costs about as much as a delta that changed everything */
+        size_t from_above = (above < history->count) ? above - n + 1 : (size_t)-1;
+
+        if (from_board <= from_below && from_board <= from_above) {
+                at = history->shown;
+        } else if (from_below <= from_above) {
+                get_full(history, below, history->board);
+                at = below;
+        } else {
+                get_full(history, above, history->board);
+                at = above;
+        }
+
+        for (; at < n; at++) {
+                apply_delta(history, at + 1, history->board);
+        }
+        for (; at > n; at--) {
+                apply_delta(history, at, history->board);
+        }
+
+        history->shown = n;
+}
+
+/**
+ * Intilizes a history for boards of rows by cols cells, with nothing recorded
+ * @param rows the rows of the board
+ * @param cols the cols of the board
+ * @param megabytes the size the arena is kept under, about
+ * @return the history, or NULL if an allocation failed
+ */
+struct history_t *init_history(int rows, int cols, size_t megabytes)
+{
+        struct history_t *history = calloc(1, sizeof(struct history_t));
+
+        if (!history) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        history->rows = rows;
+        history->cols = cols;
+        history->size = 1 << 16;
+        history->limit = megabytes << 20;
+        history->frames = HISTORY_KEYFRAME;
+        history->shown = (size_t)-1;
+        history->arena = malloc(history->size);
+        history->frame = malloc(sizeof(size_t) * history->frames);
+        history->board = init_grid(rows, cols);
+        pthread_mutex_init(&history->lock, NULL);
+
+        if (!history->arena || !history->frame || !history->board) {
+                printf("Malloc failed\n");
+                free_history(history);
+                return NULL;
+        }
+
+        return history;
+}
+
+/**
+ * frees a history made by init_history
+ * @param *history the history, may be NULL
+ */
+void free_history(struct history_t *history)
+{
+        if (!history) {
+                return;
+        }
+
+        pthread_mutex_destroy(&history->lock);
+        free(history->arena);
+        free(history->frame);
+        if (history->board) {
+                free_grid(history->board);
+        }
+        free(history);
+}
+
+/**
+ * records a generation. One that does not follow the last one recorded starts the history over from it
+ * @param *history the history
+ * @param *grid the board, the size the history was made for
+ * @param generation its generation
+ * @return 0, or -1 if the arena could not grow, then the history is empty
+ */
+int history_record(struct history_t *history, struct grid_t *grid, unsigned long long generation)
+{
+        int failed;
+        size_t start;
+        size_t bytes;
+        size_t *frame;
+
+        pthread_mutex_lock(&history->lock);
+
+        if (history->count > 0 && generation != history->first + history->count) {
+                forget(history);
+        }
+        if (history->count == 0) {
+                history->first = generation;
+        } else if (history->shown != history->count - 1) {
+                build_board(history, history->count - 1); /* back from a seek */
+        }
+
+        if (history->count == history->frames) {
+                frame = realloc(history->frame, sizeof(size_t) * history->frames * 2);
+                if (!frame) {
+                        printf("Malloc failed\n");
+                        forget(history);
+                        pthread_mutex_unlock(&history->lock);
+                        return -1;
+                }
+                history->frame = frame;
+                history->frames *= 2;
+        }
+
+        history->frame[history->count] = history->used;
+        failed = reserve(history, 1 + sizeof(size_t));
+        if (!failed && history->count % HISTORY_KEYFRAME == 0) {
+                /* the size of the board goes before it, for apply_delta to skip it */
+                history->arena[history->used++] = HISTORY_FULL;
+                history->used += sizeof(size_t);
+                start = history->used;
+                failed = put_full(history, grid);
+                bytes = history->used - start;
+                memcpy(history->arena + start - sizeof(size_t), &bytes, sizeof(size_t));
+        } else if (!failed) {
+                history->arena[history->used++] = HISTORY_DELTA;
+        }
+
+        /* the first frame has nothing to be a change from */
+        if (!failed && history->count == 0) {
+                copy_cells(history->board, grid);
+        } else if (!failed) {
+                failed = put_delta(history, grid);
+        }
+
+        if (failed) {
+                printf("Malloc failed\n");
+                forget(history);
+                pthread_mutex_unlock(&history->lock);
+                return -1;
+        }
+        history->shown = history->count;
+        history->count++;
+
+        /* drop the oldest keyframe and its deltas, the next keyframe becomes frame 0 */
+        while (history->used > history->limit && history->count > HISTORY_KEYFRAME) {
+                bytes = history->frame[HISTORY_KEYFRAME];
+                memmove(history->arena, history->arena + bytes, history->used - bytes);
+                history->used -= bytes;
+                history->count -= HISTORY_KEYFRAME;
+                memmove(history->frame, history->frame + HISTORY_KEYFRAME, sizeof(size_t) * history->count);
+                for (frame = history->frame; frame < history->frame + history->count; frame++) {
+                        *frame -= bytes;
+                }
+                history->first += HISTORY_KEYFRAME;
+                history->shown = (history->shown != (size_t)-1 && history->shown >= HISTORY_KEYFRAME) ? history->shown - HISTORY_KEYFRAME : (size_t)-1;
+        }
+
+        pthread_mutex_unlock(&history->lock);
+
+        return 0;
+}
+
+/**
+ * builds the board of a recorded generation, only the thread that records may seek
+ * @param *history the history
+ * @param generation the generation
+ * @return a grid holding it that stays the same until the next record, seek or truncate, or NULL if it is not recorded
+ */
+struct grid_t *history_seek(struct history_t *history, unsigned long long generation)
+{
+        struct grid_t *view = NULL;
+
+        pthread_mutex_lock(&history->lock);
+
+        if (generation >= history->first && generation - history->first < history->count) {
+                build_board(history, generation - history->first);
+                view = history->board;
+        }
+
+        pthread_mutex_unlock(&history->lock);
+
+        return view;
+}
+
+/**
+ * gets the generations that are recorded
+ * @param *history the history
+ * @param *oldest set to the first generation recorded
+ * @param *newest set to the last generation recorded
+ * @return 0, or -1 if nothing is recorded
+ */
+int history_range(struct history_t *history, unsigned long long *oldest, unsigned long long *newest)
+{
+        int found;
+
+        pthread_mutex_lock(&history->lock);
+
+        found = history->count > 0;
+        if (found) {
+                *oldest = history->first;
+                *newest = history->first + history->count - 1;
+        }
+
+        pthread_mutex_unlock(&history->lock);
+
+        return found ? 0 : -1;
+}
+
+/**
+ * forgets every generation after one, for when the run goes back to it and carries on from there
+ * @param *history the history
+ * @param generation the last generation to keep, nothing happens if it is not recorded
+ */
+void history_truncate(struct history_t *history, unsigned long long generation)
+{
+        size_t n;
+
+        pthread_mutex_lock(&history->lock);
+
+        if (generation >= history->first && generation - history->first < history->count) {
+                n = generation - history->first;
+                build_board(history, n);
+
+                if (n + 1 < history->count) {
+                        history->used = history->frame[n + 1];
+                        history->count = n + 1;
+                }
+        }
+
+        pthread_mutex_unlock(&history->lock);
+}
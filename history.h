@@ -0,0 +1,57 @@
+#include <pthread.h>
+#include "life.h"
+
+/**
+ * @file history.h
+ * @breif headers for keeping the past generations of a board to rewind and seek through, in history.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+/* generations from one whole board to the next, a seek decodes at most half this many deltas */
+#define HISTORY_KEYFRAME 256
+/* megabytes of history the window keeps unless it is told otherwise */
+#define HISTORY_DEFAULT_MB 64
+/* the frame of a whole board and the frame of the cells that changed, the first byte of each frame */
+#define HISTORY_FULL 'K'
+#define HISTORY_DELTA 'D'
+
+/* the generations from first to first + count - 1, frame n is the bytes of arena from frame[n] up to
+ * frame[n + 1], or used for the last one. Every frame but frame 0 holds the XOR of the board before it and its
+ * own board, so it takes a board a generation either way, and when n is a multiple of HISTORY_KEYFRAME the
+ * whole board goes before that.
+ * board holds frame shown, the newest one while recording and the one history_seek built while seeking.
+ * lock guards all of it, the stepping thread records and seeks and the window reads the range */
+struct history_t {
+        int rows;
+        int cols;
+        unsigned char *arena;
+        size_t used;
+        size_t size;
+        size_t limit; /* the oldest generations are dropped a keyframe at a time past this many bytes */
+        size_t *frame;
+        size_t count;
+        size_t frames; /* room in frame */
+        unsigned long long first;
+        struct grid_t *board;
+        size_t shown; /* the frame in board, (size_t)-1 when board holds nothing */
+        pthread_mutex_t lock;
+};
+
+struct history_t *init_history(int rows, int cols, size_t megabytes);
+
+void free_history(struct history_t *history);
+
+int history_record(struct history_t *history, struct grid_t *grid, unsigned long long generation);
+
+struct grid_t *history_seek(struct history_t *history, unsigned long long generation);
+
+int history_range(struct history_t *history, unsigned long long *oldest, unsigned long long *newest);
+
+void history_truncate(struct history_t *history, unsigned long long generation);
+
+#endif
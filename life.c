@@ -1,9 +1,10 @@
 #include "life.h"
+#include "load.h"
 
 /** 
  * @file life.c
  * @breif Functions to run the game of life. Includes everything from initilizing the matrix to checking the adjacent tiles
- * @details In the function, check_surrounding there are three different cases to check for the different edges. In all three of them the ternerary operator is used to decide where to start checking and then the checking proceeds from there. In the torus case the edges get wrapped around and it checks the opposite side. In the klein case the edges get wrapped around and the Y coordinate gets flipped if it leaves the left or right side of the screen.
+ * @details Each board is a grid_t, one aligned block with a ghost border one cell wide around it. Before a generation is stepped fill_ghost copies the cells the edge says are adjacent into that border, so the step itself never has to check where it is. For the hedge the border is all zeros. In the torus case the edges get wrapped around and it copies the opposite side. In the klein case the edges get wrapped around and the Y coordinate gets flipped if it leaves the top or bottom of the board. The cross surface, a projective plane, flips the Y coordinate the same way and the X coordinate when it leaves the left or right, with dead corners. So every step kernel runs the same straight code on every cell whatever the edge is, and only the border strip is written per edge. A generations rule keeps each cell in a byte as its state, 0 dead, 1 alive and the rest dying, and only state 1 counts as a neighbor. A Larger than Life rule reaches further than the ghost border, so step_wide keeps running column sums down the block and slides a window along them, wrapping rows and cols itself the way the edge does.
  * @author Elijah Johnson
  * @date 12/5/2016
  * @bug Klein bottle does not work with starting coordinates on the edges, otherwise no known bugs.
@@ -11,366 +12,876 @@
  */
 
 /**
- * Intilizes a 2d array of chars, with number of rows = to rows and num cols = to cols
- * @param rows the amount of rows in the array
- * @param cols the cols in the array
- * @return the pointer to the 2d array of chars
+ * Intilizes a grid with rows rows and cols cols, the whole board including its ghost border lives in one aligned block
+ * @param rows the amount of rows in the grid
+ * @param cols the cols in the grid
+ * @return the pointer to the grid, or NULL if an allocation failed
  */
-unsigned char **init_matrix(int rows, int cols)
+struct grid_t *init_grid(int rows, int cols)
 {
         int i;
-        int j;
-        unsigned char **a = NULL;
+        void *block = NULL;
+        struct grid_t *grid = NULL;
 
-        a = malloc(sizeof(unsigned char *) * rows); /*mallocs the rows */
+        grid = malloc(sizeof(struct grid_t));
 
-        if (!a) {
+        if (!grid) {
                 printf("Malloc failed\n");
                 return NULL;
         }
 
-        for (i = 0; i < rows; i++) {
-                a[i] = malloc(sizeof(unsigned char) * cols);/*mallocs the cols, if one fails frees everything */
+        grid->rows = rows;
+        grid->cols = cols;
+        /* pad each row, ghost cells included, out to a whole number of cache lines */
+        grid->stride = (cols + 2 + GRID_ALIGN - 1) / GRID_ALIGN * GRID_ALIGN;
 
-                if (!a[i]) {
-                        for (j = i; j > 0; j--) {
-                                free(a[j]);
+        if (posix_memalign(&block, GRID_ALIGN, (size_t)grid->stride * (rows + 2)) != 0) {
+                printf("Malloc failed\n");
+                free(grid);
+                return NULL;
+        }
+        grid->block = block;
 
-                        }
-                        free(a);
+        grid->cell = malloc(sizeof(unsigned char *) * (rows + 2));
 
-                        return NULL;
-                }
+        if (!grid->cell) {
+                printf("Malloc failed\n");
+                free(grid->block);
+                free(grid);
+                return NULL;
         }
 
-        for (j = 0; j < rows; j++) {
-                for (i = 0; i < cols; i++) { /*sets everything to 0 */
-                        a[j][i] = 0;
-                }
+        for (i = 0; i < rows + 2; i++) { /* each row pointer points at the first cell inside the ghost column */
+                grid->cell[i] = grid->block + (size_t)i * grid->stride + 1;
         }
+        grid->cell++; /* so cell[-1] is the top ghost row */
+        grid->edge = EDGE_HEDGE;
+
+        memset(grid->block, 0, (size_t)grid->stride * (rows + 2));
 
-        return a;
+        return grid;
 }
 
 /**
- * Checks every cell on the board and the adjacent cells around that cell
- * @param **matrix the matrix to be checked
- * @param **next_matrix the matrix to be filled with the next generation
- * @param *matrix_data a pointer to the main data for the matrix
+ * frees a grid made by init_grid
+ * @param *grid the grid to free, may be NULL
+ */
+void free_grid(struct grid_t *grid)
+{
+        if (!grid) {
+                return;
+        }
+
+        free(grid->cell - 1);
+        free(grid->block);
+        free(grid);
+}
+
+/**
+ * Fills the ghost border of the grid based on the edge so the step never has to check where it is
+ * @param *grid the grid whose border gets filled
+ * @param edge the edge either hedge torus klein or cross, 1 2 3 or 5
  */
-void check_board(unsigned char **matrix, unsigned char **next_matrix, struct data_t *matrix_data)
+void fill_ghost(struct grid_t *grid, int edge)
 {
         int i;
         int j;
+        int rows = grid->rows;
+        int cols = grid->cols;
+        unsigned char **cell = grid->cell;
 
-        for (i = 0; i <= matrix_data->row_matrix; i++) {
-                for (j = 0; j <= matrix_data->col_matrix; j++) {
-                        next_matrix = change_board(matrix, next_matrix, i % matrix_data->row_matrix, j % matrix_data->col_matrix, 
-                                        check_surrounding(matrix, i % matrix_data->row_matrix, j % matrix_data->col_matrix,
-                                                matrix_data->row_matrix, matrix_data->col_matrix, matrix_data->edge));
+        grid->edge = edge;
+
+        if (edge == EDGE_TORUS || edge == EDGE_KLEIN) {
+                for (i = 0; i < rows; i++) { /* the left and right edges wrap for both */
+                        cell[i][-1] = cell[i][cols - 1];
+                        cell[i][cols] = cell[i][0];
+                }
+        } else if (edge == EDGE_CROSS) {
+                for (i = 0; i < rows; i++) { /* leaving through the left or right flips the row */
+                        cell[i][-1] = cell[rows - 1 - i][cols - 1];
+                        cell[i][cols] = cell[rows - 1 - i][0];
+                }
+        } else {
+                for (i = 0; i < rows; i++) {
+                        cell[i][-1] = 0;
+                        cell[i][cols] = 0;
                 }
         }
 
-
+        if (edge == EDGE_TORUS) {
+                memcpy(cell[-1] - 1, cell[rows - 1] - 1, cols + 2);
+                memcpy(cell[rows] - 1, cell[0] - 1, cols + 2);
+        } else if (edge == EDGE_KLEIN) {
+                /* leaving through the top or bottom flips the column, the ghost columns
+                 * filled above take care of the corners */
+                for (j = -1; j <= cols; j++) {
+                        cell[-1][j] = cell[rows - 1][cols - 1 - j];
+                        cell[rows][j] = cell[0][cols - 1 - j];
+                }
+        } else if (edge == EDGE_CROSS) {
+                /* the same flip as klein, but going around a corner flips both ways and lands back
+                 * on the corner cell itself, so the corners are left dead instead */
+                for (j = 0; j < cols; j++) {
+                        cell[-1][j] = cell[rows - 1][cols - 1 - j];
+                        cell[rows][j] = cell[0][cols - 1 - j];
+                }
+                cell[-1][-1] = 0;
+                cell[-1][cols] = 0;
+                cell[rows][-1] = 0;
+                cell[rows][cols] = 0;
+        } else {
+                memset(cell[-1] - 1, 0, cols + 2);
+                memset(cell[rows] - 1, 0, cols + 2);
+        }
 }
 
+/* where parse_file is putting the cells of a pattern */
+struct place_t {
+        struct grid_t *grid;
+        int x;
+        int y;
+        int min;
+        int edge;
+        const unsigned char *states; /* the state of every cell of the pattern in order, NULL for all alive */
+        long long index;
+};
+
+/* the row kernel step_rows uses, select_kernel in simd.c swaps in a vector one */
+static row_fn step_row = step_row_scalar;
+
+/* the rule every engine steps with, B3/S23 until set_rule is called */
+static struct rule_t life_rule = {
+        .birth = 1 << 3,
+        .survive = 1 << 2 | 1 << 3,
+        .next = { { [3] = 1 }, { [2] = 1, [3] = 1 } },
+        .terms = 2,
+        .term = { { 0, ~0ULL, 0, 0, 0, ~0ULL }, { ~0ULL, ~0ULL, 0, 0, ~0ULL, ~0ULL } },
+        .states = 2,
+        .radius = 1,
+        .text = "B3/S23",
+};
+
 /**
- * Checks the tiles surrounding the one being checked currently based on the edge and keeps count
- * @param **matrix the matrix in which the point is located
- * @param row_alive the row currently being checked
- * @param col_alive the col currently being checked
- * @param row_matrix the maximum row for the matrix
- * @param col_matrix the maximum col for the matrix
- * @param edge the edge either torus klein or hedge, 1 2 or 3
- * @return count the number of alive cells counted around the one being checked
+ * Steps one row of cells one cell at a time, also used for the leftover cells of the vector kernels
+ * @param *above the row above, starting at the first cell to step
+ * @param *here the row being stepped
+ * @param *below the row below
+ * @param *out where the next generation of the row is written
+ * @param cols the number of cells to step
  */
-int check_surrounding(unsigned char **matrix, int row_alive, int col_alive, int row_matrix, int col_matrix, int edge)
+void step_row_scalar(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols)
 {
-        int count = 0;
-        int i;
         int j;
-        int start_posX;
-        int start_posY;
-        int end_posX;
-        int end_posY;
+        int count;
 
-        row_matrix--;/* sets row matrix to the correct thing, becuase an array goes from 0 to row_matrix - 1 */
-        col_matrix--;
+        for (j = 0; j < cols; j++) { /* the ghost border means every cell has all 8 neighbors */
+                count = above[j - 1] + above[j] + above[j + 1]
+                        + here[j - 1] + here[j + 1]
+                        + below[j - 1] + below[j] + below[j + 1];
+                out[j] = life_rule.next[here[j]][count];
+        }
+}
 
-        if (edge == 1) {
-                start_posX = (row_alive - 1 < 0) ? row_alive : row_alive - 1;
+/**
+ * changes the row kernel used by step_rows
+ * @param fn the kernel to use, NULL goes back to step_row_scalar
+ */
+void set_row_kernel(row_fn fn)
+{
+        step_row = (fn) ? fn : step_row_scalar;
+}
 
-                start_posY = (col_alive - 1 < 0) ? col_alive : col_alive - 1;
+/**
+ * reads the neighbor counts of one half of a rule
+ * @param **at the text, left just past the counts
+ * @return a bit for every count, 0 to 8
+ */
+static unsigned short read_counts(const char **at)
+{
+        unsigned short counts = 0;
 
-                end_posX = (row_alive + 1 > row_matrix) ? row_alive : row_alive + 1;
+        while (**at >= '0' && **at <= '8') {
+                counts |= 1 << (**at - '0');
+                (*at)++;
+        }
 
-                end_posY = (col_alive + 1 > col_matrix) ? col_alive : col_alive + 1;
+        return counts;
+}
+
+/**
+ * reads a number, and a second one after .. if there is one
+ * @param **at the text, left just past the numbers
+ * @param *low set to the first number
+ * @param *high set to the second number, or the first if there is no second
+ * @return 0 on success, -1 if there is no number
+ */
+static int read_range(const char **at, int *low, int *high)
+{
+        char *end;
+
+        *low = strtol(*at, &end, 10);
+        if (end == *at || !isdigit((unsigned char)**at)) {
+                return -1;
+        }
+        *at = end;
+        *high = *low;
 
-                for (i = start_posX; i <= end_posX; i++) { /* set a start and end pos for both col and rows and then run through all the possibilties and count */
-                        for (j = start_posY; j <= end_posY; j++) {
-                                if (i == row_alive && j == col_alive) {
-                                        continue;
-                                } else if (matrix[i][j] == 1) {
-                                        count++;
-                                }
-                                
+        if ((*at)[0] == '.' && (*at)[1] == '.') {
+                *high = strtol(*at + 2, &end, 10);
+                if (end == *at + 2 || !isdigit((unsigned char)(*at)[2])) {
+                        return -1;
+                }
+                *at = end;
+        }
+
+        return 0;
+}
+
+/**
+ * reads a Larger than Life rule written the way Golly does, R5,C0,M1,S34..58,B34..45,NM
+ * @param *text the rule, starting at the R
+ * @param *rule the rule to fill
+ * @return 0 on success, -1 if text is not a rule this can run
+ */
+static int parse_wide(const char *text, struct rule_t *rule)
+{
+        int letter;
+        int low;
+        int high;
+        int seen = 0;
+        int most;
+        const char *at = text;
+
+        while (*at != '\0' && *at != ':') {
+                letter = toupper((unsigned char)*at++);
+
+                if (letter == 'N') {
+                        if (toupper((unsigned char)*at) != 'M') {
+                                return -1; /* only the square neighborhood is counted */
                         }
+                        at++;
+                } else if (read_range(&at, &low, &high) == -1) {
+                        return -1;
+                } else if (letter == 'R' && low == high) {
+                        rule->radius = low;
+                } else if (letter == 'C' && low == high) {
+                        rule->states = (low < 2) ? 2 : low; /* C0 and C1 are plain two state rules */
+                } else if (letter == 'M' && low == high) {
+                        rule->middle = low;
+                } else if (letter == 'S') {
+                        rule->survive_low = low;
+                        rule->survive_high = high;
+                } else if (letter == 'B') {
+                        rule->birth_low = low;
+                        rule->birth_high = high;
+                } else {
+                        return -1;
+                }
+
+                seen |= (letter == 'R') | (letter == 'S') << 1 | (letter == 'B') << 2;
+
+                if (*at == ',') {
+                        at++;
+                } else if (*at != '\0' && *at != ':') {
+                        return -1;
+                }
+        }
+
+        most = (2 * rule->radius + 1) * (2 * rule->radius + 1);
+
+        if (seen != 7 || rule->radius < 1 || rule->radius > RULE_MAX_RADIUS || rule->states > RULE_STATES
+                        || rule->middle < 0 || rule->middle > 1 || rule->birth_low > rule->birth_high
+                        || rule->survive_low > rule->survive_high || rule->birth_high > most || rule->survive_high > most) {
+                return -1;
+        }
+
+        if (rule->radius == 1) {
+                /* the 8 neighbors, so it can be run with the tables like any other B/S rule */
+                for (low = 0; low <= 8; low++) {
+                        rule->birth |= (low >= rule->birth_low && low <= rule->birth_high) << low;
+                        rule->survive |= (low + rule->middle >= rule->survive_low && low + rule->middle <= rule->survive_high) << low;
+                }
+                rule->middle = 0;
+        }
+
+        return 0;
+}
+
+/**
+ * reads a rule written as B36/S23, B36S23 or the older S/B form 23/36, a Generations rule
+ * with the states after them as B2/S/C3 or /2/3, or a Larger than Life rule as R5,C0,M1,S34..58,B34..45,NM
+ * @param *text the rule, case does not matter and anything after a : is ignored
+ * @param *rule the rule to fill
+ * @return 0 on success, -1 if text is not a rule
+ */
+int parse_rule(const char *text, struct rule_t *rule)
+{
+        int n;
+        int part;
+        int letter;
+        int has;
+        int lettered = 0;
+        int seen = 0; /* bit 0 once the birth counts are read, bit 1 for survive and bit 2 if either is read twice */
+        unsigned short counts;
+        const char *at = text;
+        char *end;
+
+        memset(rule, 0, sizeof(struct rule_t));
+        rule->states = 2;
+        rule->radius = 1;
+
+        if (toupper((unsigned char)*at) == 'R') {
+                if (parse_wide(text, rule) == -1) {
+                        return -1;
+                }
+        } else {
+                for (part = 0; part < 2; part++) {
+                        letter = toupper((unsigned char)*at);
+                        has = (letter == 'B' || letter == 'S');
+
+                        if (part == 0) {
+                                lettered = has;
+                        } else if (has != lettered) {
+                                return -1; /* letters on one half and not the other */
+                        }
+
+                        if (has) {
+                                at++;
+                        } else {
+                                letter = (part == 0) ? 'S' : 'B'; /* no letters means survive comes first */
+                        }
+
+                        counts = read_counts(&at);
+
+                        if (letter == 'B') {
+                                seen |= (seen & 1) ? 4 : 1;
+                                rule->birth = counts;
+                        } else {
+                                seen |= (seen & 2) ? 4 : 2;
+                                rule->survive = counts;
+                        }
+
+                        if (part == 0 && *at == '/') {
+                                at++;
+                        } else if (part == 0 && !lettered) {
+                                return -1;
+                        }
+                }
+
+                if (*at == '/') {
+                        /* a Generations rule, the number of states with or without a C */
+                        at += 1 + (toupper((unsigned char)at[1]) == 'C');
+                        if (read_range(&at, &rule->states, &n) == -1 || n != rule->states
+                                        || rule->states < 2 || rule->states > RULE_STATES) {
+                                return -1;
+                        }
+                }
+
+                if (seen != 3 || (*at != '\0' && *at != ':')) {
+                        return -1;
+                }
+        }
+
+        for (n = 0; n <= 8; n++) {
+                rule->next[0][n] = (rule->birth >> n) & 1;
+                rule->next[1][n] = (rule->survive >> n) & 1;
+
+                if (rule->next[0][n] | rule->next[1][n]) {
+                        rule->term[rule->terms].ones = -(uint64_t)(n & 1);
+                        rule->term[rule->terms].twos = -(uint64_t)((n >> 1) & 1);
+                        rule->term[rule->terms].fours = -(uint64_t)((n >> 2) & 1);
+                        rule->term[rule->terms].eights = -(uint64_t)(n >> 3);
+                        rule->term[rule->terms].born = -(uint64_t)rule->next[0][n];
+                        rule->term[rule->terms].stays = -(uint64_t)rule->next[1][n];
+                        rule->terms++;
+                }
+        }
+
+        /* an alive cell that dies starts dying at 2, the last dying state goes back to 0 */
+        for (n = 1; n < rule->states; n++) {
+                rule->decay[n] = (n + 1 < rule->states) ? n + 1 : 0;
+        }
+
+        /* written back out the same way whatever way it came in */
+        if (rule->radius > 1) {
+                snprintf(rule->text, RULE_SIZE, "R%d,C%d,M%d,S%d..%d,B%d..%d,NM", rule->radius, (rule->states > 2) ? rule->states : 0,
+                                rule->middle, rule->survive_low, rule->survive_high, rule->birth_low, rule->birth_high);
+                return 0;
+        }
+
+        end = rule->text;
+        *end++ = 'B';
+        for (n = 0; n <= 8; n++) {
+                if (rule->next[0][n]) {
+                        *end++ = '0' + n;
+                }
+        }
+        *end++ = '/';
+        *end++ = 'S';
+        for (n = 0; n <= 8; n++) {
+                if (rule->next[1][n]) {
+                        *end++ = '0' + n;
+                }
+        }
+
+        if (rule->states > 2) {
+                end += sprintf(end, "/C%d", rule->states);
+        }
+        *end = '\0';
+
+        return 0;
+}
+
+/**
+ * changes the rule every engine steps with, call it before stepping starts
+ * @param *rule a rule compiled by parse_rule
+ */
+void set_rule(const struct rule_t *rule)
+{
+        life_rule = *rule;
+}
+
+/**
+ * says whether a rule can be run one bit per cell, by the packed, sparse and HashLife engines
+ * @param *rule the rule
+ * @return 1 for a two state rule on the 8 neighbors, 0 for a Generations or Larger than Life rule
+ */
+int rule_is_bits(const struct rule_t *rule)
+{
+        return rule->states == 2 && rule->radius == 1;
+}
+
+/**
+ * gets the rule every engine steps with
+ * @return the rule, it must not be changed by the caller
+ */
+const struct rule_t *get_rule(void)
+{
+        return &life_rule;
+}
+
+/**
+ * Steps the rows first to last - 1 of grid into next_grid, the ghost border of grid must already be filled
+ * @param *grid the grid holding the current generation
+ * @param *next_grid the grid to be filled with the next generation
+ * @param first the first row to step
+ * @param last one past the last row to step
+ */
+void step_rows(struct grid_t *grid, struct grid_t *next_grid, int first, int last)
+{
+        step_block(grid, next_grid, first, last, 0, grid->cols);
+}
+
+/**
+ * Steps one row of a Generations rule, only neighbors in state 1 are counted and dying cells count down whatever their neighbors are
+ * @param *above the row above, starting at the first cell to step
+ * @param *here the row being stepped
+ * @param *below the row below
+ * @param *out where the next generation of the row is written
+ * @param cols the number of cells to step
+ */
+static void step_row_states(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols)
+{
+        int j;
+        int count;
+        int state;
+
+        for (j = 0; j < cols; j++) {
+                count = (above[j - 1] == 1) + (above[j] == 1) + (above[j + 1] == 1)
+                        + (here[j - 1] == 1) + (here[j + 1] == 1)
+                        + (below[j - 1] == 1) + (below[j] == 1) + (below[j + 1] == 1);
+                state = here[j];
+                out[j] = ((state < 2) & life_rule.next[state == 1][count]) ? 1 : life_rule.decay[state];
+        }
+}
+
+/**
+ * adds or takes away the alive cells of one row to the column sums of a Larger than Life step, wrapping it the way the edge does
+ * @param *grid the grid, its edge says how rows and cols past the board wrap
+ * @param *sums the column sums, sums[k] is for col map[k]
+ * @param *map the col of the board each sum is for, -1 for off the board
+ * @param inside the first sum whose col is on the board, the ones from there to outside are for the cols in order
+ * @param outside one past the last sum on the board
+ * @param span the number of sums
+ * @param row the row to add, it may be off the board
+ * @param sign 1 to add the row, -1 to take it away
+ */
+static void sum_row(struct grid_t *grid, int *sums, const int *map, int inside, int outside, int span, int row, int sign)
+{
+        int k;
+        int wrapped;
+        int flip = 0;
+        const unsigned char *cell;
+
+        if (row < 0 || row >= grid->rows) {
+                if (grid->edge != EDGE_TORUS && grid->edge != EDGE_KLEIN) {
+                        return; /* nothing lives past the hedge */
                 }
-        } else if (edge == 2) {
-                /* always goes from -1 to 1 */
-                for (i = -1; i < 2; i++) {
-                        for (j = -1; j < 2; j++) {
-                                start_posX = (row_alive + i < 0) ? row_matrix : (row_alive + i > row_matrix) ? 0 : row_alive + i;
-                                start_posY = (col_alive + j < 0) ? col_matrix : (col_alive + j > col_matrix) ? 0 : col_alive + j;
-
-                                if (start_posX == row_alive && start_posY == col_alive) { /* based on if it is an edge cell check the appropriate oposite edge */
-                                        continue;
-                                } else if (matrix[start_posX][start_posY] == 1) {
-                                        count++;
-                                }
-                                
+                wrapped = (row % grid->rows + grid->rows) % grid->rows;
+                flip = (grid->edge == EDGE_KLEIN) && (((row - wrapped) / grid->rows) & 1);
+                row = wrapped;
+        }
+        cell = grid->cell[row];
+
+        /* only the sums past the sides go through the map, the rest is a straight run that vectorizes */
+        if (flip) { /* the klein bottle flips the col of a row that comes around the top or bottom */
+                for (k = 0; k < span; k++) {
+                        if (k == inside) {
+                                k = outside - 1;
+                                continue;
                         }
+                        sums[k] += sign * (map[k] >= 0 && cell[grid->cols - 1 - map[k]] == 1);
                 }
-                
-        } else if (edge == 3) {
-                for (i = -1; i < 2; i++) {
-                        for (j = -1; j < 2; j++) {
-                                start_posX = (row_alive + i < 0) ? row_matrix : (row_alive + i > row_matrix) ? 0 : row_alive + i;
-                                start_posY = (col_alive + j < 0) ? col_matrix : (col_alive + j > col_matrix) ? 0 : col_alive + j;
-
-                                if ((start_posX == row_matrix || start_posX == 0) && row_alive + i != start_posX) {
-                                        start_posY = (start_posY == col_matrix || start_posY == 0) ? col_matrix - start_posY : col_matrix - start_posY;
-                                }
-
-                                if (start_posX == row_alive && start_posY == col_alive) { /* based on if it is an edge cell check the appropriate oposite edge */
-                                        continue;
-                                } else if (matrix[start_posX][start_posY] == 1) {
-                                        count++;
-                                }
-                                
+                cell += grid->cols - 1 - map[inside];
+                for (k = inside; k < outside; k++) {
+                        sums[k] += sign * (cell[inside - k] == 1);
+                }
+        } else {
+                for (k = 0; k < span; k++) {
+                        if (k == inside) {
+                                k = outside - 1;
+                                continue;
                         }
+                        sums[k] += sign * (map[k] >= 0 && cell[map[k]] == 1);
+                }
+                cell += map[inside] - inside;
+                for (k = inside; k < outside; k++) {
+                        sums[k] += sign * (cell[k] == 1);
                 }
         }
-        return count;
 }
 
 /**
- * changes the board based on the basic rules of the game of life
- * @param **prev_matrix the matrix to be checked for alive and dead cells
- * @param **next_matrix the matrix to be filled based on the number of alive cells surrounding it
- * @param row the row to be changed
- * @param col the col to be changed
- * @param count_surroundings the number of surrounding cells that are alive
- * @return next_matrix the matrix that was updated based on the surroundings
+ * Steps a block of a Larger than Life rule. The count of every cell is a square radius out, so the
+ * block keeps a sum for every col of the square's rows and slides it down a row at a time, then slides
+ * a window across those sums, which makes the cost of a cell the same whatever the radius is
+ * @param *grid the grid holding the current generation, fill_ghost must have been called on it for the edge
+ * @param *next_grid the grid to be filled with the next generation
+ * @param first the first row to step
+ * @param last one past the last row to step
+ * @param col the first col to step
+ * @param width the number of cols to step
  */
-unsigned char **change_board(unsigned char **prev_matrix, unsigned char **next_matrix, int row, int col, int count_surroundings)
+static void step_wide(struct grid_t *grid, struct grid_t *next_grid, int first, int last, int col, int width)
 {
-        if (count_surroundings > 3) {
-                next_matrix[row][col] = 0;
-        } else if (count_surroundings >= 2 && count_surroundings <= 3 && prev_matrix[row][col] == 1) {
-                next_matrix[row][col] = 1;
-        } else if (count_surroundings == 3 && prev_matrix[row][col] == 0) {
-                next_matrix[row][col] = 1;
-        } else if (count_surroundings < 2) {
-                next_matrix[row][col] = 0;
+        int i;
+        int j;
+        int k;
+        int count;
+        int state;
+        int born;
+        int stays;
+        int radius = life_rule.radius;
+        int span = width + 2 * radius;
+        int inside = (col < radius) ? radius - col : 0; /* the sums from inside to outside are on the board */
+        int outside = (col + width + radius > grid->cols) ? grid->cols - col + radius : span;
+        int *sums = calloc(span, sizeof(int));
+        int *map = malloc(sizeof(int) * span);
+        const unsigned char *here;
+
+        if (!sums || !map) {
+                printf("Malloc failed exiting\n");
+                exit(1);
         }
-        return next_matrix;
 
+        for (k = 0; k < span; k++) {
+                j = col - radius + k;
+                if (j < 0 || j >= grid->cols) {
+                        j = (grid->edge == EDGE_TORUS || grid->edge == EDGE_KLEIN) ? (j % grid->cols + grid->cols) % grid->cols : -1;
+                }
+                map[k] = j;
+        }
+
+        for (i = first - radius; i < first + radius; i++) {
+                sum_row(grid, sums, map, inside, outside, span, i, 1);
+        }
+
+        for (i = first; i < last; i++) {
+                sum_row(grid, sums, map, inside, outside, span, i + radius, 1);
+                here = grid->cell[i] + col;
+
+                count = 0;
+                for (k = 0; k < 2 * radius; k++) {
+                        count += sums[k];
+                }
+
+                for (j = 0; j < width; j++) {
+                        count += sums[j + 2 * radius];
+                        state = here[j];
+
+                        /* the square holds the cell itself, which only counts with M1 */
+                        born = (unsigned)(count - life_rule.birth_low) <= (unsigned)(life_rule.birth_high - life_rule.birth_low);
+                        stays = (unsigned)(count - (!life_rule.middle & (state == 1)) - life_rule.survive_low)
+                                <= (unsigned)(life_rule.survive_high - life_rule.survive_low);
+                        next_grid->cell[i][col + j] = ((state == 0 && born) || (state == 1 && stays)) ? 1 : life_rule.decay[state];
+
+                        count -= sums[j];
+                }
+
+                sum_row(grid, sums, map, inside, outside, span, i - radius, -1);
+        }
+
+        free(sums);
+        free(map);
+}
+
+/**
+ * Steps the cells in rows first to last - 1 and cols col to col + width - 1 of grid into next_grid
+ * @param *grid the grid holding the current generation, its ghost border must already be filled
+ * @param *next_grid the grid to be filled with the next generation
+ * @param first the first row to step
+ * @param last one past the last row to step
+ * @param col the first col to step
+ * @param width the number of cols to step
+ */
+void step_block(struct grid_t *grid, struct grid_t *next_grid, int first, int last, int col, int width)
+{
+        int i;
+        row_fn fn = (life_rule.states > 2) ? step_row_states : step_row;
+
+        if (life_rule.radius > 1) {
+                step_wide(grid, next_grid, first, last, col, width);
+                return;
+        }
+
+        for (i = first; i < last; i++) {
+                fn(grid->cell[i - 1] + col, grid->cell[i] + col, grid->cell[i + 1] + col, next_grid->cell[i] + col, width);
+        }
+}
+
+/**
+ * Checks every cell on the board and the adjacent cells around that cell
+ * @param *grid the grid to be checked
+ * @param *next_grid the grid to be filled with the next generation, every cell gets written so it does not need to be cleared
+ * @param *matrix_data a pointer to the main data for the matrix
+ */
+void check_board(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data)
+{
+        fill_ghost(grid, matrix_data->edge);
+        step_rows(grid, next_grid, 0, grid->rows);
+}
+
+/**
+ * works out where a cell from a file lands on a board of rows by cols with the given edge, the hedge
+ * moves it by min and a cell past it is invalid, the other edges bring it around the way they wrap
+ * @param rows the rows on the board
+ * @param cols the cols on the board
+ * @param edge the edge either hedge torus klein or cross, 1 2 3 or 5
+ * @param *row the row from the file, set to the row on the board
+ * @param *col the col from the file, set to the col on the board
+ * @param x the offset to the row that the user wanted
+ * @param y the offset to the col that the user wanted
+ * @param min the minimum value for the file, only the hedge uses it
+ */
+void board_position(int rows, int cols, int edge, int *row, int *col, int x, int y, int min)
+{
+        int r = *row;
+        int c = *col;
+
+        if (edge == EDGE_HEDGE) {
+                r += (min > 0) ? min : -min;
+                c += (min > 0) ? min : -min;
+
+                if (r + x >= rows || r + x < 0) {
+                        printf("Invalid starting x coordinates\n");
+                        exit(1);
+                } else if (c + y >= cols || c + y < 0) { /*if the offset makes it a point off the board it is invalid */
+                        printf("Invalid starting y coordinates\n");
+                        exit(1);
+                }
+                r += x;
+                c += y;
+        } else if (edge == EDGE_TORUS || edge == EDGE_KLEIN) {
+                /*changes the row based on what the user entered and uses the torus shape, the klein bottle flips the col every time the row wraps */
+                while (r + x < 0) {
+                        r += rows;
+                        c = (edge == EDGE_KLEIN) ? cols - c : c;
+                }
+
+                while (r + x >= rows) {
+                        r = r - rows;
+                        c = (edge == EDGE_KLEIN) ? cols - c : c;
+                }
+
+                while (c + y < 0) {
+                        c += cols;
+                }
+
+                while (c + y >= cols) {
+                        c = c - cols;
+                }
+                r += x;
+                c += y;
+        } else if (edge == EDGE_CROSS) {
+                r += x;
+                c += y;
+
+                /* every wrap brings one of them closer and leaves the other just as far off the board */
+                while (r < 0 || r >= rows || c < 0 || c >= cols) {
+                        if (r < 0 || r >= rows) {
+                                r += (r < 0) ? rows : -rows;
+                                c = cols - 1 - c;
+                        } else {
+                                c += (c < 0) ? cols : -cols;
+                                r = rows - 1 - r;
+                        }
+                }
+        }
+
+        *row = r;
+        *col = c;
 }
 
 /**
  * fills the board with a file on the hedge edge
- * @param **matrix the matrix to be filled with 1's
+ * @param *grid the grid to be filled with 1's
  * @param row the row to be filled
  * @param col the col to be filled
  * @param x the offset to the row that the user wanted
  * @param y the offset to the col that the user wanted
  * @param min the minimum value for the file which is being used to fill the board
- * @param row_matrix the maximum row in the matrix
- * @param col_matrix the maximum col in the matrix
- * @return matrix the filled board
+ * @param state the value to put in the cell, 1 for alive
+ * @return grid the filled board
  */
-unsigned char **fill_board(unsigned char **matrix, int row, int col, int x, int y, int min, int row_matrix, int col_matrix)
-{      
-        row += (min > 0) ? min : -min;
-        col += (min > 0) ? min : -min;
-
-        if (row + x > row_matrix || row + x < 0) {
-                printf("Invalid starting x coordinates\n");
-                exit(1);
-        } else if (col + y > col_matrix || col + y < 0) { /*if the offset makes it a point off the board it is invalid */
-                printf("Invalid starting y coordinates\n");
-                exit(1);
-        }
+struct grid_t *fill_board(struct grid_t *grid, int row, int col, int x, int y, int min, unsigned char state)
+{
+        board_position(grid->rows, grid->cols, EDGE_HEDGE, &row, &col, x, y, min);
+        grid->cell[row][col] = state;
 
-        matrix[row + x][col + y] = 1;
-        
-        return matrix;
+        return grid;
 }
 
 /**
  * fills the board based on a torus shape
- * @param **matrix the matrix to be filled
+ * @param *grid the grid to be filled
  * @param row the row at which to change
  * @param col the col at which to change
  * @param x the offset the user wants
  * @param y the offset of the y coordinate that the user wants
- * @param row_matrix the maximum row in the matrix
- * @param col_matrix the maximum col in the matrix
- * @return matrix the filled board
+ * @param state the value to put in the cell, 1 for alive
+ * @return grid the filled board
  */
-unsigned char **fill_board_torus(unsigned char **matrix, int row, int col, int x, int y, int row_matrix, int col_matrix)
+struct grid_t *fill_board_torus(struct grid_t *grid, int row, int col, int x, int y, unsigned char state)
 {
-        while (row + x < 0) {
-                row += row_matrix;
-        }
-
-        while (row + x >= row_matrix) {
-                row = row - row_matrix;
-        }
-
-        /*changes the row based on what the user entered and uses the torus shape */
-        while (col + y < 0) {
-                col = col_matrix + col;
-        } 
-        
-        while (col + y >= col_matrix) {
-                col = col - col_matrix;
-        }
+        board_position(grid->rows, grid->cols, EDGE_TORUS, &row, &col, x, y, 0);
+        grid->cell[row][col] = state;
 
-        matrix[row + x][col + y] = 1;
-        return matrix;
+        return grid;
 }
 
 /**
  * fills the board based off of a klein shape
- * @param **matrix the board to be filled with ones based on the row and cols
+ * @param *grid the board to be filled with ones based on the row and cols
  * @param row the row to fill the board at
  * @param col the col to fill the board at
  * @param x the x offset that the user wanted
  * @param y the y offset that the user wanted
- * @param row_matrix the total rows in the matrix
- * @param col_matrix the total cols in the matrix
- * @return the matrix which was filled with ones
+ * @param state the value to put in the cell, 1 for alive
+ * @return the grid which was filled with ones
  */
-unsigned char **fill_board_klein(unsigned char **matrix, int row, int col, int x, int y, int row_matrix, int col_matrix) 
+struct grid_t *fill_board_klein(struct grid_t *grid, int row, int col, int x, int y, unsigned char state)
 {
-        while (row + x < 0) {
-                row += row_matrix;
-                col = col_matrix - col;
-        }
-
-        while (row + x >= row_matrix) {
-                row = row - row_matrix;
-                col = col_matrix - col;
-        }
-
-        while (col + y < 0) {
-                col += col_matrix;
-        }
-
-        while (col + y >= row_matrix) {
-                col = col - col_matrix;
-        }
-
-        matrix[row + x][col + y] = 1;
+        board_position(grid->rows, grid->cols, EDGE_KLEIN, &row, &col, x, y, 0);
+        grid->cell[row][col] = state;
 
-        return matrix;
+        return grid;
 }
 
 /**
- * sets a matrix to all zeros
- * @param **matrix the matrix to be set to zero
- * @param rows the number of rows in the matrix
- * @param cols the number of cols in the matris
+ * fills the board based off of a cross surface, a cell wrapped over the top or bottom has its col
+ * flipped and one wrapped over the left or right has its row flipped
+ * @param *grid the board to be filled
+ * @param row the row to fill the board at
+ * @param col the col to fill the board at
+ * @param x the x offset that the user wanted
+ * @param y the y offset that the user wanted
+ * @param state the value to put in the cell, 1 for alive
+ * @return the grid which was filled
  */
-void set_zero(unsigned char **matrix, int rows, int cols)
+struct grid_t *fill_board_cross(struct grid_t *grid, int row, int col, int x, int y, unsigned char state)
 {
-        int i;
-        int j;
+        board_position(grid->rows, grid->cols, EDGE_CROSS, &row, &col, x, y, 0);
+        grid->cell[row][col] = state;
 
-        for (i = 0; i < rows; i++) {
-                for (j = 0; j < cols; j++) { /*walks through making each cell 0 */
-                        matrix[i][j] = 0;
-                }
-        }
+        return grid;
 }
 
 /**
- * finds the minimum value, used when filling a hedge matrix
- * @param *starting_condition the file that is going to be used to fill the board
- * @param *buf a character buffer to read in the file
- * @return the min of the file
+ * sets a grid to all zeros, ghost border included
+ * @param *grid the grid to be set to zero
  */
-int find_min_hedge(FILE *starting_condition, char *buf)
+void set_zero(struct grid_t *grid)
 {
-        int min = 1000;
-        int first;
-        int second;
-        int i;
+        memset(grid->block, 0, (size_t)grid->stride * (grid->rows + 2));
+}
 
-        while (fgets(buf, SIZE, starting_condition)) { /*starts reading the file line by line */
-                if (buf[0] == '#') {
-                        continue;
-                }
+/**
+ * copies one grid onto another of the same size, ghost border included
+ * @param *grid the grid to be copied onto
+ * @param *from the grid to copy
+ */
+void copy_grid(struct grid_t *grid, struct grid_t *from)
+{
+        memcpy(grid->block, from->block, (size_t)grid->stride * (grid->rows + 2));
+}
 
-                i = SIZE;
-                while (isspace(buf[i])) {
-                        buf[i] = '\0'; /*remove white space */
-                        i--;
-                }
-                first = atoi(strtok(buf, " "));
-                second = atoi(strtok(NULL, "\0")); /*break apart the file and store in ints */
-                /* determine what min is */
-                min = (first <= second) ? (first <= min) ? first : min : (second <= min) ? second : min;
+/**
+ * fills one cell of the grid held in a place_t based on the edge the user wanted
+ * @param *target the place_t
+ * @param row the row from the file
+ * @param col the col from the file
+ */
+static void place_cell(void *target, long long row, long long col)
+{
+        struct place_t *place = target;
+        unsigned char state = (place->states) ? place->states[place->index++] : 1;
+
+        if (place->edge == EDGE_HEDGE) {
+                fill_board(place->grid, row, col, place->x, place->y, place->min, state);
+        } else if (place->edge == EDGE_TORUS) {
+                fill_board_torus(place->grid, row, col, place->x, place->y, state);
+        } else if (place->edge == EDGE_KLEIN) {
+                fill_board_klein(place->grid, row, col, place->x, place->y, state);
+        } else if (place->edge == EDGE_CROSS) {
+                fill_board_cross(place->grid, row, col, place->x, place->y, state);
         }
-
-        /*close the file pointer */
-        fclose(starting_condition);
-        return min;
 }
 
 /**
- * walks through a life 106 file and takes out the coordinates, fills a board based on the edge
- * @param *starting_condition a file pointer to the file that is being used to fill the board
- * @param **matrix the matrix to fill with the file instructions
- * @param *filepath the filepath for the file, and for the starting_condition to point to
+ * reads a pattern file of any format load_pattern knows and fills a board based on the edge
+ * @param *grid the grid to fill with the file instructions
+ * @param *filepath the filepath for the file
  * @param x the offset for the x value that the user entered
  * @param y the offset for the y value that the user entered
  * @param *matrix_data a pointer to the structure containing the main data for the matrices
+ * @param *rule where the rule named in the file is copied, RULE_SIZE chars and left empty if there is none, may be NULL
+ * @return 0 on success, -1 if the file could not be read
  */
-void parse_file(FILE *starting_condition, char *buf, unsigned char **matrix, char *filepath, int x, int y, struct data_t *matrix_data)
+int parse_file(struct grid_t *grid, char *filepath, int x, int y, struct data_t *matrix_data, char *rule)
 {
-        int first;
-        int second;
-        int i;
-        
-        int min = find_min_hedge(starting_condition, buf);
+        struct place_t place = { grid, x, y, 1000, matrix_data->edge, NULL, 0 };
+        struct pattern_t pattern;
 
-        starting_condition = fopen(filepath, "r");
+        if (load_pattern(filepath, &pattern) == -1) {
+                return -1;
+        }
 
-        while (fgets(buf, SIZE, starting_condition)) { /*walks through the file that is opened */
-                if (buf[0] == '#') {
-                        continue;
-                }
+        /* the hedge moves the pattern by the smallest coordinate in it, capped at 1000, the bounding box already has it */
+        if (pattern.count > 0) {
+                place.min = (pattern.min_row < place.min) ? pattern.min_row : place.min;
+                place.min = (pattern.min_col < place.min) ? pattern.min_col : place.min;
+        }
 
-                i = SIZE;
-                while (isspace(buf[i])) { /*removes white space */
-                        buf[i] = '\0';
-                        i--;
-                }
-                first = atoi(strtok(buf, " "));
-                second = atoi(strtok(NULL, "\0")); /*breaks up the buf based on a space and stores the coordinates in two ints */
-                if(matrix_data->edge == 1) {
-                        matrix = fill_board(matrix, first, second, x, y, min, matrix_data->row_matrix, matrix_data->col_matrix); /*fills board based on the edge the user wanted */
-                } else if (matrix_data->edge == 2) {
-                        matrix = fill_board_torus(matrix, first, second, x, y, matrix_data->row_matrix, matrix_data->col_matrix);
-                } else if (matrix_data->edge == 3) {
-                        matrix = fill_board_klein(matrix, first, second, x, y, matrix_data->row_matrix, matrix_data->col_matrix);
-                }
+        if (rule) {
+                strcpy(rule, pattern.rule);
         }
 
-        fclose(starting_condition);
+        place.states = pattern.states;
+        pattern_cells(&pattern, place_cell, &place);
+        free_pattern(&pattern);
+
+        return 0;
 }
 
 void init_struct(struct data_t *matrix_data)
@@ -382,6 +893,12 @@ void init_struct(struct data_t *matrix_data)
         matrix_data->width = 1280;
         matrix_data->height = 720;
         matrix_data->edge = 1;
+        matrix_data->engine = ENGINE_BYTE;
+        matrix_data->threads = 1;
+        matrix_data->depth = 1;
+        matrix_data->map = NULL;
+        strcpy(matrix_data->rule, "B3/S23");
+        matrix_data->rule_given = 0;
         matrix_data->row_matrix = matrix_data->width / matrix_data->sprite_size;
         matrix_data->col_matrix = matrix_data->height / matrix_data->sprite_size;
 }
@@ -2,7 +2,9 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
 #define SIZE 4096
+#define GRID_ALIGN 64
 
 /**
  * @file life.h
@@ -16,37 +18,172 @@
 #ifndef LIFE_H_
 #define LIFE_H_
 
+#define EDGE_HEDGE 1
+#define EDGE_TORUS 2
+#define EDGE_KLEIN 3
+#define EDGE_PLANE 4
+#define EDGE_CROSS 5 /* the projective plane, leaving through any side comes back on the other side flipped */
+
+#define ENGINE_BYTE 1
+#define ENGINE_PACKED 2
+#define ENGINE_ACTIVE 3
+#define ENGINE_SPARSE 4
+
+#define RULE_SIZE 64
+#define RULE_STATES 256
+#define RULE_MAX_RADIUS 500
+
+/* one count of neighbors a rule does something with, ones to eights are all 1 bits where
+ * that bit of the count is set so a bit sliced count can be matched against them, born
+ * and stays are all 1 bits if a dead cell is born or an alive cell stays alive with it */
+struct rule_term_t {
+        uint64_t ones;
+        uint64_t twos;
+        uint64_t fours;
+        uint64_t eights;
+        uint64_t born;
+        uint64_t stays;
+};
+
+/* an outer totalistic rule, bit n of birth is set if a dead cell with n alive neighbors is
+ * born and bit n of survive if an alive cell with n stays alive. parse_rule compiles it into
+ * next, looked up as next[alive][count] by the byte kernels, and into the terms the bit
+ * sliced engines test for, so stepping never branches on the rule.
+ * A Generations rule has more than 2 states, cell value 1 is alive and is the only state
+ * counted as a neighbor, an alive cell that does not survive goes to 2 and counts up through
+ * the dying states to 0, which decay holds the next value of. A Larger than Life rule counts
+ * the square of cells radius out, the cell itself too if middle is set, and is born or
+ * survives on the counts from low to high instead of the bits of birth and survive */
+struct rule_t {
+        unsigned short birth;
+        unsigned short survive;
+        unsigned char next[2][16];
+        int terms;
+        struct rule_term_t term[9];
+        int states;
+        int radius;
+        int middle;
+        int birth_low;
+        int birth_high;
+        int survive_low;
+        int survive_high;
+        unsigned char decay[RULE_STATES];
+        char text[RULE_SIZE];
+};
+
 struct data_t {
         int row_matrix;
         int col_matrix;
         int edge;
+        int engine;
+        int threads;
+        int depth; /* generations the byte engine steps for every pass over the board, 1 for one at a time */
+        char *map; /* the packed engine keeps its boards in this file with .0 and .1 after it, NULL for memory */
         int height;
         int width;
         int sprite_size;
         unsigned char red;
         unsigned char green;
         unsigned char blue;
+        char rule[RULE_SIZE];
+        int rule_given;
+};
+
+/* a board kept in one GRID_ALIGN aligned block with a one cell ghost border.
+ * stride is the distance in bytes between two rows and is padded to GRID_ALIGN,
+ * cell[i][j] is valid for -1 <= i <= rows and -1 <= j <= cols so the row
+ * pointers can still be handed to code that wants an unsigned char ** */
+struct grid_t {
+        int rows;
+        int cols;
+        int stride;
+        int edge; /* the edge fill_ghost last filled the border for, rules reaching past it wrap the same way */
+        unsigned char *block;
+        unsigned char **cell;
 };
 
-unsigned char **init_matrix(int rows, int cols);
+/**
+ * scrambles the bits of a word, the finalizer of splitmix64
+ * @param x the word
+ * @return the scrambled word
+ */
+static inline uint64_t hash_mix(uint64_t x)
+{
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+}
+
+/**
+ * gets the key a word of cells is hashed with from where it is on the board
+ * @param where any number that is different for every word of the board
+ * @return the key for hash_word
+ */
+static inline uint64_t hash_key(uint64_t where)
+{
+        return hash_mix(where + 0x9e3779b97f4a7c15ULL);
+}
+
+/**
+ * hashes one word of cells with the key for where it is. A board hashes to these XORed
+ * together over all of its words, and an all dead word hashes to 0, so the hash can be
+ * kept up to date by XORing out the old and in the new hash of only the words that changed
+ * @param word the cells
+ * @param key from hash_key
+ * @return the hash of the word
+ */
+static inline uint64_t hash_word(uint64_t word, uint64_t key)
+{
+        uint64_t x = (word ^ key) * 0xbf58476d1ce4e5b9ULL;
+
+        return (x ^ (x >> 31)) & -(uint64_t) (word != 0);
+}
+
+/* steps cols cells of one row, the pointers are to the first cell and [-1] is always readable */
+typedef void (*row_fn)(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols);
+
+struct grid_t *init_grid(int rows, int cols);
+
+void free_grid(struct grid_t *grid);
+
+void fill_ghost(struct grid_t *grid, int edge);
+
+void check_board(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data);
+
+void step_row_scalar(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols);
+
+void set_row_kernel(row_fn fn);
+
+int parse_rule(const char *text, struct rule_t *rule);
+
+void set_rule(const struct rule_t *rule);
+
+const struct rule_t *get_rule(void);
+
+int rule_is_bits(const struct rule_t *rule);
+
+void step_rows(struct grid_t *grid, struct grid_t *next_grid, int first, int last);
+
+void step_block(struct grid_t *grid, struct grid_t *next_grid, int first, int last, int col, int width);
 
-void check_board(unsigned char **matrix, unsigned char **next_matrix, struct data_t *matrix_data);
+void board_position(int rows, int cols, int edge, int *row, int *col, int x, int y, int min);
 
-int check_surrounding(unsigned char **matrix, int row_alive, int col_alive, int row_matrix, int col_matrix, int edge);
+struct grid_t *fill_board(struct grid_t *grid, int row, int col, int x, int y, int min, unsigned char state);
 
-unsigned char **change_board(unsigned char **prev_matrix, unsigned char **next_matrix, int row, int col, int count_surrounding);
+void set_zero(struct grid_t *grid);
 
-unsigned char **fill_board(unsigned char **matrix, int row, int col, int x, int y, int min, int row_matrix, int col_matrix);
+void copy_grid(struct grid_t *grid, struct grid_t *from);
 
-void set_zero(unsigned char **matrix, int rows, int cols);
+struct grid_t *fill_board_torus(struct grid_t *grid, int row, int col, int x, int y, unsigned char state);
 
-unsigned char **fill_board_torus(unsigned char **matrix, int row, int col, int x, int y, int row_matrix, int col_matrix);
+struct grid_t *fill_board_klein(struct grid_t *grid, int row, int col, int x, int y, unsigned char state);
 
-unsigned char **fill_board_klein(unsigned char **matrix, int row, int col, int x, int y, int row_matrix, int col_matrix); 
+struct grid_t *fill_board_cross(struct grid_t *grid, int row, int col, int x, int y, unsigned char state);
 
-int find_min_hedge(FILE *starting_condition, char *buf);
+/* called for every alive cell a pattern reader finds */
+typedef void (*cell_fn)(void *target, long long row, long long col);
 
-void parse_file(FILE *starting_condition, char *buf, unsigned char **matrix, char *filepath, int x, int y, struct data_t *matrix_data);
+int parse_file(struct grid_t *grid, char *filepath, int x, int y, struct data_t *matrix_data, char *rule);
 
 void init_struct(struct data_t *matrix_data);
 #endif
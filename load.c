@@ -0,0 +1,459 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "load.h"
+
+/**
+ * @file load.c
+ * @breif Reads RLE, life 1.05, plaintext .cells and life 1.06 pattern files in one pass
+ * @details The file is mapped into memory and walked once, numbers are read straight out of the mapping and every alive cell is added to a pattern_t along with the bounding box, so nothing is ever copied into a string. RLE files from multi-state rules keep the state of every cell, A to X and pA to yO, the others are all state 1. The format is worked out from the first line that is not a comment. The mapping is not NUL terminated, so every read checks against the end of the file.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* where a parse is in the mapped file */
+struct cursor_t {
+        const char *at;
+        const char *end;
+};
+
+/**
+ * adds one cell to a pattern, growing it if needed
+ * @param *pattern the pattern
+ * @param row the row, the x of the file
+ * @param col the col, the y of the file
+ * @param state the state of the cell, 1 for alive
+ * @return 0, or -1 if it could not grow
+ */
+static int add_cell(struct pattern_t *pattern, int row, int col, int state)
+{
+        int *cells;
+        unsigned char *states;
+
+        if (pattern->count == pattern->capacity) {
+                pattern->capacity = (pattern->capacity) ? pattern->capacity * 2 : 1024;
+                cells = realloc(pattern->cells, sizeof(int) * 2 * pattern->capacity);
+
+                if (!cells) {
+                        printf("Malloc failed\n");
+                        return -1;
+                }
+                pattern->cells = cells;
+
+                if (pattern->states) {
+                        states = realloc(pattern->states, pattern->capacity);
+
+                        if (!states) {
+                                printf("Malloc failed\n");
+                                return -1;
+                        }
+                        pattern->states = states;
+                }
+        }
+
+        if (state != 1 && !pattern->states) {
+                /* the first cell that is not just alive, every cell before it was */
+                pattern->states = malloc(pattern->capacity);
+
+                if (!pattern->states) {
+                        printf("Malloc failed\n");
+                        return -1;
+                }
+                memset(pattern->states, 1, pattern->count);
+        }
+
+        if (pattern->states) {
+                pattern->states[pattern->count] = state;
+        }
+
+        if (pattern->count == 0) {
+                pattern->min_row = pattern->max_row = row;
+                pattern->min_col = pattern->max_col = col;
+        }
+
+        pattern->min_row = (row < pattern->min_row) ? row : pattern->min_row;
+        pattern->max_row = (row > pattern->max_row) ? row : pattern->max_row;
+        pattern->min_col = (col < pattern->min_col) ? col : pattern->min_col;
+        pattern->max_col = (col > pattern->max_col) ? col : pattern->max_col;
+
+        pattern->cells[2 * pattern->count] = row;
+        pattern->cells[2 * pattern->count + 1] = col;
+        pattern->count++;
+
+        return 0;
+}
+
+/**
+ * moves past spaces and tabs, not newlines
+ * @param *cursor the cursor
+ */
+static void skip_blanks(struct cursor_t *cursor)
+{
+        while (cursor->at < cursor->end && (*cursor->at == ' ' || *cursor->at == '\t' || *cursor->at == '\r')) {
+                cursor->at++;
+        }
+}
+
+/**
+ * moves to the start of the next line
+ * @param *cursor the cursor
+ */
+static void next_line(struct cursor_t *cursor)
+{
+        const char *newline = memchr(cursor->at, '\n', cursor->end - cursor->at);
+
+        cursor->at = (newline) ? newline + 1 : cursor->end;
+}
+
+/**
+ * reads a number with an optional sign
+ * @param *cursor the cursor, left after the number
+ * @param *value set to the number
+ * @return 1 if there was a number, 0 if not
+ */
+static int read_number(struct cursor_t *cursor, int *value)
+{
+        int sign = 1;
+        long long number = 0;
+        const char *start;
+
+        skip_blanks(cursor);
+        if (cursor->at < cursor->end && (*cursor->at == '-' || *cursor->at == '+')) {
+                sign = (*cursor->at == '-') ? -1 : 1;
+                cursor->at++;
+        }
+
+        start = cursor->at;
+        while (cursor->at < cursor->end && isdigit((unsigned char)*cursor->at)) {
+                number = number * 10 + (*cursor->at - '0');
+                cursor->at++;
+        }
+
+        *value = (int)(sign * number);
+        return cursor->at != start;
+}
+
+/**
+ * copies the rest of a line into the rule of a pattern, without the spaces around it
+ * @param *pattern the pattern
+ * @param *cursor the cursor at the start of the rule, left at the end of the line
+ */
+static void read_rule(struct pattern_t *pattern, struct cursor_t *cursor)
+{
+        size_t length = 0;
+
+        skip_blanks(cursor);
+        while (cursor->at < cursor->end && *cursor->at != '\n' && *cursor->at != '\r' && *cursor->at != ','
+                        && *cursor->at != ' ' && length < sizeof(pattern->rule) - 1) {
+                pattern->rule[length++] = *cursor->at++;
+        }
+        pattern->rule[length] = '\0';
+}
+
+/**
+ * works out which format a file is from its first line that is not a comment
+ * @param *cursor the cursor at the start of the file, left where it was
+ * @return one of the FORMAT_ values
+ */
+static int find_format(struct cursor_t *cursor)
+{
+        struct cursor_t look = *cursor;
+        size_t left = look.end - look.at;
+
+        if (left >= 10 && strncmp(look.at, "#Life 1.06", 10) == 0) {
+                return FORMAT_106;
+        } else if (left >= 10 && strncmp(look.at, "#Life 1.05", 10) == 0) {
+                return FORMAT_105;
+        }
+
+        while (look.at < look.end) {
+                skip_blanks(&look);
+
+                if (look.at == look.end || *look.at == '#' || *look.at == '!' || *look.at == '\n') {
+                        next_line(&look);
+                } else if (*look.at == 'x') {
+                        return FORMAT_RLE; /* the x = , y = header */
+                } else if (*look.at == '-' || *look.at == '+' || isdigit((unsigned char)*look.at)) {
+                        return FORMAT_106;
+                } else {
+                        return FORMAT_CELLS;
+                }
+        }
+
+        return FORMAT_106;
+}
+
+/**
+ * reads a life 1.06 file, one x y pair a line
+ * @param *pattern the pattern to fill
+ * @param *cursor the cursor at the start of the file
+ * @return 0, or -1 if the pattern could not grow
+ */
+static int read_106(struct pattern_t *pattern, struct cursor_t *cursor)
+{
+        int row;
+        int col;
+
+        while (cursor->at < cursor->end) {
+                if (*cursor->at != '#' && read_number(cursor, &row) && read_number(cursor, &col)) {
+                        if (add_cell(pattern, row, col, 1) == -1) {
+                                return -1;
+                        }
+                }
+                next_line(cursor);
+        }
+
+        return 0;
+}
+
+/**
+ * reads a row of . and * or O cells, anything else on the line is dead
+ * @param *pattern the pattern to fill
+ * @param *cursor the cursor at the start of the row, left at the start of the next line
+ * @param row the row of the first cell
+ * @param col the col of the whole row
+ * @return 0, or -1 if the pattern could not grow
+ */
+static int read_picture(struct pattern_t *pattern, struct cursor_t *cursor, int row, int col)
+{
+        while (cursor->at < cursor->end && *cursor->at != '\n') {
+                if ((*cursor->at == '*' || *cursor->at == 'O') && add_cell(pattern, row, col, 1) == -1) {
+                        return -1;
+                }
+                row++;
+                cursor->at++;
+        }
+        next_line(cursor);
+
+        return 0;
+}
+
+/**
+ * reads a life 1.05 file, blocks of . and * each placed by the #P line before them
+ * @param *pattern the pattern to fill
+ * @param *cursor the cursor at the start of the file
+ * @return 0, or -1 if the pattern could not grow
+ */
+static int read_105(struct pattern_t *pattern, struct cursor_t *cursor)
+{
+        int row = 0;
+        int col = 0;
+        size_t left;
+
+        while (cursor->at < cursor->end) {
+                left = cursor->end - cursor->at;
+
+                if (left >= 2 && strncmp(cursor->at, "#P", 2) == 0) {
+                        cursor->at += 2;
+                        read_number(cursor, &row);
+                        read_number(cursor, &col);
+                        next_line(cursor);
+                } else if (left >= 2 && strncmp(cursor->at, "#R", 2) == 0) {
+                        cursor->at += 2;
+                        read_rule(pattern, cursor);
+                        next_line(cursor);
+                } else if (*cursor->at == '#') {
+                        next_line(cursor);
+                } else if (read_picture(pattern, cursor, row, col++) == -1) {
+                        return -1;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * reads a plaintext .cells file, ! lines are comments
+ * @param *pattern the pattern to fill
+ * @param *cursor the cursor at the start of the file
+ * @return 0, or -1 if the pattern could not grow
+ */
+static int read_cells(struct pattern_t *pattern, struct cursor_t *cursor)
+{
+        int col = 0;
+
+        while (cursor->at < cursor->end) {
+                if (*cursor->at == '!') {
+                        next_line(cursor);
+                } else if (read_picture(pattern, cursor, 0, col++) == -1) {
+                        return -1;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * reads an RLE file, the x = , y = , rule = header then runs of b, o and $ up to !
+ * @param *pattern the pattern to fill
+ * @param *cursor the cursor at the start of the file
+ * @return 0, or -1 if the pattern could not grow
+ */
+static int read_rle(struct pattern_t *pattern, struct cursor_t *cursor)
+{
+        int row = 0;
+        int col = 0;
+        int run = 0;
+        int i;
+        int state;
+        char c;
+        const char *rule;
+        const char *line;
+
+        /* comments and the header */
+        while (cursor->at < cursor->end) {
+                skip_blanks(cursor);
+
+                if (cursor->at < cursor->end && *cursor->at == 'x') {
+                        line = memchr(cursor->at, '\n', cursor->end - cursor->at);
+                        line = (line) ? line : cursor->end;
+
+                        rule = cursor->at;
+                        while (rule + 4 <= line && strncmp(rule, "rule", 4) != 0) {
+                                rule++;
+                        }
+
+                        if (rule + 4 <= line) {
+                                cursor->at = rule + 4;
+                                skip_blanks(cursor);
+                                cursor->at += (cursor->at < cursor->end && *cursor->at == '=');
+                                read_rule(pattern, cursor);
+                        }
+                        next_line(cursor);
+                        break;
+                }
+                next_line(cursor);
+        }
+
+        while (cursor->at < cursor->end) {
+                c = *cursor->at++;
+
+                if (isdigit((unsigned char)c)) {
+                        run = run * 10 + (c - '0');
+                        continue;
+                } else if (isspace((unsigned char)c)) {
+                        continue; /* lines can break between a run and its letter */
+                } else if (c == '!') {
+                        break;
+                } else if (c == '$') {
+                        col += (run) ? run : 1;
+                        row = 0;
+                } else if (c == 'b' || c == '.') {
+                        row += (run) ? run : 1;
+                } else if (isalpha((unsigned char)c)) {
+                        /* o, or A to X for states 1 to 24 of a many state rule, p to y start a two letter state
+                         * that goes on from 25 in steps of 24. Any other letter is taken as alive */
+                        state = (c >= 'A' && c <= 'X') ? c - 'A' + 1 : 1;
+
+                        if (c >= 'p' && c <= 'y' && cursor->at < cursor->end) {
+                                state = (c - 'p' + 1) * 24 + (*cursor->at - 'A' + 1);
+                                state = (state < 1 || state > 255) ? 1 : state;
+                                cursor->at++;
+                        }
+
+                        for (i = 0; i < ((run) ? run : 1); i++) {
+                                if (add_cell(pattern, row++, col, state) == -1) {
+                                        return -1;
+                                }
+                        }
+                } else if (c == '#') {
+                        next_line(cursor);
+                }
+                run = 0;
+        }
+
+        return 0;
+}
+
+/**
+ * reads a pattern file of any format load_pattern knows
+ * @param *filepath the file to read
+ * @param *pattern the pattern to fill, should be zeroed
+ * @return 0 on success, -1 if the file could not be opened or read or the pattern could not grow
+ */
+int load_pattern(char *filepath, struct pattern_t *pattern)
+{
+        int fd = open(filepath, O_RDONLY);
+        int result = 0;
+        struct stat info;
+        void *map;
+        struct cursor_t cursor;
+
+        memset(pattern, 0, sizeof(struct pattern_t));
+
+        if (fd == -1) {
+                return -1;
+        }
+
+        if (fstat(fd, &info) == -1) {
+                close(fd);
+                return -1;
+        }
+
+        if (info.st_size == 0) {
+                close(fd);
+                pattern->format = FORMAT_106;
+                return 0;
+        }
+
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (map == MAP_FAILED) {
+                return -1;
+        }
+        madvise(map, info.st_size, MADV_SEQUENTIAL);
+
+        cursor.at = map;
+        cursor.end = cursor.at + info.st_size;
+        pattern->format = find_format(&cursor);
+
+        if (pattern->format == FORMAT_105) {
+                result = read_105(pattern, &cursor);
+        } else if (pattern->format == FORMAT_RLE) {
+                result = read_rle(pattern, &cursor);
+        } else if (pattern->format == FORMAT_CELLS) {
+                result = read_cells(pattern, &cursor);
+        } else {
+                result = read_106(pattern, &cursor);
+        }
+
+        munmap(map, info.st_size);
+
+        if (result == -1) {
+                free_pattern(pattern);
+        }
+
+        return result;
+}
+
+/**
+ * frees the cells of a pattern
+ * @param *pattern the pattern
+ */
+void free_pattern(struct pattern_t *pattern)
+{
+        free(pattern->cells);
+        free(pattern->states);
+        pattern->cells = NULL;
+        pattern->states = NULL;
+        pattern->count = 0;
+        pattern->capacity = 0;
+}
+
+/**
+ * hands every cell of a pattern to fn
+ * @param *pattern the pattern
+ * @param fn called for each cell
+ * @param *target passed on to fn
+ */
+void pattern_cells(struct pattern_t *pattern, cell_fn fn, void *target)
+{
+        long long i;
+
+        for (i = 0; i < pattern->count; i++) {
+                fn(target, pattern->cells[2 * i], pattern->cells[2 * i + 1]);
+        }
+}
@@ -0,0 +1,43 @@
+#include "life.h"
+
+/**
+ * @file load.h
+ * @breif headers for reading pattern files in every format we take, in load.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef LOAD_H_
+#define LOAD_H_
+
+/* the formats load_pattern knows */
+#define FORMAT_106 1
+#define FORMAT_105 2
+#define FORMAT_RLE 3
+#define FORMAT_CELLS 4
+
+/* cells are stored two ints at a time, the row then the col. the row is the x of the file, across,
+ * and the col the y, down, the same way life 106 files are read. states holds the state of each
+ * cell when an RLE file for a many state rule has any other than 1, otherwise it is NULL. rule is
+ * whatever rule the file asked for, empty if it did not say */
+struct pattern_t {
+        int *cells;
+        unsigned char *states;
+        long long count;
+        long long capacity;
+        int min_row;
+        int min_col;
+        int max_row;
+        int max_col;
+        int format;
+        char rule[RULE_SIZE];
+};
+
+int load_pattern(char *filepath, struct pattern_t *pattern);
+
+void free_pattern(struct pattern_t *pattern);
+
+void pattern_cells(struct pattern_t *pattern, cell_fn fn, void *target);
+
+#endif
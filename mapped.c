@@ -0,0 +1,253 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "mapped.h"
+
+/**
+ * @file mapped.c
+ * @breif packed boards that live in a file instead of on the heap, for boards bigger than the memory of the machine
+ * @details map_packed makes a sparse file the size of a packed board and maps it shared, so the board costs disk and page cache instead of memory and a board with trillions of cells only needs the disk to hold it. A generation streams the current board front to back in bands of a few megabytes. Each band copies its rows out of the mapping three at a time into a halo of its own, fills the ghost bits of the copies for the edge, and steps them straight into the mapping of the next board, so it holds only those three rows and the board it reads is never written. Both mappings are advised sequential so the kernel reads ahead and drops pages behind, a band asks for its rows before it starts on them and lets go of the pages of both boards once it is done, which keeps what the process has mapped in down to the bands being stepped. Bands only read the current board and only write their own rows of the next one, so they run on the pool with a halo for every thread.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* what every band of a generation needs */
+struct mapped_pass_t {
+        struct packed_t *packed;
+        struct packed_t *next_packed;
+        struct mapped_t *mapped;
+        int edge;
+        int band_rows;
+};
+
+/**
+ * Intilizes a packed board of rows by cols cells, all dead, in a file that is mapped in place of memory
+ * @param rows the amount of rows in the board
+ * @param cols the cols in the board
+ * @param *path the file to keep the board in, made or emptied
+ * @return the pointer to the board, or NULL if the file could not be made or mapped
+ */
+struct packed_t *map_packed(int rows, int cols, const char *path)
+{
+        int fd;
+        void *block;
+        struct packed_t *packed = malloc(sizeof(struct packed_t));
+
+        if (!packed) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        packed->rows = rows;
+        packed->cols = cols;
+        packed->words = (cols + 2 + 63) / 64; /* the same rows as init_packed, ghost rows included */
+        packed->mapped = sizeof(uint64_t) * packed->words * ((size_t)rows + 2);
+
+        /* a file that is only truncated to its size has no blocks yet, so every cell reads as dead */
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1 || ftruncate(fd, packed->mapped) == -1) {
+                printf("Could not make %s\n", path);
+                if (fd != -1) {
+                        close(fd);
+                }
+                free(packed);
+                return NULL;
+        }
+
+        block = mmap(NULL, packed->mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (block == MAP_FAILED) {
+                printf("Could not map %s\n", path);
+                free(packed);
+                return NULL;
+        }
+
+        madvise(block, packed->mapped, MADV_SEQUENTIAL);
+        packed->block = block;
+
+        return packed;
+}
+
+/**
+ * Intilizes the halo rows for stepping mapped boards
+ * @param words the words in each row of the boards
+ * @param threads the threads of the pool that will run the bands, 1 with no pool
+ * @return the halo, or NULL if an allocation failed
+ */
+struct mapped_t *init_mapped(int words, int threads)
+{
+        struct mapped_t *mapped = malloc(sizeof(struct mapped_t));
+
+        if (!mapped) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        mapped->threads = (threads < 1) ? 1 : threads;
+        mapped->words = words;
+        mapped->halo = malloc(sizeof(uint64_t) * MAPPED_HALO * words * mapped->threads);
+
+        if (!mapped->halo) {
+                printf("Malloc failed\n");
+                free(mapped);
+                return NULL;
+        }
+
+        return mapped;
+}
+
+/**
+ * frees the halo made by init_mapped
+ * @param *mapped the halo, may be NULL
+ */
+void free_mapped(struct mapped_t *mapped)
+{
+        if (!mapped) {
+                return;
+        }
+
+        free(mapped->halo);
+        free(mapped);
+}
+
+/**
+ * gives the kernel advice about rows first to last - 1 of a mapped board
+ * @param *packed the board
+ * @param first the first row, may be the ghost row -1
+ * @param last one past the last row, may be rows + 1
+ * @param advice MADV_WILLNEED to read them in, rounded out to whole pages, or MADV_DONTNEED to let them go,
+ * rounded in so the rows next to them are left alone
+ */
+static void advise_rows(struct packed_t *packed, int first, int last, int advice)
+{
+        uintptr_t page = sysconf(_SC_PAGESIZE);
+        uintptr_t start = (uintptr_t)PACKED_ROW(packed, first);
+        uintptr_t end = (uintptr_t)PACKED_ROW(packed, last);
+
+        if (advice == MADV_DONTNEED) {
+                start = (start + page - 1) & ~(page - 1);
+                end &= ~(page - 1);
+        } else {
+                start &= ~(page - 1);
+                end = (end + page - 1) & ~(page - 1);
+        }
+
+        if (end > start) {
+                madvise((void *)start, end - start, advice);
+        }
+}
+
+/**
+ * copies a row of a mapped board into the halo and fills its ghost bits the way fill_ghost_packed would
+ * @param *packed the board
+ * @param edge the edge either hedge torus klein or cross, 1 2 3 or 5
+ * @param row the row to copy, -1 and rows are the ghost rows
+ * @param *out where the row goes, words long
+ */
+static void fetch_row(struct packed_t *packed, int edge, int row, uint64_t *out)
+{
+        int pos;
+        int bit;
+        int rows = packed->rows;
+        int cols = packed->cols;
+        int wrap = edge != EDGE_HEDGE;
+        const uint64_t *side = out;
+
+        if (row < 0 || row >= rows) {
+                if (edge == EDGE_TORUS) {
+                        row = (row < 0) ? rows - 1 : 0;
+                } else if (edge == EDGE_KLEIN || edge == EDGE_CROSS) {
+                        /* the ghost row is the row on the other side read backwards, ghost bits included */
+                        fetch_row(packed, edge, (row < 0) ? rows - 1 : 0, out);
+
+                        for (pos = 0; pos < cols + 1 - pos; pos++) {
+                                bit = get_bit(out, pos);
+                                set_bit(out, pos, get_bit(out, cols + 1 - pos));
+                                set_bit(out, cols + 1 - pos, bit);
+                        }
+
+                        if (edge == EDGE_CROSS) { /* the corners are dead, the same as fill_ghost leaves them */
+                                set_bit(out, 0, 0);
+                                set_bit(out, cols + 1, 0);
+                        }
+                        return;
+                } else {
+                        memset(out, 0, sizeof(uint64_t) * packed->words);
+                        return;
+                }
+        }
+
+        memcpy(out, PACKED_ROW(packed, row), sizeof(uint64_t) * packed->words);
+
+        if (edge == EDGE_CROSS) {
+                side = PACKED_ROW(packed, rows - 1 - row); /* leaving through the left or right flips the row */
+        }
+        set_bit(out, 0, wrap && get_bit(side, cols));
+        set_bit(out, cols + 1, wrap && get_bit(side, 1));
+}
+
+/**
+ * steps one band of a mapped board through the halo of the thread
+ * @param *arg the mapped_pass_t for the generation
+ * @param task which band to step
+ * @param id the thread stepping it, it owns the halo rows MAPPED_HALO * id on
+ */
+static void step_band(void *arg, int task, int id)
+{
+        int i;
+        struct mapped_pass_t *pass = arg;
+        struct packed_t *packed = pass->packed;
+        int words = packed->words;
+        int first = task * pass->band_rows;
+        int last = (first + pass->band_rows < packed->rows) ? first + pass->band_rows : packed->rows;
+        uint64_t *halo = pass->mapped->halo + (size_t)MAPPED_HALO * words * id;
+        const struct rule_t *rule = get_rule();
+
+        advise_rows(packed, first - 1, last + 1, MADV_WILLNEED); /* start reading the whole band in before it is wanted */
+
+        /* row r of the band is kept in halo row (r - first + 1) % MAPPED_HALO */
+        fetch_row(packed, pass->edge, first - 1, halo);
+        fetch_row(packed, pass->edge, first, halo + words);
+
+        for (i = first; i < last; i++) {
+                fetch_row(packed, pass->edge, i + 1, halo + (size_t)((i - first + 2) % MAPPED_HALO) * words);
+                step_packed_row(halo + (size_t)((i - first) % MAPPED_HALO) * words, halo + (size_t)((i - first + 1) % MAPPED_HALO) * words,
+                                halo + (size_t)((i - first + 2) % MAPPED_HALO) * words, PACKED_ROW(pass->next_packed, i), words, packed->cols, rule);
+        }
+
+        /* dirty pages are still written back to the file, they just stop being mapped in by this process */
+        advise_rows(packed, first, last, MADV_DONTNEED);
+        advise_rows(pass->next_packed, first, last, MADV_DONTNEED);
+}
+
+/**
+ * Does the same as check_board_packed for boards made by map_packed, streaming them a band at a time
+ * @param *packed the board to be checked, it is only read
+ * @param *next_packed the board to be filled with the next generation
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *mapped the halo, made for the words of the boards and the threads of the pool
+ * @param *pool the pool to step the bands on, NULL to step them on this thread
+ */
+void check_board_mapped(struct packed_t *packed, struct packed_t *next_packed, struct data_t *matrix_data, struct mapped_t *mapped,
+                struct pool_t *pool)
+{
+        int i;
+        int tasks;
+        struct mapped_pass_t pass = { packed, next_packed, mapped, matrix_data->edge, 0 };
+
+        pass.band_rows = MAPPED_BAND_BYTES / (sizeof(uint64_t) * packed->words);
+        if (pass.band_rows < 1) {
+                pass.band_rows = 1;
+        }
+        tasks = (packed->rows + pass.band_rows - 1) / pass.band_rows;
+
+        if (pool) {
+                pool_run(pool, tasks, step_band, &pass);
+        } else {
+                for (i = 0; i < tasks; i++) {
+                        step_band(&pass, i, 0);
+                }
+        }
+}
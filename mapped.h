@@ -0,0 +1,40 @@
+#include "life.h"
+#include "packed.h"
+#include "pool.h"
+
+/**
+ * @file mapped.h
+ * @breif headers for packed boards kept in files and streamed through memory, in mapped.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef MAPPED_H_
+#define MAPPED_H_
+
+/* about how much of a board one task streams, the pages it went through are let go once it is done */
+#define MAPPED_BAND_BYTES (4 << 20)
+
+/* the rows a band holds in memory of its own, the row above, the row itself and the row below */
+#define MAPPED_HALO 3
+
+/* the halo rows of every thread of the pool. A band copies the rows it steps from the mapped board
+ * into these and fills their ghost bits here, so the board it reads is never written and only the
+ * board the next generation goes to has dirty pages to write back */
+struct mapped_t {
+        int threads;
+        int words;
+        uint64_t *halo;
+};
+
+struct packed_t *map_packed(int rows, int cols, const char *path);
+
+struct mapped_t *init_mapped(int words, int threads);
+
+void free_mapped(struct mapped_t *mapped);
+
+void check_board_mapped(struct packed_t *packed, struct packed_t *next_packed, struct data_t *matrix_data, struct mapped_t *mapped,
+                struct pool_t *pool);
+
+#endif
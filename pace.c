@@ -0,0 +1,103 @@
+#include "pace.h"
+
+/**
+ * @file pace.c
+ * @breif Keeps the generations and the frames each going at their own rate
+ * @details A pace_t counts how many ticks have been handed out since it started and works out how many more are due from the clock, so missing a moment does not lose a tick the way checking for an exact millisecond did. Nothing here spins, a loop that has no tick due sleeps until the next one.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * the time on a clock that only goes forward
+ * @return the time in seconds
+ */
+double pace_now(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * starts a pace with its first tick due now
+ * @param *pace the pace to start
+ * @param rate ticks a second, 0 for as fast as possible
+ */
+void init_pace(struct pace_t *pace, double rate)
+{
+        pace->rate = (rate > 0) ? rate : 0;
+        pace->start = pace_now();
+        pace->ticks = 0;
+}
+
+/**
+ * hands out the ticks that are due, counting them as done
+ * @param *pace the pace
+ * @param max the most ticks to hand out, if more are due the rest are dropped
+ * @return how many ticks are due, max when there is no rate
+ */
+unsigned long long pace_due(struct pace_t *pace, unsigned long long max)
+{
+        double now = pace_now();
+        unsigned long long due;
+
+        if (pace->rate == 0) {
+                pace->ticks += max;
+                return max;
+        }
+
+        if (now < pace->start) {
+                return 0;
+        }
+
+        due = (unsigned long long) ((now - pace->start) * pace->rate) + 1; /* ticks due in all since the start */
+        if (due <= pace->ticks) {
+                return 0;
+        }
+        due -= pace->ticks;
+
+        if (due > max) {
+                /* too far behind, the next tick is due a whole tick from now rather than trying to catch up */
+                pace->start = now;
+                pace->ticks = 1;
+                return max;
+        }
+        pace->ticks += due;
+
+        return due;
+}
+
+/**
+ * when the next tick is due
+ * @param *pace the pace
+ * @return the time in seconds, now when there is no rate
+ */
+double pace_next(struct pace_t *pace)
+{
+        if (pace->rate == 0) {
+                return pace_now();
+        }
+
+        return pace->start + pace->ticks / pace->rate;
+}
+
+/**
+ * sleeps until a time, returns straight away if it has passed
+ * @param when the time from pace_now to sleep until
+ */
+void pace_sleep_until(double when)
+{
+        double wait = when - pace_now();
+        struct timespec sleep;
+
+        if (wait <= 0) {
+                return;
+        }
+
+        sleep.tv_sec = (time_t) wait;
+        sleep.tv_nsec = (long) ((wait - sleep.tv_sec) * 1e9);
+        nanosleep(&sleep, NULL);
+}
@@ -0,0 +1,36 @@
+#include <time.h>
+
+/**
+ * @file pace.h
+ * @breif headers for keeping something running at a fixed rate, in pace.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef PACE_H_
+#define PACE_H_
+
+/* the most ticks one pace_due hands out, anything more behind than this is dropped so a slow
+ * board does not spend the next few seconds catching up */
+#define PACE_MAX_BEHIND 64
+
+/* rate is in ticks a second and 0 means as fast as possible. start is the time tick 0 was due,
+ * so tick n is due at start + n / rate and rounding never adds up over a long run */
+struct pace_t {
+        double rate;
+        double start;
+        unsigned long long ticks;
+};
+
+double pace_now(void);
+
+void init_pace(struct pace_t *pace, double rate);
+
+unsigned long long pace_due(struct pace_t *pace, unsigned long long max);
+
+double pace_next(struct pace_t *pace);
+
+void pace_sleep_until(double when);
+
+#endif
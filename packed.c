@@ -0,0 +1,375 @@
+#include <sys/mman.h>
+#include "packed.h"
+#include "load.h"
+
+/**
+ * @file packed.c
+ * @breif A second engine that keeps one cell per bit and steps 64 cells at a time
+ * @details Each row of the board is a string of 64 bit words. To get the neighbors of a whole word at once the three rows around it are shifted one bit west and one bit east, carrying the bit from the word next to it, which gives eight words that each hold one neighbor of every cell. Those eight words are added together with full adders so the count of every cell ends up spread over a ones, twos, fours and eights word. The rule is matched against those words a count at a time, only for the counts it births or keeps a cell alive on, so any rule is a handful of and/or operations. The edges work the same as in life.c, fill_ghost_packed copies the cells the edge makes adjacent into the ghost bits before every generation.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * Intilizes a packed board of rows by cols cells, all dead
+ * @param rows the amount of rows in the board
+ * @param cols the cols in the board
+ * @return the pointer to the board, or NULL if an allocation failed
+ */
+struct packed_t *init_packed(int rows, int cols)
+{
+        void *block = NULL;
+        struct packed_t *packed = NULL;
+
+        packed = malloc(sizeof(struct packed_t));
+
+        if (!packed) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        packed->rows = rows;
+        packed->cols = cols;
+        packed->words = (cols + 2 + 63) / 64; /* the ghost columns get a bit each */
+
+        if (posix_memalign(&block, GRID_ALIGN, sizeof(uint64_t) * packed->words * (rows + 2)) != 0) {
+                printf("Malloc failed\n");
+                free(packed);
+                return NULL;
+        }
+        packed->block = block;
+        packed->mapped = 0;
+        memset(packed->block, 0, sizeof(uint64_t) * packed->words * (rows + 2));
+
+        return packed;
+}
+
+/**
+ * frees a board made by init_packed or map_packed, a mapped board is left in its file
+ * @param *packed the board to free, may be NULL
+ */
+void free_packed(struct packed_t *packed)
+{
+        if (!packed) {
+                return;
+        }
+
+        if (packed->mapped) {
+                munmap(packed->block, packed->mapped);
+        } else {
+                free(packed->block);
+        }
+        free(packed);
+}
+
+/**
+ * packs a byte grid into a packed board of the same size
+ * @param *packed the board to fill
+ * @param *grid the grid to read, any cell that is not 0 is alive
+ */
+void pack_grid(struct packed_t *packed, struct grid_t *grid)
+{
+        int i;
+        int j;
+        uint64_t *row;
+
+        for (i = 0; i < packed->rows; i++) {
+                row = PACKED_ROW(packed, i);
+                memset(row, 0, sizeof(uint64_t) * packed->words);
+
+                for (j = 0; j < packed->cols; j++) {
+                        if (grid->cell[i][j]) {
+                                row[(j + 1) >> 6] |= 1ULL << ((j + 1) & 63);
+                        }
+                }
+        }
+}
+
+/**
+ * unpacks a packed board into a byte grid of the same size so it can be rendered
+ * @param *grid the grid to fill with 1's and 0's
+ * @param *packed the board to read
+ */
+void unpack_grid(struct grid_t *grid, struct packed_t *packed)
+{
+        int i;
+        int j;
+        const uint64_t *row;
+
+        for (i = 0; i < packed->rows; i++) {
+                row = PACKED_ROW(packed, i);
+
+                for (j = 0; j < packed->cols; j++) {
+                        grid->cell[i][j] = get_bit(row, j + 1);
+                }
+        }
+}
+
+/**
+ * Fills the ghost bits of a packed board based on the edge, the same way fill_ghost does for a grid
+ * @param *packed the board whose border gets filled
+ * @param edge the edge either hedge torus klein or cross, 1 2 3 or 5
+ */
+void fill_ghost_packed(struct packed_t *packed, int edge)
+{
+        int i;
+        int pos;
+        int rows = packed->rows;
+        int cols = packed->cols;
+        int wrap = (edge == EDGE_TORUS || edge == EDGE_KLEIN);
+        uint64_t *row;
+        uint64_t *top = PACKED_ROW(packed, -1);
+        uint64_t *bottom = PACKED_ROW(packed, rows);
+
+        for (i = 0; i < rows; i++) {
+                row = PACKED_ROW(packed, i);
+                set_bit(row, 0, wrap && get_bit(row, cols));
+                set_bit(row, cols + 1, wrap && get_bit(row, 1));
+        }
+
+        if (edge == EDGE_CROSS) {
+                for (i = 0; i < rows; i++) { /* leaving through the left or right flips the row */
+                        row = PACKED_ROW(packed, i);
+                        set_bit(row, 0, get_bit(PACKED_ROW(packed, rows - 1 - i), cols));
+                        set_bit(row, cols + 1, get_bit(PACKED_ROW(packed, rows - 1 - i), 1));
+                }
+        }
+
+        if (edge == EDGE_TORUS) {
+                memcpy(top, PACKED_ROW(packed, rows - 1), sizeof(uint64_t) * packed->words);
+                memcpy(bottom, PACKED_ROW(packed, 0), sizeof(uint64_t) * packed->words);
+        } else if (edge == EDGE_KLEIN || edge == EDGE_CROSS) {
+                /* the ghost row is the row on the other side read backwards, ghost bits included */
+                memset(top, 0, sizeof(uint64_t) * packed->words);
+                memset(bottom, 0, sizeof(uint64_t) * packed->words);
+
+                for (pos = 0; pos <= cols + 1; pos++) {
+                        if (get_bit(PACKED_ROW(packed, rows - 1), cols + 1 - pos)) {
+                                top[pos >> 6] |= 1ULL << (pos & 63);
+                        }
+                        if (get_bit(PACKED_ROW(packed, 0), cols + 1 - pos)) {
+                                bottom[pos >> 6] |= 1ULL << (pos & 63);
+                        }
+                }
+
+                if (edge == EDGE_CROSS) { /* the corners are dead, the same as fill_ghost leaves them */
+                        set_bit(top, 0, 0);
+                        set_bit(top, cols + 1, 0);
+                        set_bit(bottom, 0, 0);
+                        set_bit(bottom, cols + 1, 0);
+                }
+        } else {
+                memset(top, 0, sizeof(uint64_t) * packed->words);
+                memset(bottom, 0, sizeof(uint64_t) * packed->words);
+        }
+}
+
+/**
+ * Steps one packed row a word at a time, the ghost bits of all three rows must already be filled
+ * @param *above the row above
+ * @param *here the row being stepped
+ * @param *below the row below
+ * @param *out where the next generation of the row is written, its ghost bits are left 0
+ * @param words the words in each row
+ * @param cols the cols on the board
+ * @param *rule the rule to step with, from get_rule
+ */
+void step_packed_row(const uint64_t *above, const uint64_t *here, const uint64_t *below, uint64_t *out, int words, int cols,
+                const struct rule_t *rule)
+{
+        int w;
+        int tail = cols + 1 - 64 * (words - 1); /* bits of the last word that are real cells */
+        uint64_t a_w, a_c, a_e, h_w, h_c, h_e, b_w, b_c, b_e;
+
+        for (w = 0; w < words; w++) {
+                /* the west neighbor of bit k is bit k - 1, so shift left and carry in the top bit of the word before */
+                a_c = above[w];
+                h_c = here[w];
+                b_c = below[w];
+                a_w = (a_c << 1) | (w > 0 ? above[w - 1] >> 63 : 0);
+                h_w = (h_c << 1) | (w > 0 ? here[w - 1] >> 63 : 0);
+                b_w = (b_c << 1) | (w > 0 ? below[w - 1] >> 63 : 0);
+                a_e = (a_c >> 1) | (w + 1 < words ? above[w + 1] << 63 : 0);
+                h_e = (h_c >> 1) | (w + 1 < words ? here[w + 1] << 63 : 0);
+                b_e = (b_c >> 1) | (w + 1 < words ? below[w + 1] << 63 : 0);
+
+                out[w] = life_word(a_w, a_c, a_e, h_w, h_c, h_e, b_w, b_c, b_e, rule);
+        }
+
+        out[0] &= ~1ULL; /* the ghost bits get filled again before they are read */
+        out[words - 1] &= (tail >= 64) ? ~0ULL : (1ULL << tail) - 1;
+}
+
+/**
+ * Steps the rows first to last - 1 of packed into next_packed a word at a time, the ghost bits must already be filled
+ * @param *packed the board holding the current generation
+ * @param *next_packed the board to be filled with the next generation
+ * @param first the first row to step
+ * @param last one past the last row to step
+ */
+void step_packed_rows(struct packed_t *packed, struct packed_t *next_packed, int first, int last)
+{
+        int i;
+        const struct rule_t *rule = get_rule();
+
+        for (i = first; i < last; i++) {
+                step_packed_row(PACKED_ROW(packed, i - 1), PACKED_ROW(packed, i), PACKED_ROW(packed, i + 1), PACKED_ROW(next_packed, i),
+                                packed->words, packed->cols, rule);
+        }
+}
+
+/**
+ * Checks every cell on the packed board and fills next_packed with the next generation
+ * @param *packed the board to be checked
+ * @param *next_packed the board to be filled with the next generation
+ * @param *matrix_data a pointer to the main data for the matrix
+ */
+void check_board_packed(struct packed_t *packed, struct packed_t *next_packed, struct data_t *matrix_data)
+{
+        fill_ghost_packed(packed, matrix_data->edge);
+        step_packed_rows(packed, next_packed, 0, packed->rows);
+}
+
+/**
+ * counts the alive cells on a packed board
+ * @param *packed the board to count
+ * @return the number of alive cells
+ */
+long packed_population(struct packed_t *packed)
+{
+        int i;
+        int w;
+        long count = 0;
+        const uint64_t *row;
+
+        for (i = 0; i < packed->rows; i++) {
+                row = PACKED_ROW(packed, i);
+
+                for (w = 0; w < packed->words; w++) {
+                        count += __builtin_popcountll(row[w]);
+                }
+                count -= get_bit(row, 0) + get_bit(row, packed->cols + 1); /* leave out the ghost bits */
+        }
+
+        return count;
+}
+
+/**
+ * counts the cells born and the cells that died going from one packed board to the next
+ * @param *packed the newer board
+ * @param *last the board it was stepped from
+ * @param *births set to the cells alive on packed and dead on last
+ * @param *deaths set to the cells alive on last and dead on packed
+ */
+void packed_changes(struct packed_t *packed, struct packed_t *last, long long *births, long long *deaths)
+{
+        int i;
+        int w;
+        uint64_t ghost;
+        const uint64_t *row;
+        const uint64_t *last_row;
+
+        *births = 0;
+        *deaths = 0;
+
+        for (i = 0; i < packed->rows; i++) {
+                row = PACKED_ROW(packed, i);
+                last_row = PACKED_ROW(last, i);
+
+                for (w = 0; w < packed->words; w++) {
+                        ghost = (w == 0) ? 1 : 0; /* leave out the ghost bits */
+                        ghost |= (w == (packed->cols + 1) >> 6) ? 1ULL << ((packed->cols + 1) & 63) : 0;
+                        *births += __builtin_popcountll(row[w] & ~last_row[w] & ~ghost);
+                        *deaths += __builtin_popcountll(last_row[w] & ~row[w] & ~ghost);
+                }
+        }
+}
+
+/**
+ * hands the row and col of every alive cell on a packed board to fn, a row at a time
+ * @param *packed the board
+ * @param fn called with target and the row and col of every alive cell
+ * @param *target passed to fn
+ */
+void packed_cells(struct packed_t *packed, cell_fn fn, void *target)
+{
+        int i;
+        int w;
+        int pos;
+        uint64_t bits;
+        const uint64_t *row;
+
+        for (i = 0; i < packed->rows; i++) {
+                row = PACKED_ROW(packed, i);
+
+                for (w = 0; w < packed->words; w++) {
+                        for (bits = row[w]; bits; bits &= bits - 1) {
+                                pos = 64 * w + __builtin_ctzll(bits);
+                                if (pos > 0 && pos <= packed->cols) { /* the ghost bits are not cells */
+                                        fn(target, i, pos - 1);
+                                }
+                        }
+                }
+        }
+}
+
+/* where parse_file_packed is putting the cells of a pattern */
+struct packed_place_t {
+        struct packed_t *packed;
+        int x;
+        int y;
+        int min;
+        int edge;
+};
+
+/**
+ * puts one cell from a file on a packed board, where fill_board would put it on a grid
+ * @param *target the packed_place_t
+ * @param row the row from the file
+ * @param col the col from the file
+ */
+static void place_packed(void *target, long long row, long long col)
+{
+        struct packed_place_t *place = target;
+        int i = row;
+        int j = col;
+
+        board_position(place->packed->rows, place->packed->cols, place->edge, &i, &j, place->x, place->y, place->min);
+        set_bit(PACKED_ROW(place->packed, i), j + 1, 1);
+}
+
+/**
+ * reads a pattern file of any format load_pattern knows straight onto a packed board, placed the
+ * same way parse_file places it on a grid, for boards with no grid to load into first
+ * @param *packed the board to fill
+ * @param *filepath the file to read
+ * @param x the offset for the x value that the user entered
+ * @param y the offset for the y value that the user entered
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *rule where the rule named in the file is copied, RULE_SIZE chars and left empty if there is none, may be NULL
+ * @return 0 on success, -1 if the file could not be read
+ */
+int parse_file_packed(struct packed_t *packed, char *filepath, int x, int y, struct data_t *matrix_data, char *rule)
+{
+        struct packed_place_t place = { packed, x, y, 1000, matrix_data->edge };
+        struct pattern_t pattern;
+
+        if (load_pattern(filepath, &pattern) == -1) {
+                return -1;
+        }
+
+        if (pattern.count > 0) {
+                place.min = (pattern.min_row < place.min) ? pattern.min_row : place.min;
+                place.min = (pattern.min_col < place.min) ? pattern.min_col : place.min;
+        }
+
+        if (rule) {
+                strcpy(rule, pattern.rule);
+        }
+
+        pattern_cells(&pattern, place_packed, &place); /* every state of a many state file is alive here */
+        free_pattern(&pattern);
+
+        return 0;
+}
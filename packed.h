@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include "life.h"
+
+/**
+ * @file packed.h
+ * @breif headers for the bit packed engine in packed.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef PACKED_H_
+#define PACKED_H_
+
+/* a board with one bit per cell. Every row is words 64 bit words long, column j
+ * lives at bit j + 1 of the row so bit 0 and bit cols + 1 are the ghost columns,
+ * row -1 and row rows are the ghost rows just like in a grid_t. mapped is the
+ * size of the file block is mapped from by map_packed, 0 when it is on the heap */
+struct packed_t {
+        int rows;
+        int cols;
+        int words;
+        uint64_t *block;
+        size_t mapped;
+};
+
+#define PACKED_ROW(packed, i) ((packed)->block + (size_t)((i) + 1) * (packed)->words)
+
+/**
+ * gets the value of a bit from a packed row
+ * @param *row the row to read
+ * @param pos the bit position, which is the column + 1
+ * @return 1 if the bit is set otherwise 0
+ */
+static inline int get_bit(const uint64_t *row, int pos)
+{
+        return (row[pos >> 6] >> (pos & 63)) & 1;
+}
+
+/**
+ * sets a bit in a packed row to value
+ * @param *row the row to change
+ * @param pos the bit position, which is the column + 1
+ * @param value either 0 or 1
+ */
+static inline void set_bit(uint64_t *row, int pos, int value)
+{
+        row[pos >> 6] = (row[pos >> 6] & ~(1ULL << (pos & 63))) | ((uint64_t)value << (pos & 63));
+}
+
+/**
+ * works out the next generation of 64 cells at once from the words holding their neighbors
+ * @param a_w the row above shifted so each bit holds the cell above and to the west, a_c above, a_e above and east
+ * @param h_c the cells themselves, h_w and h_e their west and east neighbors
+ * @param b_c the row below, b_w and b_e its west and east neighbors
+ * @param *rule the rule to step with, from get_rule
+ * @return the next generation of the 64 cells in h_c
+ */
+static inline uint64_t life_word(uint64_t a_w, uint64_t a_c, uint64_t a_e, uint64_t h_w, uint64_t h_c, uint64_t h_e, uint64_t b_w, uint64_t b_c, uint64_t b_e, const struct rule_t *rule)
+{
+        int k;
+        uint64_t s1, c1, s2, c2, s3, c3, ones, c4, t, c5, twos, c6, fours, eights;
+        uint64_t match;
+        uint64_t born = 0;
+        uint64_t stays = 0;
+
+        /* add up the 8 neighbor words with full adders */
+        s1 = a_w ^ a_c ^ a_e;
+        c1 = (a_w & a_c) | (a_e & (a_w ^ a_c));
+        s2 = h_w ^ h_e ^ b_w;
+        c2 = (h_w & h_e) | (b_w & (h_w ^ h_e));
+        s3 = b_c ^ b_e;
+        c3 = b_c & b_e;
+
+        ones = s1 ^ s2 ^ s3;
+        c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+
+        t = c1 ^ c2 ^ c3;
+        c5 = (c1 & c2) | (c3 & (c1 ^ c2));
+        twos = t ^ c4;
+        c6 = t & c4;
+        fours = c5 ^ c6;
+        eights = c5 & c6; /* only a count of 8, which would otherwise look like 0 */
+
+        /* a cell matches a term when every bit of its count does, only the counts the rule uses are tested */
+        for (k = 0; k < rule->terms; k++) {
+                match = ~((ones ^ rule->term[k].ones) | (twos ^ rule->term[k].twos)
+                                | (fours ^ rule->term[k].fours) | (eights ^ rule->term[k].eights));
+                born |= match & rule->term[k].born;
+                stays |= match & rule->term[k].stays;
+        }
+
+        return (born & ~h_c) | (stays & h_c);
+}
+
+struct packed_t *init_packed(int rows, int cols);
+
+void free_packed(struct packed_t *packed);
+
+void pack_grid(struct packed_t *packed, struct grid_t *grid);
+
+void unpack_grid(struct grid_t *grid, struct packed_t *packed);
+
+void fill_ghost_packed(struct packed_t *packed, int edge);
+
+void step_packed_row(const uint64_t *above, const uint64_t *here, const uint64_t *below, uint64_t *out, int words, int cols,
+                const struct rule_t *rule);
+
+void step_packed_rows(struct packed_t *packed, struct packed_t *next_packed, int first, int last);
+
+void check_board_packed(struct packed_t *packed, struct packed_t *next_packed, struct data_t *matrix_data);
+
+long packed_population(struct packed_t *packed);
+
+void packed_changes(struct packed_t *packed, struct packed_t *last, long long *births, long long *deaths);
+
+void packed_cells(struct packed_t *packed, cell_fn fn, void *target);
+
+int parse_file_packed(struct packed_t *packed, char *filepath, int x, int y, struct data_t *matrix_data, char *rule);
+
+#endif
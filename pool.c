@@ -0,0 +1,262 @@
+#include "pool.h"
+
+/**
+ * @file pool.c
+ * @breif A pool of worker threads that stays alive between generations, and the threaded versions of check_board
+ * @details The board is cut into bands of rows and each thread starts out owning an even share of the bands. A thread works through its own bands first and when it runs out it steals bands from the other threads, so a slow thread does not hold up the whole generation. The calling thread works as thread 0 and pool_run does not return until every band is done, which is the barrier between one generation and the next. The ghost border is filled before any band starts and the bands only read the current board, so the seams between bands are correct for every edge.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+struct band_t {
+        struct grid_t *grid;
+        struct grid_t *next_grid;
+        struct packed_t *packed;
+        struct packed_t *next_packed;
+        int band_rows;
+        int rows;
+};
+
+/**
+ * runs tasks until there are none left anywhere in the pool, first from its own queue then stolen from the others
+ * @param *pool the pool the thread belongs to
+ * @param id which thread is working
+ */
+static void work(struct pool_t *pool, int id)
+{
+        int i;
+        int task;
+        struct queue_t *queue;
+
+        for (i = 0; i < pool->threads; i++) {
+                queue = &pool->queues[(id + i) % pool->threads];
+
+                while ((task = atomic_fetch_add(&queue->next, 1)) < queue->end) {
+                        pool->fn(pool->arg, task, id);
+                }
+        }
+}
+
+/**
+ * the loop every worker thread runs, waits for a generation to be handed out and works on it
+ * @param *arg the worker_t of the thread
+ * @return NULL
+ */
+static void *worker(void *arg)
+{
+        struct worker_t *self = arg;
+        struct pool_t *pool = self->pool;
+        int seen = 0;
+
+        while (1) {
+                pthread_mutex_lock(&pool->lock);
+                while (pool->generation == seen && !pool->quit) {
+                        pthread_cond_wait(&pool->start, &pool->lock);
+                }
+                seen = pool->generation;
+
+                if (pool->quit) {
+                        pthread_mutex_unlock(&pool->lock);
+                        return NULL;
+                }
+                pthread_mutex_unlock(&pool->lock);
+
+                work(pool, self->id);
+
+                pthread_mutex_lock(&pool->lock);
+                if (--pool->running == 0) {
+                        pthread_cond_signal(&pool->done);
+                }
+                pthread_mutex_unlock(&pool->lock);
+        }
+}
+
+/**
+ * starts a pool of threads, the thread calling pool_run counts as one of them
+ * @param threads the total number of threads to work with, at least 1
+ * @return the pool, or NULL if it could not be made
+ */
+struct pool_t *init_pool(int threads)
+{
+        int i;
+        struct pool_t *pool = NULL;
+
+        pool = calloc(1, sizeof(struct pool_t));
+
+        if (!pool) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        pool->threads = (threads < 1) ? 1 : threads;
+        pool->workers = calloc(pool->threads, sizeof(struct worker_t));
+        pool->queues = aligned_alloc(GRID_ALIGN, sizeof(struct queue_t) * pool->threads);
+
+        if (!pool->workers || !pool->queues) {
+                printf("Malloc failed\n");
+                free(pool->workers);
+                free(pool->queues);
+                free(pool);
+                return NULL;
+        }
+
+        pthread_mutex_init(&pool->lock, NULL);
+        pthread_cond_init(&pool->start, NULL);
+        pthread_cond_init(&pool->done, NULL);
+
+        for (i = 0; i < pool->threads; i++) {
+                atomic_init(&pool->queues[i].next, 0);
+                pool->queues[i].end = 0;
+                pool->workers[i].pool = pool;
+                pool->workers[i].id = i;
+        }
+
+        for (i = 1; i < pool->threads; i++) { /* thread 0 is whoever calls pool_run */
+                if (pthread_create(&pool->workers[i].thread, NULL, worker, &pool->workers[i]) != 0) {
+                        printf("Could not start thread %d, running with %d\n", i, i);
+                        pool->threads = i;
+                        break;
+                }
+        }
+
+        return pool;
+}
+
+/**
+ * stops the threads of a pool and frees it
+ * @param *pool the pool to free, may be NULL
+ */
+void free_pool(struct pool_t *pool)
+{
+        int i;
+
+        if (!pool) {
+                return;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        pool->quit = 1;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (i = 1; i < pool->threads; i++) {
+                pthread_join(pool->workers[i].thread, NULL);
+        }
+
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->start);
+        pthread_cond_destroy(&pool->done);
+        free(pool->workers);
+        free(pool->queues);
+        free(pool);
+}
+
+/**
+ * runs fn for every task from 0 to tasks - 1 spread over the pool and waits for all of them to finish
+ * @param *pool the pool to run on
+ * @param tasks the number of tasks
+ * @param fn the function to run for each task, also handed which thread of the pool it is running on
+ * @param *arg passed to every call of fn
+ */
+void pool_run(struct pool_t *pool, int tasks, void (*fn)(void *arg, int task, int id), void *arg)
+{
+        int i;
+
+        pool->fn = fn;
+        pool->arg = arg;
+
+        for (i = 0; i < pool->threads; i++) { /* every thread starts with its own even share of the tasks */
+                atomic_store(&pool->queues[i].next, (int)((long)tasks * i / pool->threads));
+                pool->queues[i].end = (int)((long)tasks * (i + 1) / pool->threads);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        pool->running = pool->threads - 1;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+
+        work(pool, 0);
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->running > 0) {
+                pthread_cond_wait(&pool->done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * works out how tall the bands should be for a board with rows rows
+ * @param rows the rows of the board
+ * @param *pool the pool the bands are going to run on
+ * @return the rows in every band but the last
+ */
+static int band_height(int rows, struct pool_t *pool)
+{
+        int height = rows / (pool->threads * BANDS_PER_THREAD);
+
+        return (height < BAND_MIN_ROWS) ? BAND_MIN_ROWS : height;
+}
+
+/**
+ * steps one band of a grid
+ * @param *arg the band_t for the generation
+ * @param task which band to step
+ * @param id the thread stepping it
+ */
+static void step_band(void *arg, int task, int id)
+{
+        struct band_t *band = arg;
+        int first = task * band->band_rows;
+        int last = (first + band->band_rows > band->rows) ? band->rows : first + band->band_rows;
+
+        step_rows(band->grid, band->next_grid, first, last);
+}
+
+/**
+ * steps one band of a packed board
+ * @param *arg the band_t for the generation
+ * @param task which band to step
+ * @param id the thread stepping it
+ */
+static void step_packed_band(void *arg, int task, int id)
+{
+        struct band_t *band = arg;
+        int first = task * band->band_rows;
+        int last = (first + band->band_rows > band->rows) ? band->rows : first + band->band_rows;
+
+        step_packed_rows(band->packed, band->next_packed, first, last);
+}
+
+/**
+ * Does the same as check_board but splits the board into bands of rows that run on the pool
+ * @param *grid the grid to be checked
+ * @param *next_grid the grid to be filled with the next generation
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *pool the pool to run the bands on
+ */
+void check_board_threaded(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data, struct pool_t *pool)
+{
+        struct band_t band = { grid, next_grid, NULL, NULL, 0, grid->rows };
+
+        fill_ghost(grid, matrix_data->edge);
+        band.band_rows = band_height(grid->rows, pool);
+        pool_run(pool, (grid->rows + band.band_rows - 1) / band.band_rows, step_band, &band);
+}
+
+/**
+ * Does the same as check_board_packed but splits the board into bands of rows that run on the pool
+ * @param *packed the board to be checked
+ * @param *next_packed the board to be filled with the next generation
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *pool the pool to run the bands on
+ */
+void check_board_packed_threaded(struct packed_t *packed, struct packed_t *next_packed, struct data_t *matrix_data, struct pool_t *pool)
+{
+        struct band_t band = { NULL, NULL, packed, next_packed, 0, packed->rows };
+
+        fill_ghost_packed(packed, matrix_data->edge);
+        band.band_rows = band_height(packed->rows, pool);
+        pool_run(pool, (packed->rows + band.band_rows - 1) / band.band_rows, step_packed_band, &band);
+}
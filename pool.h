@@ -0,0 +1,61 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include "life.h"
+#include "packed.h"
+
+/**
+ * @file pool.h
+ * @breif headers for the worker pool and the threaded steps in pool.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef POOL_H_
+#define POOL_H_
+
+/* the smallest band a worker is handed, fewer rows than this is not worth waking a thread for */
+#define BAND_MIN_ROWS 8
+/* bands per thread, more bands give stealing something to even out */
+#define BANDS_PER_THREAD 4
+
+/* the tasks a thread owns, next is taken with an atomic add by the owner and by anyone stealing */
+struct queue_t {
+        atomic_int next;
+        int end;
+        char pad[GRID_ALIGN - sizeof(atomic_int) - sizeof(int)]; /* keep each queue on its own cache line */
+};
+
+struct pool_t;
+
+struct worker_t {
+        struct pool_t *pool;
+        int id;
+        pthread_t thread;
+};
+
+struct pool_t {
+        int threads;
+        struct worker_t *workers;
+        struct queue_t *queues;
+        pthread_mutex_t lock;
+        pthread_cond_t start;
+        pthread_cond_t done;
+        int generation;
+        int running;
+        int quit;
+        void (*fn)(void *arg, int task, int id);
+        void *arg;
+};
+
+struct pool_t *init_pool(int threads);
+
+void free_pool(struct pool_t *pool);
+
+void pool_run(struct pool_t *pool, int tasks, void (*fn)(void *arg, int task, int id), void *arg);
+
+void check_board_threaded(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data, struct pool_t *pool);
+
+void check_board_packed_threaded(struct packed_t *packed, struct packed_t *next_packed, struct data_t *matrix_data, struct pool_t *pool);
+
+#endif
@@ -0,0 +1,507 @@
+#include "render.h"
+
+/**
+ * @file render.c
+ * @breif Draws a view of the board through a streaming texture that only has the changed tiles uploaded
+ * @details The texture is the size of the window, x is the row of the grid and y the col, the same way sdl_render_life lays the board out. Zoomed in each texture pixel is one cell and the renderer scales it up, the dying states of a generations rule in fading shades of the alive colour, zoomed out each pixel is a square of cells drawn brighter the more of them are alive, only state 1 counting as alive. Squares smaller than a tile are counted from the cells, bigger ones are added up from the tile counts in the triple buffer so a huge board is drawn without touching its cells. The triple buffer only hands over the cells of a region of the board, the window asks for one around its view whenever the view could be drawn from the cells and has left the region. A view that is not inside the region handed over, because it was just moved or is too far out for any region to hold, is drawn from the tile counts, a square smaller than a tile as bright as the tile it is in. Each frame takes the newest grid from the triple buffer. When it is the grid handed over right after the one already in the texture, of the same region, and the view has not moved, only the pixels over the tiles flagged in its dirty map are drawn and uploaded, a run of flagged tiles going across at a time. Anything else redraws the whole view. A frame with nothing new draws nothing, unless the stats overlay is up, which is drawn over the board every frame with a 3 by 5 font of its own since SDL has no text.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * cells on a side of one texture pixel
+ * @param *render the renderer
+ * @return 1 when zoomed in, otherwise a power of 2
+ */
+static int cells_per_pixel(struct render_t *render)
+{
+        return (render->zoom < 0) ? 1 << -render->zoom : 1;
+}
+
+/**
+ * how many texture pixels the view uses across and down, zoomed in that is fewer than the window
+ * @param *render the renderer
+ * @param *across set to the pixels across
+ * @param *down set to the pixels down
+ */
+static void view_size(struct render_t *render, int *across, int *down)
+{
+        int magnify = (render->zoom > 0) ? 1 << render->zoom : 1;
+
+        *across = (render->width + magnify - 1) / magnify;
+        *down = (render->height + magnify - 1) / magnify;
+}
+
+/**
+ * keeps the view on the board and lined up with the squares one pixel covers
+ * @param *render the renderer
+ */
+static void clamp_view(struct render_t *render)
+{
+        int across;
+        int down;
+        int size = cells_per_pixel(render);
+
+        view_size(render, &across, &down);
+
+        render->view_row = (render->view_row > render->rows - across * size) ? render->rows - across * size : render->view_row;
+        render->view_col = (render->view_col > render->cols - down * size) ? render->cols - down * size : render->view_col;
+        render->view_row = (render->view_row < 0) ? 0 : render->view_row / size * size;
+        render->view_col = (render->view_col < 0) ? 0 : render->view_col / size * size;
+}
+
+/**
+ * makes the texture for the window
+ * @param *sdl_info the SDL set up by init_sdl_info, its renderer, size, sprite size and color are used
+ * @param rows the number of rows on the board
+ * @param cols the number of cols on the board
+ * @return the renderer, or NULL if the texture or a buffer could not be made
+ */
+struct render_t *init_render(struct sdl_info_t *sdl_info, int rows, int cols)
+{
+        struct render_t *render = calloc(1, sizeof(struct render_t));
+
+        if (!render) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        render->renderer = sdl_info->renderer;
+        render->rows = rows;
+        render->cols = cols;
+        render->width = sdl_info->width;
+        render->height = sdl_info->height;
+        render->alive = 0xff000000 | sdl_info->color.red << 16 | sdl_info->color.green << 8 | sdl_info->color.blue;
+        render->dead = 0xff000000;
+        render->moved = 1;
+        render->pixels = malloc(sizeof(Uint32) * render->width * render->height);
+
+        /* start zoomed in as far as the sprite size */
+        while (render->zoom < RENDER_MAX_ZOOM && 2 << render->zoom <= sdl_info->sprite_size) {
+                render->zoom++;
+        }
+
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0"); /* cells stay square when scaled */
+        render->texture = SDL_CreateTexture(render->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, render->width, render->height);
+
+        if (!render->pixels || !render->texture) {
+                printf("Could not make the texture: %s\n", SDL_GetError());
+                free_render(render);
+                return NULL;
+        }
+
+        return render;
+}
+
+/**
+ * frees a renderer made by init_render, the SDL renderer is left alone
+ * @param *render the renderer, may be NULL
+ */
+void free_render(struct render_t *render)
+{
+        if (!render) {
+                return;
+        }
+
+        if (render->texture) {
+                SDL_DestroyTexture(render->texture);
+        }
+        free(render->pixels);
+        free(render);
+}
+
+/**
+ * moves the view
+ * @param *render the renderer
+ * @param right window pixels to move right, negative for left
+ * @param down window pixels to move down, negative for up
+ */
+void render_pan(struct render_t *render, int right, int down)
+{
+        int magnify = (render->zoom > 0) ? 1 << render->zoom : 1;
+
+        render->view_row += right * cells_per_pixel(render) / magnify;
+        render->view_col += down * cells_per_pixel(render) / magnify;
+        clamp_view(render);
+        render->moved = 1;
+}
+
+/**
+ * zooms the view in or out around the middle of the window, zooming out stops once the whole board fits
+ * @param *render the renderer
+ * @param steps how many times to double the size of a cell, negative to zoom out
+ */
+void render_zoom(struct render_t *render, int steps)
+{
+        int across;
+        int down;
+        int size = cells_per_pixel(render);
+        int row;
+        int col;
+
+        view_size(render, &across, &down);
+        row = render->view_row + across * size / 2;
+        col = render->view_col + down * size / 2;
+
+        for (; steps > 0 && render->zoom < RENDER_MAX_ZOOM; steps--) {
+                render->zoom++;
+        }
+
+        for (; steps < 0; steps++) {
+                view_size(render, &across, &down);
+                if (across * cells_per_pixel(render) >= render->rows && down * cells_per_pixel(render) >= render->cols) {
+                        break;
+                }
+                render->zoom--;
+        }
+
+        view_size(render, &across, &down);
+        size = cells_per_pixel(render);
+        render->view_row = row - across * size / 2;
+        render->view_col = col - down * size / 2;
+        clamp_view(render);
+        render->moved = 1;
+}
+
+/**
+ * the alive colour dimmed to a level
+ * @param *render the renderer
+ * @param level 0 for black up to 255 for the alive colour
+ * @return the colour
+ */
+static Uint32 dim(struct render_t *render, Uint32 level)
+{
+        return 0xff000000 | (((render->alive >> 16 & 0xff) * level / 255) << 16)
+                | (((render->alive >> 8 & 0xff) * level / 255) << 8) | ((render->alive & 0xff) * level / 255);
+}
+
+/**
+ * the colour of one texture pixel
+ * @param *render the renderer
+ * @param *grid the region of the board handed over
+ * @param *triple the triple buffer the region came from, for where it is and the tile counts
+ * @param x the pixel across
+ * @param y the pixel down
+ * @return the colour
+ */
+static Uint32 shade(struct render_t *render, struct grid_t *grid, struct triple_t *triple, int x, int y)
+{
+        int i;
+        int j;
+        int size = cells_per_pixel(render);
+        int row = render->view_row + x * size;
+        int col = render->view_col + y * size;
+        int top = triple->row[triple->front];
+        int left = triple->col[triple->front];
+        int end_row = (row + size < render->rows) ? row + size : render->rows;
+        int end_col = (col + size < render->cols) ? col + size : render->cols;
+        int *count = triple->count[triple->front];
+        long long alive = 0;
+        long long area = (long long)size * size;
+        int states = get_rule()->states;
+        unsigned char cell;
+        Uint32 level;
+
+        if (row >= render->rows || col >= render->cols) {
+                return render->dead;
+        } else if (render->cells && size == 1) {
+                cell = grid->cell[row - top][col - left];
+                if (cell <= 1) {
+                        return cell ? render->alive : render->dead;
+                }
+                /* the dying states of a generations rule fade out the closer they are to dead */
+                return dim(render, 255 * (states - cell) / (states - 1));
+        } else if (render->cells) {
+                for (i = row; i < end_row; i++) {
+                        for (j = col; j < end_col; j++) {
+                                alive += grid->cell[i - top][j - left] == 1;
+                        }
+                }
+        } else {
+                /* whole tiles when size is a multiple of the tile size, otherwise the one tile the square is in */
+                for (i = row / TRIPLE_TILE; i <= (end_row - 1) / TRIPLE_TILE; i++) {
+                        for (j = col / TRIPLE_TILE; j <= (end_col - 1) / TRIPLE_TILE; j++) {
+                                alive += count[i * triple->tile_cols + j];
+                        }
+                }
+                area = (size < TRIPLE_TILE) ? TRIPLE_TILE * TRIPLE_TILE : area;
+        }
+
+        if (alive == 0) {
+                return render->dead;
+        }
+
+        /* a quarter bright for one cell, full bright for a full square */
+        level = 64 + 191 * alive / area;
+        return dim(render, level);
+}
+
+/**
+ * draws and uploads one rectangle of the texture
+ * @param *render the renderer
+ * @param *grid the board
+ * @param *triple the triple buffer the board came from
+ * @param x the first pixel across
+ * @param y the first pixel down
+ * @param end_x one past the last pixel across
+ * @param end_y one past the last pixel down
+ */
+static void upload(struct render_t *render, struct grid_t *grid, struct triple_t *triple, int x, int y, int end_x, int end_y)
+{
+        int i;
+        int j;
+        SDL_Rect rect;
+
+        if (x >= end_x || y >= end_y) {
+                return;
+        }
+
+        for (j = y; j < end_y; j++) {
+                for (i = x; i < end_x; i++) {
+                        render->pixels[j * render->width + i] = shade(render, grid, triple, i, j);
+                }
+        }
+
+        rect.x = x;
+        rect.y = y;
+        rect.w = end_x - x;
+        rect.h = end_y - y;
+        SDL_UpdateTexture(render->texture, &rect, render->pixels + y * render->width + x, render->width * sizeof(Uint32));
+}
+
+/**
+ * the pixels a range of cells falls on, clipped to the view
+ * @param first the first cell
+ * @param end one past the last cell
+ * @param view the first cell in the view
+ * @param size cells on a side of a pixel
+ * @param pixels pixels in the view
+ * @param *from set to the first pixel
+ * @param *to set to one past the last pixel
+ */
+static void pixel_range(int first, int end, int view, int size, int pixels, int *from, int *to)
+{
+        *from = (first > view) ? (first - view) / size : 0;
+        *to = (end > view) ? (end - view + size - 1) / size : 0;
+        *to = (*to > pixels) ? pixels : *to;
+}
+
+/* the letters the overlay can draw and a 3 by 5 picture of each, one octal digit a row from the top,
+ * with the high bit on the left. anything else is drawn as a space */
+static const char glyph_chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ./+-:%";
+static const unsigned short glyphs[] = {
+        075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757, 075717,
+        025755, 065656, 034443, 065556, 074647, 074644, 034553, 055755, 072227, 011152,
+        055655, 044447, 057755, 065555, 025552, 065644, 025563, 065655, 034216, 072222,
+        055557, 055552, 055775, 055255, 055222, 071247, 000002, 011244, 002720, 000700,
+        002020, 051245
+};
+
+/**
+ * draws lines of text in the top left corner of the window on a dark box, with the small font above
+ * @param *render the renderer
+ * @param *text the lines, with a newline between them, lower case is drawn as upper case
+ */
+static void draw_text(struct render_t *render, const char *text)
+{
+        int bit;
+        int line = 0;
+        int across = 0;
+        int widest = 0;
+        int count = 0;
+        const char *at;
+        const char *found;
+        SDL_Rect box;
+        SDL_Rect pixels[15];
+
+        for (at = text; *at; at++) {
+                across = (*at == '\n') ? 0 : across + 1;
+                line += (*at == '\n');
+                widest = (across > widest) ? across : widest;
+        }
+
+        box.x = 0;
+        box.y = 0;
+        box.w = (widest * 4 + 2) * RENDER_TEXT_SCALE;
+        box.h = ((line + 1) * 6 + 2) * RENDER_TEXT_SCALE;
+        SDL_SetRenderDrawBlendMode(render->renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(render->renderer, 0, 0, 0, 192);
+        SDL_RenderFillRect(render->renderer, &box);
+        SDL_SetRenderDrawColor(render->renderer, 255, 255, 255, 255);
+
+        line = 0;
+        across = 0;
+        for (at = text; *at; at++) {
+                if (*at == '\n') {
+                        line++;
+                        across = 0;
+                        continue;
+                }
+
+                found = strchr(glyph_chars, toupper((unsigned char)*at));
+                for (bit = 0, count = 0; found && bit < 15; bit++) {
+                        if (glyphs[found - glyph_chars] >> (14 - bit) & 1) {
+                                pixels[count].x = ((across * 4 + 1) + bit % 3) * RENDER_TEXT_SCALE;
+                                pixels[count].y = ((line * 6 + 1) + bit / 3) * RENDER_TEXT_SCALE;
+                                pixels[count].w = RENDER_TEXT_SCALE;
+                                pixels[count].h = RENDER_TEXT_SCALE;
+                                count++;
+                        }
+                }
+                SDL_RenderFillRects(render->renderer, pixels, count);
+                across++;
+        }
+
+        SDL_SetRenderDrawColor(render->renderer, 0, 0, 0, 255); /* SDL_RenderClear paints with it */
+        SDL_SetRenderDrawBlendMode(render->renderer, SDL_BLENDMODE_NONE);
+}
+
+/**
+ * whether the cells of the whole view are in a region of the board
+ * @param *render the renderer
+ * @param row the board row of the top left corner of the region
+ * @param col the board col of the top left corner of the region
+ * @param rows the rows of the region
+ * @param cols the cols of the region
+ * @return 1 if they are, 0 if not
+ */
+static int view_inside(struct render_t *render, int row, int col, int rows, int cols)
+{
+        int across;
+        int down;
+        int size = cells_per_pixel(render);
+        int end_row;
+        int end_col;
+
+        view_size(render, &across, &down);
+        end_row = (render->view_row + across * size < render->rows) ? render->view_row + across * size : render->rows;
+        end_col = (render->view_col + down * size < render->cols) ? render->view_col + down * size : render->cols;
+
+        return size < TRIPLE_TILE && render->view_row >= row && end_row <= row + rows && render->view_col >= col && end_col <= col + cols;
+}
+
+/**
+ * asks the triple buffer for a region around the view when the view could be drawn from the cells and has left
+ * the region asked for last. A view too far out for a region to hold asks for nothing and is drawn from the counts
+ * @param *render the renderer
+ * @param *triple the triple buffer
+ */
+static void want_region(struct render_t *render, struct triple_t *triple)
+{
+        int across;
+        int down;
+        int size = cells_per_pixel(render);
+
+        view_size(render, &across, &down);
+
+        /* a region that is not the whole board needs a tile either side, it starts on a whole tile */
+        if (size >= TRIPLE_TILE || (triple->region_rows < render->rows && across * size > triple->region_rows - 2 * TRIPLE_TILE)
+                        || (triple->region_cols < render->cols && down * size > triple->region_cols - 2 * TRIPLE_TILE)
+                        || view_inside(render, render->want_row, render->want_col, triple->region_rows, triple->region_cols)) {
+                return;
+        }
+
+        /* the view in the middle of the region */
+        render->want_row = render->view_row - (triple->region_rows - across * size) / 2;
+        render->want_col = render->view_col - (triple->region_cols - down * size) / 2;
+        triple_want(triple, &render->want_row, &render->want_col);
+}
+
+/**
+ * draws the newest generation in the triple buffer, if there is one the window has not drawn or the view moved.
+ * With an overlay the frame is put up every time, so the numbers stay current while the board stands still
+ * @param *render the renderer
+ * @param *triple the triple buffer the generations come from
+ * @param *overlay lines to draw over the top left corner of the board, NULL for none
+ * @return 1 if a frame was drawn, 0 if nothing had changed
+ */
+int render_frame(struct render_t *render, struct triple_t *triple, const char *overlay)
+{
+        int t;
+        int u;
+        int end;
+        int across;
+        int down;
+        int x;
+        int end_x;
+        int y;
+        int end_y;
+        int size = cells_per_pixel(render);
+        unsigned char *dirty;
+        struct grid_t *grid;
+        unsigned long long seq;
+        int magnify = (render->zoom > 0) ? 1 << render->zoom : 1;
+        int moved;
+        SDL_Rect view;
+        SDL_Rect window;
+
+        want_region(render, triple);
+        grid = triple_take(triple, NULL);
+        seq = triple->seq[triple->front];
+
+        if (seq == render->seq && !render->moved && !overlay) {
+                return 0;
+        }
+
+        view_size(render, &across, &down);
+
+        /* a grid of another region, or one that can not draw the view from its cells, is drawn whole */
+        moved = render->moved || render->region_row != triple->row[triple->front] || render->region_col != triple->col[triple->front];
+        if (seq != render->seq || render->moved) {
+                render->cells = view_inside(render, triple->row[triple->front], triple->col[triple->front], triple->region_rows, triple->region_cols);
+                render->region_row = triple->row[triple->front];
+                render->region_col = triple->col[triple->front];
+        }
+
+        if (seq == render->seq && !render->moved) {
+                /* nothing new on the board, the texture already has it */
+        } else if (moved || seq != render->seq + 1) {
+                upload(render, grid, triple, 0, 0, across, down);
+        } else {
+                dirty = triple->dirty[triple->front];
+                for (u = 0; u < triple->tile_cols; u++) {
+                        pixel_range(u * TRIPLE_TILE, (u + 1) * TRIPLE_TILE, render->view_col, size, down, &y, &end_y);
+                        if (y >= end_y) {
+                                continue;
+                        }
+
+                        for (t = 0; t < triple->tile_rows; t = end) {
+                                end = t + 1;
+
+                                if (!dirty[t * triple->tile_cols + u]) {
+                                        continue;
+                                }
+
+                                /* draw the whole run of flagged tiles across as one rectangle */
+                                while (end < triple->tile_rows && dirty[end * triple->tile_cols + u]) {
+                                        end++;
+                                }
+
+                                pixel_range(t * TRIPLE_TILE, end * TRIPLE_TILE, render->view_row, size, across, &x, &end_x);
+                                upload(render, grid, triple, x, y, end_x, end_y);
+                        }
+                }
+        }
+        render->seq = seq;
+        render->moved = 0;
+
+        view.x = 0;
+        view.y = 0;
+        view.w = across;
+        view.h = down;
+        window.x = 0;
+        window.y = 0;
+        window.w = across * magnify;
+        window.h = down * magnify;
+
+        SDL_RenderClear(render->renderer);
+        SDL_RenderCopy(render->renderer, render->texture, &view, &window);
+
+        if (overlay) {
+                draw_text(render, overlay);
+        }
+        SDL_RenderPresent(render->renderer);
+
+        return 1;
+}
@@ -0,0 +1,63 @@
+#include "SDL2/SDL.h"
+#include "sdl.h"
+#include "life.h"
+#include "triple.h"
+
+/**
+ * @file render.h
+ * @breif headers for drawing the board through one streaming texture, in render.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef RENDER_H_
+#define RENDER_H_
+
+/* the most the window zooms in, 16 pixels a cell */
+#define RENDER_MAX_ZOOM 4
+/* window pixels on a side of one pixel of the overlay font */
+#define RENDER_TEXT_SCALE 2
+/* cells on a side of a pixel the triple buffer regions are made big enough to draw from the cells,
+ * further out a board bigger than the region is drawn from the tile counts */
+#define RENDER_CELLS 4
+
+/* a window sized texture and the part of the board it shows. zoom above 0 draws 1 << zoom pixels
+ * a cell and below 0 draws 1 << -zoom cells a pixel as a density map. view_row and view_col are
+ * the cell in the top left corner, pixels holds the whole texture, seq is the grid from the triple
+ * buffer that is in the texture and moved is set when the view changed and everything has to be drawn.
+ * want_row and want_col are the region asked of the triple buffer, region_row and region_col the region
+ * of the grid in the texture and cells is set when it was drawn from the cells, not the tile counts */
+struct render_t {
+        SDL_Renderer *renderer;
+        SDL_Texture *texture;
+        int rows;
+        int cols;
+        int width;
+        int height;
+        int zoom;
+        int view_row;
+        int view_col;
+        int moved;
+        Uint32 alive;
+        Uint32 dead;
+        Uint32 *pixels;
+        unsigned long long seq;
+        int want_row;
+        int want_col;
+        int region_row;
+        int region_col;
+        int cells;
+};
+
+struct render_t *init_render(struct sdl_info_t *sdl_info, int rows, int cols);
+
+void free_render(struct render_t *render);
+
+void render_pan(struct render_t *render, int right, int down);
+
+void render_zoom(struct render_t *render, int steps);
+
+int render_frame(struct render_t *render, struct triple_t *triple, const char *overlay);
+
+#endif
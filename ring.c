@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "transport.h"
+
+/**
+ * @file ring.c
+ * @breif A transport for worker processes on one machine, a ring buffer in POSIX shared memory for every link
+ * @details init_ring_transport makes one shared memory object with a ring for each worker and each direction, maps it and unlinks the name straight away, so the mapping is handed to the workers by fork and nothing is left behind in /dev/shm however the run ends. Each ring has one writer and one reader and counts the bytes ever written and ever read, the difference is what is waiting. The counts are guarded by a mutex and a condition shared between processes, a writer waits while the ring is full and a reader while it is empty. A message bigger than the ring goes through in pieces, so the ring only has to hold what can be in flight at once.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* the head of a ring, the bytes of the ring come right after it */
+struct ring_t {
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+        size_t written;
+        size_t read;
+};
+
+/* the mapping every ring lives in */
+struct ring_state_t {
+        void *map;
+        size_t map_size;
+        size_t capacity; /* bytes in each ring */
+        size_t stride; /* bytes from one ring head to the next */
+};
+
+/**
+ * finds the ring for messages a worker sends one way
+ * @param *transport the transport
+ * @param from the worker sending
+ * @param link LINK_UP or LINK_DOWN, which neighbor it is sending to
+ * @return the ring
+ */
+static struct ring_t *find_ring(struct transport_t *transport, int from, int link)
+{
+        struct ring_state_t *state = transport->state;
+
+        return (struct ring_t *)((char *)state->map + state->stride * (2 * from + link));
+}
+
+/**
+ * sends bytes to a neighbor, waiting for room in the ring when it is full
+ * @param *transport the transport
+ * @param self the worker sending
+ * @param link LINK_UP or LINK_DOWN
+ * @param *data the bytes to send
+ * @param len how many
+ * @return 0, the ring never breaks
+ */
+static int ring_send(struct transport_t *transport, int self, int link, const void *data, size_t len)
+{
+        struct ring_state_t *state = transport->state;
+        struct ring_t *ring = find_ring(transport, self, link);
+        char *bytes = (char *)(ring + 1);
+        const char *from = data;
+        size_t at;
+        size_t n;
+
+        pthread_mutex_lock(&ring->lock);
+        while (len > 0) {
+                while (ring->written - ring->read == state->capacity) {
+                        pthread_cond_wait(&ring->changed, &ring->lock);
+                }
+
+                /* as much as there is room for, up to the end of the ring */
+                at = ring->written % state->capacity;
+                n = state->capacity - (ring->written - ring->read);
+                n = (n < state->capacity - at) ? n : state->capacity - at;
+                n = (n < len) ? n : len;
+
+                memcpy(bytes + at, from, n);
+                ring->written += n;
+                from += n;
+                len -= n;
+                pthread_cond_broadcast(&ring->changed);
+        }
+        pthread_mutex_unlock(&ring->lock);
+
+        return 0;
+}
+
+/**
+ * reads bytes a neighbor sent, waiting for them when the ring is empty
+ * @param *transport the transport
+ * @param self the worker reading
+ * @param link LINK_UP to read what the worker above sent down, LINK_DOWN for what the worker below sent up
+ * @param *data where the bytes go
+ * @param len how many
+ * @return 0, the ring never breaks
+ */
+static int ring_recv(struct transport_t *transport, int self, int link, void *data, size_t len)
+{
+        struct ring_state_t *state = transport->state;
+        int procs = transport->procs;
+        struct ring_t *ring = (link == LINK_UP) ? find_ring(transport, (self + procs - 1) % procs, LINK_DOWN)
+                        : find_ring(transport, (self + 1) % procs, LINK_UP);
+        char *bytes = (char *)(ring + 1);
+        char *to = data;
+        size_t at;
+        size_t n;
+
+        pthread_mutex_lock(&ring->lock);
+        while (len > 0) {
+                while (ring->written == ring->read) {
+                        pthread_cond_wait(&ring->changed, &ring->lock);
+                }
+
+                at = ring->read % state->capacity;
+                n = ring->written - ring->read;
+                n = (n < state->capacity - at) ? n : state->capacity - at;
+                n = (n < len) ? n : len;
+
+                memcpy(to, bytes + at, n);
+                ring->read += n;
+                to += n;
+                len -= n;
+                pthread_cond_broadcast(&ring->changed);
+        }
+        pthread_mutex_unlock(&ring->lock);
+
+        return 0;
+}
+
+/**
+ * frees the rings, each process that has them mapped closes its own copy
+ * @param *transport the transport made by init_ring_transport
+ */
+static void ring_close(struct transport_t *transport)
+{
+        struct ring_state_t *state = transport->state;
+
+        munmap(state->map, state->map_size);
+        free(state);
+        free(transport);
+}
+
+/**
+ * Intilizes the rings for procs worker processes, to be called before they are forked
+ * @param procs how many workers there will be
+ * @param capacity the bytes each ring holds, enough for what a worker sends a neighbor before it waits on it
+ * @return the transport, or NULL if the shared memory could not be made
+ */
+struct transport_t *init_ring_transport(int procs, size_t capacity)
+{
+        int i;
+        int fd;
+        char name[64];
+        struct ring_t *ring;
+        struct ring_state_t *state;
+        pthread_mutexattr_t lock_attr;
+        pthread_condattr_t cond_attr;
+        struct transport_t *transport = malloc(sizeof(struct transport_t));
+
+        state = malloc(sizeof(struct ring_state_t));
+
+        if (!transport || !state) {
+                printf("Malloc failed\n");
+                free(transport);
+                free(state);
+                return NULL;
+        }
+
+        state->capacity = capacity;
+        state->stride = (sizeof(struct ring_t) + capacity + 63) & ~(size_t)63; /* every ring head on its own cache line */
+        state->map_size = state->stride * 2 * procs;
+
+        snprintf(name, sizeof(name), "/life-%d", (int)getpid());
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd == -1) {
+                printf("Could not make the shared memory %s\n", name);
+                free(transport);
+                free(state);
+                return NULL;
+        }
+        shm_unlink(name); /* the mapping lives on in every process that has it */
+
+        if (ftruncate(fd, state->map_size) == -1
+                        || (state->map = mmap(NULL, state->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+                printf("Could not map the shared memory %s\n", name);
+                close(fd);
+                free(transport);
+                free(state);
+                return NULL;
+        }
+        close(fd);
+
+        pthread_mutexattr_init(&lock_attr);
+        pthread_mutexattr_setpshared(&lock_attr, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_init(&cond_attr);
+        pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+
+        for (i = 0; i < 2 * procs; i++) {
+                ring = (struct ring_t *)((char *)state->map + state->stride * i);
+                pthread_mutex_init(&ring->lock, &lock_attr);
+                pthread_cond_init(&ring->changed, &cond_attr);
+                ring->written = 0;
+                ring->read = 0;
+        }
+
+        pthread_mutexattr_destroy(&lock_attr);
+        pthread_condattr_destroy(&cond_attr);
+
+        transport->procs = procs;
+        transport->send = ring_send;
+        transport->recv = ring_recv;
+        transport->close = ring_close;
+        transport->state = state;
+
+        return transport;
+}
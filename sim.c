@@ -0,0 +1,718 @@
+#include "sim.h"
+
+/**
+ * @file sim.c
+ * @breif Runs one board with whichever engine the user picked, so the window and the batch runner step it the same way
+ * @details init_sim makes the boards the engine in matrix_data needs and nothing else. The byte and active engines flip between two grids, the packed engine flips between two packed boards and the plane is one sparse_t. sim_view hands back a grid holding the current generation whatever the engine is, for the packed engine and the plane that means unpacking it into grid[0] first. Packed boards mapped from files with map_packed are too big to unpack, they have no grid and are loaded straight into the bits.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * steps a grid one generation, on the pool if there is one
+ * @param *grid the grid holding the current generation
+ * @param *next_grid the grid to be filled with the next generation
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *pool the pool to step on, NULL to step on this thread
+ * @param *active the tile flags for the active engine, NULL to step every cell
+ */
+static void step_grid(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data, struct pool_t *pool, struct active_t *active)
+{
+        if (active) {
+                check_board_active(grid, next_grid, matrix_data, active, pool);
+        } else if (pool) {
+                check_board_threaded(grid, next_grid, matrix_data, pool);
+        } else {
+                check_board(grid, next_grid, matrix_data);
+        }
+}
+
+/**
+ * steps a packed board one generation, on the pool if there is one
+ * @param *packed the board holding the current generation
+ * @param *next_packed the board to be filled with the next generation
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *pool the pool to step on, NULL to step on this thread
+ */
+static void step_packed(struct packed_t *packed, struct packed_t *next_packed, struct data_t *matrix_data, struct pool_t *pool)
+{
+        if (pool) {
+                check_board_packed_threaded(packed, next_packed, matrix_data, pool);
+        } else {
+                check_board_packed(packed, next_packed, matrix_data);
+        }
+}
+
+/**
+ * finds how far the alive cells of a grid are from its nearest edge
+ * @param *grid the grid
+ * @return the fewest cells between an alive cell and the edge, -1 if nothing is alive
+ */
+static int edge_margin(struct grid_t *grid)
+{
+        int i;
+        int j;
+        int margin = -1;
+        int far;
+
+        for (i = 0; i < grid->rows; i++) {
+                for (j = 0; j < grid->cols; j++) {
+                        if (!grid->cell[i][j]) {
+                                continue;
+                        }
+
+                        far = i;
+                        far = (grid->rows - 1 - i < far) ? grid->rows - 1 - i : far;
+                        far = (j < far) ? j : far;
+                        far = (grid->cols - 1 - j < far) ? grid->cols - 1 - j : far;
+                        margin = (margin < 0 || far < margin) ? far : margin;
+                }
+        }
+
+        return margin;
+}
+
+/**
+ * jumps a grid ahead a number of generations before the main loop starts. On the hedge
+ * HashLife takes 2^k generations at a time whenever the alive cells are more than 2^k from the
+ * edge, so nothing can reach the hedge during the jump and an unbounded plane steps the same way.
+ * While anything is closer than that it is stepped one generation at a time against the hedge.
+ * Torus and klein boards, and rules with B0 or more than two states or neighbors further than
+ * one cell away, are stepped one generation at a time all the way.
+ * @param *grid the grid to jump, it holds the result afterwards
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param generations how many generations to jump
+ * @param megabytes the memory cap for the HashLife nodes
+ */
+static void jump_board(struct grid_t *grid, struct data_t *matrix_data, unsigned long long generations, size_t megabytes)
+{
+        int margin;
+        unsigned long long step;
+        struct hashlife_t *life = NULL;
+        struct grid_t *next_grid = NULL;
+        struct grid_t *swap = NULL;
+        struct grid_t *start = grid;
+
+        if (matrix_data->edge == EDGE_HEDGE && rule_is_bits(get_rule()) && !(get_rule()->birth & 1)) {
+                life = init_hashlife(megabytes);
+
+                if (!life) {
+                        printf("Malloc failed exiting\n");
+                        exit(1);
+                }
+        } else {
+                fprintf(stderr, "HashLife only runs two state B/S rules without B0 on the hedge edge, stepping %llu generations one at a time\n", generations);
+        }
+
+        next_grid = init_grid(grid->rows, grid->cols);
+
+        if (!next_grid) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        while (generations > 0) {
+                margin = (life) ? edge_margin(grid) : 0;
+
+                if (margin < 0) {
+                        break; /* nothing alive stays that way without B0 */
+                }
+
+                if (margin > 0) {
+                        for (step = 1; step * 2 <= (unsigned long long)margin && step * 2 <= generations; step *= 2) {
+                        }
+
+                        hashlife_load(life, grid);
+                        if (hashlife_advance(life, step) != 0) {
+                                fprintf(stderr, "Pattern grew too big for HashLife, stopped at generation %llu\n", life->generation);
+                                break;
+                        }
+                        hashlife_store(life, grid);
+                        generations -= step;
+                        continue;
+                }
+
+                check_board(grid, next_grid, matrix_data);
+                swap = grid;
+                grid = next_grid;
+                next_grid = swap;
+                generations--;
+        }
+
+        if (grid != start) { /* an odd number of steps leaves the result in the other grid */
+                memcpy(start->block, grid->block, (size_t)grid->stride * (grid->rows + 2));
+                next_grid = grid;
+        }
+        free_grid(next_grid);
+        free_hashlife(life);
+}
+
+/**
+ * puts a cell in a HashLife universe, for handing to sparse_cells
+ * @param *target the hashlife_t
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+static void hashlife_cell(void *target, long long row, long long col)
+{
+        hashlife_set(target, row, col);
+}
+
+/**
+ * puts a cell on the plane, for handing to hashlife_cells
+ * @param *target the sparse_t
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+static void sparse_cell(void *target, long long row, long long col)
+{
+        sparse_set(target, row, col);
+}
+
+/**
+ * jumps the infinite plane ahead a number of generations with HashLife, nothing is lost since neither has an edge
+ * @param *sparse the plane to jump, it holds the result afterwards
+ * @param generations how many generations to jump
+ * @param megabytes the memory cap for the HashLife nodes
+ */
+static void jump_sparse(struct sparse_t *sparse, unsigned long long generations, size_t megabytes)
+{
+        struct hashlife_t *life = init_hashlife(megabytes);
+
+        if (!life) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        sparse_cells(sparse, hashlife_cell, life);
+        if (hashlife_advance(life, generations) != 0) {
+                fprintf(stderr, "Pattern grew too big for HashLife, stopped at generation %llu\n", life->generation);
+        }
+        sparse_clear(sparse);
+        hashlife_cells(life, sparse_cell, sparse);
+        sparse->generation += life->generation;
+        free_hashlife(life);
+}
+
+/**
+ * Intilizes a board of matrix_data->row_matrix by matrix_data->col_matrix for the engine, edge and threads in matrix_data
+ * @param *matrix_data a pointer to the main data for the matrix, kept by the sim
+ * @return the sim, or NULL if an allocation failed
+ */
+struct sim_t *init_sim(struct data_t *matrix_data)
+{
+        int rows = matrix_data->row_matrix;
+        int cols = matrix_data->col_matrix;
+        int ok = 1;
+        int i;
+        char path[SIZE];
+        struct sim_t *sim = calloc(1, sizeof(struct sim_t));
+
+        if (!sim) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        if (matrix_data->edge == EDGE_PLANE) {
+                matrix_data->engine = ENGINE_SPARSE; /* only the sparse engine has no edge */
+        }
+
+        sim->matrix_data = matrix_data;
+
+        if (!matrix_data->map || matrix_data->engine != ENGINE_PACKED) {
+                sim->grid[0] = init_grid(rows, cols);
+                ok = sim->grid[0] != NULL;
+        }
+
+        if (matrix_data->engine == ENGINE_SPARSE) {
+                sim->sparse = init_sparse();
+                ok = ok && sim->sparse;
+        } else if (matrix_data->engine == ENGINE_PACKED && matrix_data->map) {
+                for (i = 0; i < 2; i++) {
+                        snprintf(path, SIZE, "%s.%d", matrix_data->map, i);
+                        sim->packed[i] = map_packed(rows, cols, path);
+                }
+                ok = sim->packed[0] && sim->packed[1];
+
+                if (ok) {
+                        sim->mapped = init_mapped(sim->packed[0]->words, matrix_data->threads);
+                        ok = sim->mapped != NULL;
+                }
+        } else if (matrix_data->engine == ENGINE_PACKED) {
+                sim->packed[0] = init_packed(rows, cols);
+                sim->packed[1] = init_packed(rows, cols);
+                ok = ok && sim->packed[0] && sim->packed[1];
+        } else {
+                sim->grid[1] = init_grid(rows, cols);
+                ok = ok && sim->grid[1];
+        }
+
+        if (matrix_data->engine == ENGINE_ACTIVE) {
+                sim->active = init_active(rows, cols);
+                ok = ok && sim->active;
+        }
+
+        if (matrix_data->threads > 1 && matrix_data->engine != ENGINE_SPARSE) {
+                sim->pool = init_pool(matrix_data->threads);
+                ok = ok && sim->pool;
+        }
+
+        if (matrix_data->depth > 1 && matrix_data->engine == ENGINE_BYTE) {
+                sim->temporal = init_temporal(matrix_data->depth, matrix_data->threads);
+                ok = ok && sim->temporal;
+        }
+
+        if (!ok) {
+                free_sim(sim);
+                return NULL;
+        }
+
+        return sim;
+}
+
+/**
+ * frees a sim made by init_sim, the data_t is left alone
+ * @param *sim the sim to free, may be NULL
+ */
+void free_sim(struct sim_t *sim)
+{
+        if (!sim) {
+                return;
+        }
+
+        free_grid(sim->grid[0]);
+        free_grid(sim->grid[1]);
+        free_packed(sim->packed[0]);
+        free_packed(sim->packed[1]);
+        free_sparse(sim->sparse);
+        free_active(sim->active);
+        free_pool(sim->pool);
+        free_temporal(sim->temporal);
+        free_mapped(sim->mapped);
+        free(sim);
+}
+
+/**
+ * moves a sim over to the byte engine, the only one that runs every rule
+ * @param *sim the sim, its current generation is kept
+ * @return 0 on success, -1 if the second grid could not be made
+ */
+static int use_byte_engine(struct sim_t *sim)
+{
+        if (sim->packed[0]) {
+                unpack_grid(sim->grid[0], sim->packed[sim->cur]);
+                free_packed(sim->packed[0]);
+                free_packed(sim->packed[1]);
+                sim->packed[0] = NULL;
+                sim->packed[1] = NULL;
+                sim->cur = 0;
+        }
+
+        free_active(sim->active); /* its tiles only see the cells next to them */
+        sim->active = NULL;
+
+        if (!sim->grid[1]) {
+                sim->grid[1] = init_grid(sim->grid[0]->rows, sim->grid[0]->cols);
+                if (!sim->grid[1]) {
+                        return -1;
+                }
+        }
+
+        if (sim->matrix_data->depth > 1 && !sim->temporal) {
+                sim->temporal = init_temporal(sim->matrix_data->depth, sim->matrix_data->threads);
+                if (!sim->temporal) {
+                        return -1;
+                }
+        }
+
+        sim->matrix_data->engine = ENGINE_BYTE;
+        return 0;
+}
+
+/**
+ * changes the rule the sim steps with. A rule with more than two states moves the packed engine over
+ * to the byte engine, one with a radius over 1 moves the active one too, and neither runs on the plane
+ * @param *sim the sim
+ * @param *text the rule in any notation parse_rule reads
+ * @return 0 on success, -1 if text is not a rule or the edge can not run it, B0 would turn on all of the plane and a
+ * Larger than Life square reaches around more than one side of a cross surface, where the sides do not line up. A
+ * mapped board only runs what the packed engine runs, it has nowhere to be unpacked to
+ */
+int sim_rule(struct sim_t *sim, const char *text)
+{
+        struct rule_t rule;
+
+        if (parse_rule(text, &rule) == -1 || (sim->sparse && ((rule.birth & 1) || !rule_is_bits(&rule)))
+                        || (sim->matrix_data->edge == EDGE_CROSS && rule.radius > 1) || (sim->mapped && !rule_is_bits(&rule))) {
+                return -1;
+        }
+
+        /* packed cells have no room for a state, and active tiles only wake the tiles right next to them */
+        if ((!rule_is_bits(&rule) && sim->packed[0]) || (rule.radius > 1 && sim->active)) {
+                if (use_byte_engine(sim) == -1) {
+                        return -1;
+                }
+                fprintf(stderr, "The rule %s can not be run on this engine, using the byte engine\n", rule.text);
+        }
+
+        set_rule(&rule);
+        strcpy(sim->matrix_data->rule, rule.text);
+
+        return 0;
+}
+
+/**
+ * makes every cell of a grid a state the rule has, a two state rule takes anything that is not 0 as alive
+ * @param *grid the grid to fix
+ */
+static void fit_states(struct grid_t *grid)
+{
+        int i;
+        int j;
+        int states = get_rule()->states;
+
+        for (i = 0; i < grid->rows; i++) {
+                for (j = 0; j < grid->cols; j++) {
+                        if (grid->cell[i][j] >= states) {
+                                grid->cell[i][j] = 1;
+                        }
+                }
+        }
+}
+
+/**
+ * uses the rule a pattern file or checkpoint was made with, unless the user picked one, and gets the
+ * board that was just loaded into the current grid ready to step with it
+ * @param *sim the sim
+ * @param *text the rule that came with the file, empty if there was none
+ */
+void sim_file_rule(struct sim_t *sim, const char *text)
+{
+        if (sim->packed[0] && !sim->mapped) {
+                pack_grid(sim->packed[sim->cur], sim->grid[sim->cur]); /* moving to the byte engine unpacks it */
+        }
+
+        if (text[0] != '\0' && !sim->matrix_data->rule_given && sim_rule(sim, text) == -1) {
+                fprintf(stderr, "The rule %s from the file can not be run, using %s\n", text, sim->matrix_data->rule);
+        }
+
+        if (sim->sparse || sim->mapped) {
+                return; /* loaded straight onto the board, and neither has a state but alive */
+        }
+
+        fit_states(sim->grid[sim->cur]);
+
+        if (sim->packed[0]) {
+                pack_grid(sim->packed[sim->cur], sim->grid[sim->cur]);
+        }
+
+        if (sim->active) {
+                mark_all_active(sim->active);
+        }
+}
+
+/**
+ * loads a pattern file onto the board, placed the same way parse_file places it, and uses the rule it names unless the user picked one
+ * @param *sim the sim, should still be empty
+ * @param *filepath the file to load, RLE, life 1.05, .cells or life 1.06
+ * @param x the offset for the x value that the user entered
+ * @param y the offset for the y value that the user entered
+ * @return 0 on success, -1 if the file could not be read
+ */
+int sim_load(struct sim_t *sim, char *filepath, int x, int y)
+{
+        char rule[RULE_SIZE];
+
+        if (sim->sparse) {
+                if (parse_file_sparse(sim->sparse, filepath, x, y, rule) == -1) {
+                        return -1;
+                }
+                sim_file_rule(sim, rule);
+                return 0;
+        }
+
+        if (sim->mapped) {
+                if (parse_file_packed(sim->packed[sim->cur], filepath, x, y, sim->matrix_data, rule) == -1) {
+                        return -1;
+                }
+                sim_file_rule(sim, rule);
+                return 0;
+        }
+
+        if (parse_file(sim->grid[sim->cur], filepath, x, y, sim->matrix_data, rule) == -1) {
+                return -1;
+        }
+        sim_file_rule(sim, rule);
+
+        return 0;
+}
+
+/**
+ * jumps the board ahead, with HashLife where the edge allows it
+ * @param *sim the sim, not one with mapped boards
+ * @param generations how many generations to jump
+ * @param megabytes the memory cap for the HashLife nodes
+ */
+void sim_jump(struct sim_t *sim, unsigned long long generations, size_t megabytes)
+{
+        if (sim->sparse) {
+                jump_sparse(sim->sparse, generations, megabytes);
+        } else {
+                jump_board(sim_view(sim), sim->matrix_data, generations, megabytes);
+
+                if (sim->packed[0]) {
+                        pack_grid(sim->packed[sim->cur], sim->grid[0]);
+                }
+
+                if (sim->active) {
+                        mark_all_active(sim->active);
+                }
+        }
+
+        sim->generation += generations;
+}
+
+/**
+ * puts a board back in the sim, for going back to a generation kept somewhere else
+ * @param *sim the sim
+ * @param *grid the board, the size of the sim's board
+ * @param generation its generation
+ * @return 0, or -1 for the plane and mapped boards, a grid only holds part of those
+ */
+int sim_restore(struct sim_t *sim, struct grid_t *grid, unsigned long long generation)
+{
+        int i;
+        struct grid_t *board;
+
+        if (sim->sparse || sim->mapped) {
+                return -1;
+        }
+
+        board = (sim->packed[0]) ? sim->grid[0] : sim->grid[sim->cur];
+        for (i = 0; i < board->rows; i++) {
+                memcpy(board->cell[i], grid->cell[i], board->cols);
+        }
+
+        if (sim->packed[0]) {
+                pack_grid(sim->packed[sim->cur], sim->grid[0]);
+        }
+
+        if (sim->active) {
+                mark_all_active(sim->active);
+        }
+
+        sim->generation = generation;
+
+        return 0;
+}
+
+/**
+ * steps the board one generation with its engine
+ * @param *sim the sim
+ */
+void sim_step(struct sim_t *sim)
+{
+        if (sim->sparse) {
+                sparse_step(sim->sparse);
+        } else if (sim->mapped) {
+                check_board_mapped(sim->packed[sim->cur], sim->packed[!sim->cur], sim->matrix_data, sim->mapped, sim->pool);
+                sim->cur = !sim->cur;
+        } else if (sim->packed[0]) {
+                step_packed(sim->packed[sim->cur], sim->packed[!sim->cur], sim->matrix_data, sim->pool);
+                sim->cur = !sim->cur;
+        } else {
+                /*filp back and forth between the two grids, check_board writes every cell so neither needs clearing */
+                step_grid(sim->grid[sim->cur], sim->grid[!sim->cur], sim->matrix_data, sim->pool, sim->active);
+                sim->cur = !sim->cur;
+        }
+
+        sim->generation++;
+}
+
+/**
+ * steps the sim a number of generations. With a depth set the byte engine takes them that many
+ * at a time in tiles that stay in the cache, the other engines and boards it can not tile step one at a time.
+ * The last generation is always stepped on its own, so the grid it was stepped from is the generation
+ * before it and sim_changes counts one generation whatever the depth
+ * @param *sim the sim
+ * @param generations how many generations to step
+ */
+void sim_advance(struct sim_t *sim, unsigned long long generations)
+{
+        int depth;
+
+        while (generations > 0) {
+                depth = (sim->temporal && !sim->active && !sim->packed[0] && !sim->sparse) ? sim->temporal->depth : 1;
+                if (depth > generations - 1) {
+                        depth = generations - 1;
+                }
+
+                if (depth > 1 && temporal_fits(sim->grid[sim->cur], sim->matrix_data->edge, depth)) {
+                        check_board_temporal(sim->grid[sim->cur], sim->grid[!sim->cur], sim->matrix_data, sim->temporal, sim->pool, depth);
+                        sim->cur = !sim->cur;
+                        sim->generation += depth;
+                        generations -= depth;
+                } else {
+                        sim_step(sim);
+                        generations--;
+                }
+        }
+}
+
+/**
+ * gets a grid holding the current generation, it must not be changed by the caller
+ * @param *sim the sim
+ * @return the grid, for the plane it holds the part from 0, 0 on, NULL for mapped boards which have no grid
+ */
+struct grid_t *sim_view(struct sim_t *sim)
+{
+        if (sim->mapped) {
+                return NULL;
+        } else if (sim->sparse) {
+                sparse_view(sim->sparse, sim->grid[0], 0, 0);
+                return sim->grid[0];
+        } else if (sim->packed[0]) {
+                unpack_grid(sim->grid[0], sim->packed[sim->cur]);
+                return sim->grid[0];
+        }
+
+        return sim->grid[sim->cur];
+}
+
+/**
+ * counts the alive cells on the board
+ * @param *sim the sim
+ * @return the number of alive cells
+ */
+long long sim_population(struct sim_t *sim)
+{
+        int i;
+        int j;
+        long long count = 0;
+        struct grid_t *grid;
+
+        if (sim->sparse) {
+                return sparse_population(sim->sparse);
+        } else if (sim->packed[0]) {
+                return packed_population(sim->packed[sim->cur]);
+        }
+
+        grid = sim->grid[sim->cur];
+        for (i = 0; i < grid->rows; i++) {
+                for (j = 0; j < grid->cols; j++) {
+                        count += grid->cell[i][j] == 1; /* dying cells are not alive */
+                }
+        }
+
+        return count;
+}
+
+/**
+ * the bytes the boards of a sim take up, what the engine picked costs in memory
+ * @param *sim the sim
+ * @return the bytes in its grids, packed boards, tile flags and the chunks of the plane, mapped boards
+ * are in their files and only their halo rows count
+ */
+size_t sim_memory(struct sim_t *sim)
+{
+        int i;
+        size_t bytes = 0;
+        size_t tiles;
+
+        for (i = 0; i < 2; i++) {
+                if (sim->grid[i]) {
+                        bytes += (size_t)sim->grid[i]->stride * (sim->grid[i]->rows + 2);
+                }
+                if (sim->packed[i] && !sim->packed[i]->mapped) {
+                        bytes += sizeof(uint64_t) * sim->packed[i]->words * (sim->packed[i]->rows + 2);
+                }
+        }
+
+        if (sim->active) {
+                tiles = (size_t)sim->active->tile_rows * sim->active->tile_cols;
+                bytes += tiles * (3 + sizeof(int));
+        }
+
+        if (sim->temporal) {
+                bytes += (size_t)2 * sim->temporal->threads * sim->temporal->scratch[0]->stride * (sim->temporal->scratch[0]->rows + 2);
+        }
+
+        if (sim->mapped) {
+                bytes += sizeof(uint64_t) * MAPPED_HALO * sim->mapped->words * sim->mapped->threads;
+        }
+
+        if (sim->sparse) {
+                bytes += sim->sparse->count * sizeof(struct chunk_t);
+                bytes += (sim->sparse->buckets + sim->sparse->capacity) * sizeof(struct chunk_t *);
+        }
+
+        return bytes;
+}
+
+/**
+ * counts the cells that came alive and the ones that stopped being alive in a block of two grids
+ * @param *grid the newer grid
+ * @param *last the grid it was stepped from
+ * @param first the first row
+ * @param last_row one past the last row
+ * @param col the first col
+ * @param last_col one past the last col
+ * @param *births added to for every cell that came alive
+ * @param *deaths added to for every cell that stopped being alive
+ */
+static void count_changes(struct grid_t *grid, struct grid_t *last, int first, int last_row, int col, int last_col,
+                long long *births, long long *deaths)
+{
+        int i;
+        int j;
+
+        for (i = first; i < last_row; i++) {
+                for (j = col; j < last_col; j++) {
+                        *births += (grid->cell[i][j] == 1) & (last->cell[i][j] != 1);
+                        *deaths += (last->cell[i][j] == 1) & (grid->cell[i][j] != 1);
+                }
+        }
+}
+
+/**
+ * counts the cells born and the cells that died in the last generation stepped. The byte engine
+ * compares the whole of both grids, the active engine only the tiles that changed
+ * @param *sim the sim, it has to have stepped at least once since it was loaded
+ * @param *births set to the cells that came alive
+ * @param *deaths set to the cells that stopped being alive, dying states of a generations rule included
+ */
+void sim_changes(struct sim_t *sim, long long *births, long long *deaths)
+{
+        int t;
+        int u;
+        int row;
+        int col;
+        struct grid_t *grid = sim->grid[sim->cur];
+        struct grid_t *last = sim->grid[!sim->cur];
+        struct active_t *active = sim->active;
+
+        *births = 0;
+        *deaths = 0;
+
+        if (sim->sparse) {
+                *births = sim->sparse->births;
+                *deaths = sim->sparse->deaths;
+        } else if (sim->packed[0]) {
+                packed_changes(sim->packed[sim->cur], sim->packed[!sim->cur], births, deaths);
+        } else if (!active) {
+                count_changes(grid, last, 0, grid->rows, 0, grid->cols, births, deaths);
+        } else {
+                for (t = 0; t < active->tile_rows; t++) {
+                        for (u = 0; u < active->tile_cols; u++) {
+                                if (!active->changed[t * active->tile_cols + u]) {
+                                        continue; /* the same in both grids */
+                                }
+                                row = t * TILE_SIZE;
+                                col = u * TILE_SIZE;
+                                count_changes(grid, last, row, (row + TILE_SIZE < grid->rows) ? row + TILE_SIZE : grid->rows,
+                                                col, (col + TILE_SIZE < grid->cols) ? col + TILE_SIZE : grid->cols, births, deaths);
+                        }
+                }
+        }
+}
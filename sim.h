@@ -0,0 +1,63 @@
+#include "life.h"
+#include "packed.h"
+#include "pool.h"
+#include "active.h"
+#include "hashlife.h"
+#include "sparse.h"
+#include "temporal.h"
+#include "mapped.h"
+
+/**
+ * @file sim.h
+ * @breif headers for running a board with whichever engine was picked, in sim.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+/* everything one running board needs. grid[cur] is the current generation for the
+ * byte and active engines, the other engines only use grid[0] to show their board.
+ * Packed boards mapped from files have no grid at all, they are too big for one */
+struct sim_t {
+        struct data_t *matrix_data;
+        struct grid_t *grid[2];
+        struct packed_t *packed[2];
+        struct sparse_t *sparse;
+        struct active_t *active;
+        struct pool_t *pool;
+        struct temporal_t *temporal; /* only when the byte engine steps more than one generation a pass */
+        struct mapped_t *mapped; /* only when the packed boards are mapped from files */
+        int cur;
+        unsigned long long generation;
+};
+
+struct sim_t *init_sim(struct data_t *matrix_data);
+
+void free_sim(struct sim_t *sim);
+
+int sim_rule(struct sim_t *sim, const char *text);
+
+void sim_file_rule(struct sim_t *sim, const char *text);
+
+int sim_load(struct sim_t *sim, char *filepath, int x, int y);
+
+void sim_jump(struct sim_t *sim, unsigned long long generations, size_t megabytes);
+
+int sim_restore(struct sim_t *sim, struct grid_t *grid, unsigned long long generation);
+
+void sim_step(struct sim_t *sim);
+
+void sim_advance(struct sim_t *sim, unsigned long long generations);
+
+struct grid_t *sim_view(struct sim_t *sim);
+
+long long sim_population(struct sim_t *sim);
+
+size_t sim_memory(struct sim_t *sim);
+
+void sim_changes(struct sim_t *sim, long long *births, long long *deaths);
+
+#endif
@@ -0,0 +1,137 @@
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @file simd.c
+ * @breif Vector versions of step_row_scalar and picking the best one the cpu can run
+ * @details Cells are one byte that is 0 or 1 so the 8 neighbors of 16 or 32 cells can be added with one byte add per neighbor without overflowing. The ghost border means the neighbors are just the rows above, here and below loaded one byte to the left and right. The counts are never more than 8 so they index the 16 byte born and stays tables of the rule directly with a byte shuffle, which looks up 16 or 32 cells at once whatever the rule is. That shuffle is why the 128 bit kernel needs SSSE3 rather than plain SSE2. Each kernel is built for its own instruction set with the target attribute so the rest of the program does not need -mavx2, and select_kernel asks the cpu which ones it has before any of them run. Whatever is left over at the end of a row goes through step_row_scalar.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Steps one row 16 cells at a time with SSSE3
+ * @param *above the row above, starting at the first cell to step
+ * @param *here the row being stepped
+ * @param *below the row below
+ * @param *out where the next generation of the row is written
+ * @param cols the number of cells to step
+ */
+__attribute__((target("ssse3")))
+void step_row_ssse3(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols)
+{
+        int j;
+        __m128i count;
+        __m128i alive;
+        __m128i next;
+        const struct rule_t *rule = get_rule();
+        const __m128i born = _mm_loadu_si128((const __m128i *)rule->next[0]);
+        const __m128i stays = _mm_loadu_si128((const __m128i *)rule->next[1]);
+
+        for (j = 0; j + 16 <= cols; j += 16) {
+                alive = _mm_loadu_si128((const __m128i *)(here + j));
+                count = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(above + j - 1)), _mm_loadu_si128((const __m128i *)(above + j)));
+                count = _mm_add_epi8(count, _mm_loadu_si128((const __m128i *)(above + j + 1)));
+                count = _mm_add_epi8(count, _mm_loadu_si128((const __m128i *)(here + j - 1)));
+                count = _mm_add_epi8(count, _mm_loadu_si128((const __m128i *)(here + j + 1)));
+                count = _mm_add_epi8(count, _mm_loadu_si128((const __m128i *)(below + j - 1)));
+                count = _mm_add_epi8(count, _mm_loadu_si128((const __m128i *)(below + j)));
+                count = _mm_add_epi8(count, _mm_loadu_si128((const __m128i *)(below + j + 1)));
+
+                /* the tables hold 0 and 1, andnot with a 1 byte clears it so dead cells take born and alive ones stays */
+                next = _mm_or_si128(_mm_andnot_si128(alive, _mm_shuffle_epi8(born, count)),
+                                _mm_and_si128(alive, _mm_shuffle_epi8(stays, count)));
+                _mm_storeu_si128((__m128i *)(out + j), next);
+        }
+
+        step_row_scalar(above + j, here + j, below + j, out + j, cols - j);
+}
+
+/**
+ * Steps one row 32 cells at a time with AVX2
+ * @param *above the row above, starting at the first cell to step
+ * @param *here the row being stepped
+ * @param *below the row below
+ * @param *out where the next generation of the row is written
+ * @param cols the number of cells to step
+ */
+__attribute__((target("avx2")))
+void step_row_avx2(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols)
+{
+        int j;
+        __m256i count;
+        __m256i alive;
+        __m256i next;
+        const struct rule_t *rule = get_rule();
+        /* the shuffle looks up within each 128 bit half, so both halves get a copy of the table */
+        const __m256i born = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)rule->next[0]));
+        const __m256i stays = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)rule->next[1]));
+
+        for (j = 0; j + 32 <= cols; j += 32) {
+                alive = _mm256_loadu_si256((const __m256i *)(here + j));
+                count = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(above + j - 1)), _mm256_loadu_si256((const __m256i *)(above + j)));
+                count = _mm256_add_epi8(count, _mm256_loadu_si256((const __m256i *)(above + j + 1)));
+                count = _mm256_add_epi8(count, _mm256_loadu_si256((const __m256i *)(here + j - 1)));
+                count = _mm256_add_epi8(count, _mm256_loadu_si256((const __m256i *)(here + j + 1)));
+                count = _mm256_add_epi8(count, _mm256_loadu_si256((const __m256i *)(below + j - 1)));
+                count = _mm256_add_epi8(count, _mm256_loadu_si256((const __m256i *)(below + j)));
+                count = _mm256_add_epi8(count, _mm256_loadu_si256((const __m256i *)(below + j + 1)));
+
+                next = _mm256_or_si256(_mm256_andnot_si256(alive, _mm256_shuffle_epi8(born, count)),
+                                _mm256_and_si256(alive, _mm256_shuffle_epi8(stays, count)));
+                _mm256_storeu_si256((__m256i *)(out + j), next);
+        }
+
+        /* finish with 16 at a time before dropping to one at a time */
+        step_row_ssse3(above + j, here + j, below + j, out + j, cols - j);
+}
+
+/**
+ * Picks the fastest row kernel the cpu supports and hands it to set_row_kernel, call once at startup
+ * @return the name of the kernel that was picked
+ */
+const char *select_kernel(void)
+{
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2")) {
+                set_row_kernel(step_row_avx2);
+                return "avx2";
+        } else if (__builtin_cpu_supports("ssse3")) {
+                set_row_kernel(step_row_ssse3);
+                return "ssse3";
+        }
+
+        set_row_kernel(step_row_scalar);
+        return "scalar";
+}
+
+#else
+
+void step_row_ssse3(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols)
+{
+        step_row_scalar(above, here, below, out, cols);
+}
+
+void step_row_avx2(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols)
+{
+        step_row_scalar(above, here, below, out, cols);
+}
+
+/**
+ * Without x86 vector units the scalar kernel is the only one
+ * @return the name of the kernel that was picked
+ */
+const char *select_kernel(void)
+{
+        set_row_kernel(step_row_scalar);
+        return "scalar";
+}
+
+#endif
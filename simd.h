@@ -0,0 +1,20 @@
+#include "life.h"
+
+/**
+ * @file simd.h
+ * @breif headers for the vector row kernels in simd.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef SIMD_H_
+#define SIMD_H_
+
+void step_row_ssse3(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols);
+
+void step_row_avx2(const unsigned char *above, const unsigned char *here, const unsigned char *below, unsigned char *out, int cols);
+
+const char *select_kernel(void);
+
+#endif
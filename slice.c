@@ -0,0 +1,239 @@
+#include "slice.h"
+#include "packed.h"
+
+/**
+ * @file slice.c
+ * @breif Steps 64 small boards at once by giving each one a bit of every word, for running many soups
+ * @details A packed board puts 64 cells of one board side by side in a word, a slice puts the same cell of 64 boards in a word instead. The 8 neighbors of a word are then just the 8 words around it, with no shifting, so the full adders of life_word step a cell of all 64 boards in the time the byte engine steps one cell. Every board also keeps the hash cycle.c keeps, the XOR of a key for every alive cell, and its population. Both only change where a cell changed, so a generation adds a little work for every cell that flipped on a board that has not settled, and nothing for the ones that have. After a generation each board looks its hash up in a table of its own past hashes, picked by the hash the same way cycle.c does, and a board that finds itself there has settled into a still life, an oscillator or nothing at all. The slice keeps stepping the settled boards with the others, they cost nothing extra, until every board has settled or the run is out of generations.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * Intilizes a slice of 64 boards of rows by cols cells, all dead and all settled until slice_soups fills it
+ * @param rows the rows of every board
+ * @param cols the cols of every board
+ * @param edge the edge of every board, hedge or torus
+ * @return the slice, or NULL if an allocation failed
+ */
+struct slice_t *init_slice(int rows, int cols, int edge)
+{
+        struct slice_t *slice = calloc(1, sizeof(struct slice_t));
+
+        if (!slice) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        slice->rows = rows;
+        slice->cols = cols;
+        slice->stride = cols + 2;
+        slice->edge = edge;
+        slice->cell[0] = calloc((size_t)(rows + 2) * slice->stride, sizeof(uint64_t));
+        slice->cell[1] = calloc((size_t)(rows + 2) * slice->stride, sizeof(uint64_t));
+        slice->history = calloc((size_t)SLICE_BOARDS * SLICE_HISTORY, sizeof(struct slice_entry_t));
+
+        if (!slice->cell[0] || !slice->cell[1] || !slice->history) {
+                printf("Malloc failed\n");
+                free_slice(slice);
+                return NULL;
+        }
+
+        return slice;
+}
+
+/**
+ * frees a slice made by init_slice
+ * @param *slice the slice, may be NULL
+ */
+void free_slice(struct slice_t *slice)
+{
+        if (!slice) {
+                return;
+        }
+
+        free(slice->cell[0]);
+        free(slice->cell[1]);
+        free(slice->history);
+        free(slice);
+}
+
+/**
+ * looks a board up in its table of past hashes and puts it there if it is not in it
+ * @param *slice the slice
+ * @param board which board
+ * @return 1 if the board was in the table, then settled and period say since when, otherwise 0
+ */
+static int seen_before(struct slice_t *slice, int board)
+{
+        struct slice_entry_t *entry = &slice->history[(size_t)board * SLICE_HISTORY + (slice->hash[board] & (SLICE_HISTORY - 1))];
+
+        if (entry->generation && entry->hash == slice->hash[board]) {
+                slice->settled[board] = entry->generation - 1;
+                slice->period[board] = slice->generation - slice->settled[board];
+                return 1;
+        }
+
+        entry->hash = slice->hash[board];
+        entry->generation = slice->generation + 1;
+        return 0;
+}
+
+/**
+ * fills the slice with random soups in a square in the middle of every board, and starts them all over
+ * @param *slice the slice
+ * @param seed the seed of the run, soup n of a seed is always the same whichever slice it ends up in
+ * @param first the number of the soup for board 0, board k gets soup first + k
+ * @param count how many boards get a soup, at most SLICE_BOARDS, the rest are left empty and settled
+ * @param size the rows and cols of the soups, at most the rows and cols of the boards
+ * @param density the chance each cell of a soup is alive
+ */
+void slice_soups(struct slice_t *slice, uint64_t seed, unsigned long long first, int count, int size, double density)
+{
+        int i;
+        int j;
+        int k;
+        int top = (slice->rows - size) / 2;
+        int left = (slice->cols - size) / 2;
+        uint64_t soup;
+        uint64_t *word;
+
+        memset(slice->cell[0], 0, sizeof(uint64_t) * (slice->rows + 2) * slice->stride);
+        memset(slice->cell[1], 0, sizeof(uint64_t) * (slice->rows + 2) * slice->stride);
+        memset(slice->history, 0, sizeof(struct slice_entry_t) * SLICE_BOARDS * SLICE_HISTORY);
+        slice->cur = 0;
+        slice->generation = 0;
+        slice->live = (count >= SLICE_BOARDS) ? ~0ULL : (1ULL << count) - 1;
+
+        for (k = 0; k < SLICE_BOARDS; k++) {
+                slice->hash[k] = 0;
+                slice->population[k] = 0;
+                slice->settled[k] = -1;
+                slice->period[k] = 0;
+
+                if (!(slice->live >> k & 1)) {
+                        continue;
+                }
+
+                soup = hash_mix(hash_mix(seed) ^ (first + k));
+                for (i = top; i < top + size; i++) {
+                        for (j = left; j < left + size; j++) {
+                                if (hash_mix(soup + (uint64_t)i * slice->cols + j) < density * 18446744073709551616.0) {
+                                        word = slice->cell[0] + (size_t)(i + 1) * slice->stride + j + 1;
+                                        *word |= 1ULL << k;
+                                        slice->hash[k] ^= hash_key((uint64_t)i * slice->cols + j);
+                                        slice->population[k]++;
+                                }
+                        }
+                }
+                seen_before(slice, k);
+        }
+}
+
+/**
+ * copies the cells around the torus into the ghost border
+ * @param *slice the slice
+ * @param *cell the boards to fill the border of
+ */
+static void wrap_ghost(struct slice_t *slice, uint64_t *cell)
+{
+        int i;
+        uint64_t *row;
+
+        for (i = 1; i <= slice->rows; i++) {
+                row = cell + (size_t)i * slice->stride;
+                row[0] = row[slice->cols];
+                row[slice->cols + 1] = row[1];
+        }
+
+        memcpy(cell, cell + (size_t)slice->rows * slice->stride, sizeof(uint64_t) * slice->stride);
+        memcpy(cell + (size_t)(slice->rows + 1) * slice->stride, cell + slice->stride, sizeof(uint64_t) * slice->stride);
+}
+
+/**
+ * steps every board of the slice one generation and looks for the ones that settled. The ghost border of
+ * the hedge is never written, so it stays dead
+ * @param *slice the slice
+ * @return a bit set for every board that settled this generation, they are taken out of live
+ */
+uint64_t slice_step(struct slice_t *slice)
+{
+        int i;
+        int j;
+        int k;
+        int cols = slice->cols;
+        uint64_t *from = slice->cell[slice->cur];
+        uint64_t *to = slice->cell[!slice->cur];
+        const uint64_t *up;
+        const uint64_t *here;
+        const uint64_t *down;
+        uint64_t *out;
+        uint64_t next;
+        uint64_t changed;
+        uint64_t key;
+        uint64_t bits;
+        uint64_t done = 0;
+        const struct rule_t *rule = get_rule();
+
+        if (slice->edge == EDGE_TORUS) {
+                wrap_ghost(slice, from);
+        }
+
+        for (i = 0; i < slice->rows; i++) {
+                up = from + (size_t)i * slice->stride + 1;
+                here = up + slice->stride;
+                down = here + slice->stride;
+                out = to + (size_t)(i + 1) * slice->stride + 1;
+
+                for (j = 0; j < cols; j++) {
+                        next = life_word(up[j - 1], up[j], up[j + 1], here[j - 1], here[j], here[j + 1], down[j - 1], down[j], down[j + 1], rule);
+                        out[j] = next;
+
+                        /* only the boards still being watched pay for the cells that flipped */
+                        changed = (next ^ here[j]) & slice->live;
+                        if (changed) {
+                                key = hash_key((uint64_t)i * cols + j);
+                                for (bits = changed; bits; bits &= bits - 1) {
+                                        k = __builtin_ctzll(bits);
+                                        slice->hash[k] ^= key;
+                                        slice->population[k] += (next >> k & 1) ? 1 : -1;
+                                }
+                        }
+                }
+        }
+
+        slice->cur = !slice->cur;
+        slice->generation++;
+
+        for (bits = slice->live; bits; bits &= bits - 1) {
+                k = __builtin_ctzll(bits);
+                if (seen_before(slice, k)) {
+                        done |= 1ULL << k;
+                }
+        }
+        slice->live &= ~done;
+
+        return done;
+}
+
+/**
+ * copies one board of the slice out into a grid
+ * @param *slice the slice
+ * @param board which board
+ * @param *grid a grid the size of the boards, filled with 1's and 0's
+ */
+void slice_board(struct slice_t *slice, int board, struct grid_t *grid)
+{
+        int i;
+        int j;
+        const uint64_t *row;
+
+        for (i = 0; i < slice->rows; i++) {
+                row = slice->cell[slice->cur] + (size_t)(i + 1) * slice->stride + 1;
+
+                for (j = 0; j < slice->cols; j++) {
+                        grid->cell[i][j] = row[j] >> board & 1;
+                }
+        }
+}
@@ -0,0 +1,57 @@
+#include <stdint.h>
+#include "life.h"
+
+/**
+ * @file slice.h
+ * @breif headers for stepping 64 small boards at once, one in every bit of a word, in slice.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef SLICE_H_
+#define SLICE_H_
+
+/* boards in a slice, one for every bit of a word */
+#define SLICE_BOARDS 64
+/* entries in the table of past hashes each board keeps, a power of 2. A board is only caught
+ * repeating while its last repeat is still in the table, so periods up to about this long are found */
+#define SLICE_HISTORY 1024
+
+/* one past generation of one board, generation is 1 past the real one so 0 is an empty slot */
+struct slice_entry_t {
+        uint64_t hash;
+        unsigned long long generation;
+};
+
+/* 64 boards of rows by cols cells on the same edge. Word j of row i holds cell i, j of every board,
+ * board k in bit k, with a ghost border one word wide all the way around the same as a grid_t. live
+ * has a bit set for every board that has not settled yet, only those have their hash and population
+ * kept up to date, and once one repeats settled and period say how */
+struct slice_t {
+        int rows;
+        int cols;
+        int stride; /* words from one row to the next, ghost words included */
+        int edge; /* hedge or torus */
+        uint64_t *cell[2]; /* cell[cur] + (i + 1) * stride + j + 1 is cell i, j */
+        int cur;
+        unsigned long long generation;
+        uint64_t live;
+        uint64_t hash[SLICE_BOARDS];
+        long long population[SLICE_BOARDS];
+        long long settled[SLICE_BOARDS]; /* the generation each board first was what it repeats, -1 until it does */
+        long long period[SLICE_BOARDS];
+        struct slice_entry_t *history; /* SLICE_HISTORY entries for each board */
+};
+
+struct slice_t *init_slice(int rows, int cols, int edge);
+
+void free_slice(struct slice_t *slice);
+
+void slice_soups(struct slice_t *slice, uint64_t seed, unsigned long long first, int count, int size, double density);
+
+uint64_t slice_step(struct slice_t *slice);
+
+void slice_board(struct slice_t *slice, int board, struct grid_t *grid);
+
+#endif
@@ -0,0 +1,282 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "life.h"
+#include "pool.h"
+#include "slice.h"
+#include "census.h"
+
+/**
+ * @file soup.c
+ * @breif runs many random soups on small boards and writes how each one ended up
+ * @details The soups are put down SLICE_BOARDS at a time in a slice, so one pass of the full adders steps a cell of every soup in the slice. Each thread steps its own slices, the soups are handed out a slice at a time in rounds of a few slices for every thread, and each round is written in order when it is done, so the output only depends on the seed and never on the threads. A soup is stepped until it repeats or the run is out of generations. One line is written for every soup with its number, its population, the generation it settled at and the period it settled into, -1 and 0 if it never did, and a census of the objects it ended up as. A soup that settles is taken out and counted as soon as it does, not after the last one in its slice, so every census is of the generation it settled at.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#define SOUP_LINE 1024 /* room for the census of one soup */
+#define SOUP_TASKS 4 /* slices handed out to every thread in a round */
+
+/* what one soup ended up as */
+struct soup_result_t {
+        long long population;
+        long long settled;
+        long long period;
+        char census[SOUP_LINE];
+};
+
+/* the run, shared by every thread */
+struct soup_t {
+        int rows;
+        int cols;
+        int edge;
+        int size;
+        double density;
+        uint64_t seed;
+        unsigned long long generations; /* the most each soup is stepped */
+        unsigned long long first; /* the number of the first soup of the round */
+        unsigned long long soups; /* how many soups there are in all */
+        struct slice_t **slice; /* one for every thread */
+        struct grid_t **grid;
+        struct soup_result_t *result; /* one for every soup of the round */
+        int failed;
+};
+
+/**
+ * seconds on the monotonic clock
+ * @return the time
+ */
+static double now(void)
+{
+        struct timespec time;
+
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * takes the census of the boards of a slice and keeps what they ended up as
+ * @param *soup the run
+ * @param *slice the slice
+ * @param *grid a grid the size of the boards to copy them out into
+ * @param boards a bit set for every board to keep
+ * @param *result the results of the boards of the slice, board k in result[k]
+ */
+static void keep_boards(struct soup_t *soup, struct slice_t *slice, struct grid_t *grid, uint64_t boards, struct soup_result_t *result)
+{
+        int k;
+
+        for (; boards; boards &= boards - 1) {
+                k = __builtin_ctzll(boards);
+                slice_board(slice, k, grid);
+                result[k].population = slice->population[k];
+                result[k].settled = slice->settled[k];
+                result[k].period = slice->period[k];
+                if (census_board(grid, soup->edge, result[k].period, result[k].census, SOUP_LINE) == -1) {
+                        soup->failed = 1;
+                }
+        }
+}
+
+/**
+ * runs one slice of soups, a task for pool_run
+ * @param *arg the run
+ * @param task which slice of the round
+ * @param id the thread, it picks the slice and grid to use
+ */
+static void run_slice(void *arg, int task, int id)
+{
+        struct soup_t *soup = arg;
+        struct slice_t *slice = soup->slice[id];
+        struct grid_t *grid = soup->grid[id];
+        unsigned long long first = soup->first + (unsigned long long)task * SLICE_BOARDS;
+        struct soup_result_t *result = soup->result + (size_t)task * SLICE_BOARDS;
+        int count;
+
+        if (first >= soup->soups) {
+                return;
+        }
+        count = (soup->soups - first < SLICE_BOARDS) ? soup->soups - first : SLICE_BOARDS;
+
+        slice_soups(slice, soup->seed, first, count, soup->size, soup->density);
+
+        /* a soup that settled at the start, like an empty one, is already out of live */
+        keep_boards(soup, slice, grid, ((count >= SLICE_BOARDS) ? ~0ULL : (1ULL << count) - 1) & ~slice->live, result);
+
+        while (slice->live && slice->generation < soup->generations) {
+                keep_boards(soup, slice, grid, slice_step(slice), result);
+        }
+
+        keep_boards(soup, slice, grid, slice->live, result);
+}
+
+int main(int argc, char *argv[])
+{
+        int c;
+        int i;
+        int threads = sysconf(_SC_NPROCESSORS_ONLN);
+        int tasks;
+        unsigned long long n;
+        unsigned long long done;
+        double start;
+        double seconds;
+        char *outpath = NULL;
+        struct rule_t rule;
+        struct pool_t *pool;
+        FILE *out = stdout;
+        struct soup_t soup = { 64, 64, EDGE_TORUS, 16, 0.5, 1, 4000, 0, 1000, NULL, NULL, NULL, 0 };
+
+        /*procsses all of the arguments */
+        while ((c = getopt(argc, argv, ":N:s:R:C:e:d:n:j:S:O:u:H")) != -1) {
+                        switch (c) {
+                        case 'N':
+                                soup.soups = strtoull(optarg, NULL, 10);
+                                break;
+                        case 's':
+                                soup.size = atoi(optarg);
+                                break;
+                        case 'R':
+                                soup.rows = atoi(optarg);
+                                break;
+                        case 'C':
+                                soup.cols = atoi(optarg);
+                                break;
+                        case 'e':
+                                if (strncmp("hedge", optarg, strlen(optarg)) == 0) {
+                                        soup.edge = EDGE_HEDGE;
+                                } else if (strncmp("torus", optarg, strlen(optarg)) == 0) {
+                                        soup.edge = EDGE_TORUS;
+                                } else {
+                                        fprintf(stderr, "%s: argument to option '-e' must be hedge or torus\n", argv[0]);
+                                        exit(1);
+                                }
+                                break;
+                        case 'd':
+                                soup.density = atof(optarg);
+                                break;
+                        case 'n':
+                                soup.generations = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'j':
+                                threads = atoi(optarg);
+                                break;
+                        case 'S':
+                                soup.seed = strtoull(optarg, NULL, 10);
+                                break;
+                        case 'O':
+                                outpath = optarg;
+                                break;
+                        case 'u':
+                                if (parse_rule(optarg, &rule) == -1 || !rule_is_bits(&rule)) {
+                                        fprintf(stderr, "%s: argument to option '-u' is not a two state rule on the 8 neighbors\n", argv[0]);
+                                        exit(1);
+                                }
+                                set_rule(&rule);
+                                break;
+                        case 'H':
+                                printf("Usage: \n./life_soup -N soups -s size -R rows -C cols -e edge -d density -n generations");
+                                printf(" -j threads -S seed -O output -u rule -H help\n");
+                                printf("N: soups to run, 1000 by default\n");
+                                printf("s: rows and cols of the square each soup fills in the middle of its board, 16 by default\n");
+                                printf("R: rows of every board, 64 by default\n");
+                                printf("C: cols of every board, 64 by default\n");
+                                printf("e: edge of every board, hedge or torus, torus by default\n");
+                                printf("d: chance each cell of a soup is alive, 0.5 by default\n");
+                                printf("n: most generations to step a soup that has not settled, 4000 by default\n");
+                                printf("j: threads, the number of cores by default\n");
+                                printf("S: seed, soup n of a seed is always the same soup, 1 by default\n");
+                                printf("O: file to write a line for each soup to instead of stdout\n");
+                                printf("u: rule to step with, in any notation -u takes in life_batch, two states and 8 neighbors only\n");
+                                printf("H: help menu display\n");
+                                exit(1);
+                                break;
+                        case ':':
+                                fprintf(stderr, "%s: option '-%c' requires an argument\n", argv[0], optopt);
+                                exit(1); /*error processing */
+                        case '?':
+                        default:
+                                printf("Illegal option %c - ignored\n", optopt);
+                                break;
+                        }
+        }
+
+        if (soup.rows < 3 || soup.cols < 3 || soup.size < 1 || soup.size > soup.rows || soup.size > soup.cols) {
+                fprintf(stderr, "%s: the boards must be at least 3 by 3 and the soups no bigger than the boards\n", argv[0]);
+                exit(1);
+        }
+
+        if (threads < 1) {
+                threads = 1;
+        }
+
+        if (outpath) {
+                errno = 0;
+                out = fopen(outpath, "w");
+
+                if (!out) {
+                        fprintf(stderr, "%s: argument to option '-O' failed: %s\n", argv[0], strerror(errno));
+                        exit(1);
+                }
+        }
+
+        init_census();
+
+        tasks = threads * SOUP_TASKS;
+        pool = init_pool(threads);
+        soup.slice = calloc(threads, sizeof(struct slice_t *));
+        soup.grid = calloc(threads, sizeof(struct grid_t *));
+        soup.result = malloc(sizeof(struct soup_result_t) * tasks * SLICE_BOARDS);
+
+        if (!pool || !soup.slice || !soup.grid || !soup.result) {
+                printf("Malloc failed exiting\n");
+                exit(1);
+        }
+
+        for (i = 0; i < threads; i++) {
+                soup.slice[i] = init_slice(soup.rows, soup.cols, soup.edge);
+                soup.grid[i] = init_grid(soup.rows, soup.cols);
+
+                if (!soup.slice[i] || !soup.grid[i]) {
+                        printf("Malloc failed exiting\n");
+                        exit(1);
+                }
+        }
+
+        start = now();
+
+        for (soup.first = 0; soup.first < soup.soups; soup.first += done) {
+                pool_run(pool, tasks, run_slice, &soup);
+
+                if (soup.failed) {
+                        printf("Malloc failed exiting\n");
+                        exit(1);
+                }
+
+                done = (soup.soups - soup.first < (unsigned long long)tasks * SLICE_BOARDS) ? soup.soups - soup.first : (unsigned long long)tasks * SLICE_BOARDS;
+                for (n = 0; n < done; n++) {
+                        fprintf(out, "soup %llu population %lld settled %lld period %lld census %s\n", soup.first + n,
+                                        soup.result[n].population, soup.result[n].settled, soup.result[n].period, soup.result[n].census);
+                }
+        }
+
+        seconds = now() - start;
+        fprintf(stderr, "%llu soups in %.3f seconds, %.1f soups a second, %.1f a second for each of %d threads\n", soup.soups,
+                        seconds, soup.soups / seconds, soup.soups / seconds / threads, threads);
+
+        if (out != stdout) {
+                fclose(out);
+        }
+
+        for (i = 0; i < threads; i++) {
+                free_slice(soup.slice[i]);
+                free_grid(soup.grid[i]);
+        }
+        free(soup.slice);
+        free(soup.grid);
+        free(soup.result);
+        free_pool(pool);
+
+        return 0;
+}
@@ -0,0 +1,618 @@
+#include "sparse.h"
+#include "packed.h"
+#include "load.h"
+
+/**
+ * @file sparse.c
+ * @breif The infinite plane, a board with no edge that only stores the parts of it that are alive
+ * @details The plane is cut into chunks of 64 by 64 cells that are kept in a hash map keyed on the chunk coordinates, every chunk that is not in the map is all dead. Before a generation every chunk with an alive cell on its border makes sure the chunks it touches exist, since only those can have cells born in them. Each chunk is then stepped a row at a time with the same full adders the packed engine uses, taking the cells just past its border from the chunks around it. Chunks that are left empty go back on the free list. Memory and time both follow the part of the plane that is alive, however far it spreads.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* where parse_file_sparse is putting the cells of a pattern */
+struct sparse_place_t {
+        struct sparse_t *sparse;
+        int x;
+        int y;
+};
+
+/* the cells of a plane while it is being moved */
+struct sparse_moved_t {
+        long long *cells; /* row and col of every cell one after another */
+        size_t count;
+        size_t capacity;
+};
+
+/**
+ * gets the chunk a cell coordinate falls in, rounding down for negative coordinates
+ * @param coord the row or col of the cell
+ * @return the row or col of the chunk
+ */
+static long long chunk_of(long long coord)
+{
+        return (coord < 0) ? -((-coord - 1) / CHUNK_SIZE) - 1 : coord / CHUNK_SIZE;
+}
+
+/**
+ * hashes a chunk coordinate into a bucket
+ * @param *sparse the plane
+ * @param row the row of the chunk
+ * @param col the col of the chunk
+ * @return the bucket
+ */
+static size_t bucket_of(struct sparse_t *sparse, long long row, long long col)
+{
+        uint64_t h = (uint64_t)row * 0x9e3779b97f4a7c15ULL ^ (uint64_t)col * 0xc2b2ae3d27d4eb4fULL;
+
+        return (size_t)(h ^ (h >> 31)) & (sparse->buckets - 1);
+}
+
+/**
+ * finds a chunk in the hash map
+ * @param *sparse the plane
+ * @param row the row of the chunk
+ * @param col the col of the chunk
+ * @return the chunk, or NULL if it is all dead
+ */
+static struct chunk_t *find_chunk(struct sparse_t *sparse, long long row, long long col)
+{
+        struct chunk_t *chunk;
+
+        for (chunk = sparse->table[bucket_of(sparse, row, col)]; chunk; chunk = chunk->next) {
+                if (chunk->row == row && chunk->col == col) {
+                        return chunk;
+                }
+        }
+
+        return NULL;
+}
+
+/**
+ * doubles the buckets of the hash map once there are more chunks than buckets
+ * @param *sparse the plane
+ */
+static void grow_table(struct sparse_t *sparse)
+{
+        size_t i;
+        struct chunk_t *chunk;
+        struct chunk_t **table = calloc(sparse->buckets * 2, sizeof(struct chunk_t *));
+
+        if (!table) {
+                return; /* longer chains are slower but still correct */
+        }
+
+        free(sparse->table);
+        sparse->table = table;
+        sparse->buckets *= 2;
+
+        for (i = 0; i < sparse->count; i++) {
+                chunk = sparse->list[i];
+                chunk->next = table[bucket_of(sparse, chunk->row, chunk->col)];
+                table[bucket_of(sparse, chunk->row, chunk->col)] = chunk;
+        }
+}
+
+/**
+ * finds a chunk in the hash map, taking a new dead one from the pool if it is not there
+ * @param *sparse the plane
+ * @param row the row of the chunk
+ * @param col the col of the chunk
+ * @return the chunk, exits if memory runs out
+ */
+static struct chunk_t *get_chunk(struct sparse_t *sparse, long long row, long long col)
+{
+        int i;
+        size_t bucket;
+        struct chunk_t *chunk = find_chunk(sparse, row, col);
+        struct chunk_t **list;
+        struct chunk_block_t *block;
+
+        if (chunk) {
+                return chunk;
+        }
+
+        if (!sparse->free_list) {
+                block = malloc(sizeof(struct chunk_block_t));
+
+                if (!block) {
+                        printf("Malloc failed, out of memory for the plane\n");
+                        exit(1);
+                }
+
+                block->next = sparse->blocks;
+                sparse->blocks = block;
+
+                for (i = CHUNK_BLOCK - 1; i >= 0; i--) {
+                        block->chunks[i].next = sparse->free_list;
+                        sparse->free_list = &block->chunks[i];
+                }
+        }
+
+        if (sparse->count == sparse->capacity) {
+                list = realloc(sparse->list, sizeof(struct chunk_t *) * sparse->capacity * 2);
+
+                if (!list) {
+                        printf("Malloc failed, out of memory for the plane\n");
+                        exit(1);
+                }
+                sparse->list = list;
+                sparse->capacity *= 2;
+        }
+
+        chunk = sparse->free_list;
+        sparse->free_list = chunk->next;
+        chunk->row = row;
+        chunk->col = col;
+        memset(chunk->cells, 0, sizeof(chunk->cells));
+
+        bucket = bucket_of(sparse, row, col);
+        chunk->next = sparse->table[bucket];
+        sparse->table[bucket] = chunk;
+        sparse->list[sparse->count++] = chunk;
+
+        if (sparse->count > sparse->buckets) {
+                grow_table(sparse);
+        }
+
+        return chunk;
+}
+
+/**
+ * takes the chunk at index out of the hash map and the list and puts it back in the pool
+ * @param *sparse the plane
+ * @param index where the chunk is in the list, the last chunk is moved into its place
+ */
+static void remove_chunk(struct sparse_t *sparse, size_t index)
+{
+        struct chunk_t *chunk = sparse->list[index];
+        struct chunk_t **link = &sparse->table[bucket_of(sparse, chunk->row, chunk->col)];
+
+        while (*link != chunk) {
+                link = &(*link)->next;
+        }
+        *link = chunk->next;
+
+        sparse->list[index] = sparse->list[--sparse->count];
+        chunk->next = sparse->free_list;
+        sparse->free_list = chunk;
+}
+
+/**
+ * Intilizes an empty plane
+ * @return the plane, or NULL if an allocation failed
+ */
+struct sparse_t *init_sparse(void)
+{
+        struct sparse_t *sparse = calloc(1, sizeof(struct sparse_t));
+
+        if (!sparse) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        sparse->buckets = 1024;
+        sparse->capacity = 1024;
+        sparse->table = calloc(sparse->buckets, sizeof(struct chunk_t *));
+        sparse->list = malloc(sizeof(struct chunk_t *) * sparse->capacity);
+
+        if (!sparse->table || !sparse->list) {
+                printf("Malloc failed\n");
+                free_sparse(sparse);
+                return NULL;
+        }
+
+        return sparse;
+}
+
+/**
+ * frees a plane made by init_sparse
+ * @param *sparse the plane to free, may be NULL
+ */
+void free_sparse(struct sparse_t *sparse)
+{
+        struct chunk_block_t *block;
+        struct chunk_block_t *next;
+
+        if (!sparse) {
+                return;
+        }
+
+        for (block = sparse->blocks; block; block = next) {
+                next = block->next;
+                free(block);
+        }
+
+        free(sparse->table);
+        free(sparse->list);
+        free(sparse);
+}
+
+/**
+ * gets the key a row of a chunk is hashed with
+ * @param *chunk the chunk
+ * @param i the row inside the chunk
+ * @return the key for hash_word
+ */
+static inline uint64_t chunk_key(struct chunk_t *chunk, int i)
+{
+        return hash_key(hash_mix((uint64_t) chunk->row) + (uint64_t) chunk->col * CHUNK_SIZE + i);
+}
+
+/**
+ * makes one cell of the plane alive
+ * @param *sparse the plane
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+void sparse_set(struct sparse_t *sparse, long long row, long long col)
+{
+        long long chunk_row = chunk_of(row);
+        long long chunk_col = chunk_of(col);
+        struct chunk_t *chunk = get_chunk(sparse, chunk_row, chunk_col);
+        int i = row - chunk_row * CHUNK_SIZE;
+        uint64_t key;
+        uint64_t cells = chunk->cells[i] | 1ULL << (col - chunk_col * CHUNK_SIZE);
+
+        key = chunk_key(chunk, i);
+        sparse->hash ^= hash_word(chunk->cells[i], key) ^ hash_word(cells, key);
+        chunk->cells[i] = cells;
+}
+
+/**
+ * makes the alive cells of a whole chunk alive on the plane, for putting back a saved plane
+ * @param *sparse the plane
+ * @param row the row of the chunk, in chunks
+ * @param col the col of the chunk, in chunks
+ * @param *cells the CHUNK_SIZE rows of the chunk, bit j of cells[i] is col j of row i
+ */
+void sparse_set_chunk(struct sparse_t *sparse, long long row, long long col, const uint64_t *cells)
+{
+        int i;
+        uint64_t key;
+        struct chunk_t *chunk = get_chunk(sparse, row, col);
+
+        for (i = 0; i < CHUNK_SIZE; i++) {
+                key = chunk_key(chunk, i);
+                sparse->hash ^= hash_word(chunk->cells[i], key) ^ hash_word(chunk->cells[i] | cells[i], key);
+                chunk->cells[i] |= cells[i];
+        }
+}
+
+/**
+ * kills every cell on the plane, the chunks go back in the pool
+ * @param *sparse the plane
+ */
+void sparse_clear(struct sparse_t *sparse)
+{
+        while (sparse->count > 0) {
+                remove_chunk(sparse, sparse->count - 1);
+        }
+        sparse->hash = 0;
+}
+
+/**
+ * keeps one cell of a plane being moved
+ * @param *target the sparse_moved_t
+ * @param row the row of the cell
+ * @param col the col of the cell
+ */
+static void moved_cell(void *target, long long row, long long col)
+{
+        struct sparse_moved_t *moved = target;
+        long long *cells;
+
+        if (moved->count == moved->capacity) {
+                moved->capacity = (moved->capacity) ? moved->capacity * 2 : 1024;
+                cells = realloc(moved->cells, sizeof(long long) * 2 * moved->capacity);
+
+                if (!cells) {
+                        printf("Malloc failed, out of memory for the plane\n");
+                        exit(1);
+                }
+                moved->cells = cells;
+        }
+
+        moved->cells[2 * moved->count] = row;
+        moved->cells[2 * moved->count + 1] = col;
+        moved->count++;
+}
+
+/**
+ * moves every alive cell on the plane, for skipping a spaceship ahead a number of periods
+ * @param *sparse the plane
+ * @param rows how far to move the cells down, up if negative
+ * @param cols how far to move the cells right, left if negative
+ */
+void sparse_shift(struct sparse_t *sparse, long long rows, long long cols)
+{
+        size_t n;
+        struct sparse_moved_t moved = { NULL, 0, 0 };
+
+        if (rows == 0 && cols == 0) {
+                return;
+        }
+
+        sparse_cells(sparse, moved_cell, &moved);
+        sparse_clear(sparse);
+
+        for (n = 0; n < moved.count; n++) {
+                sparse_set(sparse, moved.cells[2 * n] + rows, moved.cells[2 * n + 1] + cols);
+        }
+        free(moved.cells);
+}
+
+/**
+ * gets the cells of one row of a chunk, any row of a missing chunk is dead
+ * @param *chunk the chunk, may be NULL
+ * @param i the row inside the chunk
+ * @return the 64 cells of the row
+ */
+static inline uint64_t chunk_row(struct chunk_t *chunk, int i)
+{
+        return (chunk) ? chunk->cells[i] : 0;
+}
+
+/**
+ * works out the next generation of one chunk into next_cells
+ * @param *sparse the plane
+ * @param *chunk the chunk to step
+ */
+static void step_chunk(struct sparse_t *sparse, struct chunk_t *chunk)
+{
+        int i;
+        int k;
+        uint64_t rows[CHUNK_SIZE + 2];
+        uint64_t west[CHUNK_SIZE + 2];
+        uint64_t east[CHUNK_SIZE + 2];
+        struct chunk_t *n = find_chunk(sparse, chunk->row - 1, chunk->col);
+        struct chunk_t *s = find_chunk(sparse, chunk->row + 1, chunk->col);
+        struct chunk_t *w = find_chunk(sparse, chunk->row, chunk->col - 1);
+        struct chunk_t *e = find_chunk(sparse, chunk->row, chunk->col + 1);
+        struct chunk_t *nw = find_chunk(sparse, chunk->row - 1, chunk->col - 1);
+        struct chunk_t *ne = find_chunk(sparse, chunk->row - 1, chunk->col + 1);
+        struct chunk_t *sw = find_chunk(sparse, chunk->row + 1, chunk->col - 1);
+        struct chunk_t *se = find_chunk(sparse, chunk->row + 1, chunk->col + 1);
+        const struct rule_t *rule = get_rule();
+
+        /* rows -1 to 64 of the chunk with the one bit just past each side of them */
+        rows[0] = chunk_row(n, CHUNK_SIZE - 1);
+        west[0] = chunk_row(nw, CHUNK_SIZE - 1) >> 63;
+        east[0] = chunk_row(ne, CHUNK_SIZE - 1) & 1;
+
+        for (i = 0; i < CHUNK_SIZE; i++) {
+                rows[i + 1] = chunk->cells[i];
+                west[i + 1] = chunk_row(w, i) >> 63;
+                east[i + 1] = chunk_row(e, i) & 1;
+        }
+
+        rows[CHUNK_SIZE + 1] = chunk_row(s, 0);
+        west[CHUNK_SIZE + 1] = chunk_row(sw, 0) >> 63;
+        east[CHUNK_SIZE + 1] = chunk_row(se, 0) & 1;
+
+        for (i = 0; i < CHUNK_SIZE; i++) {
+                k = i + 1;
+                chunk->next_cells[i] = life_word((rows[k - 1] << 1) | west[k - 1], rows[k - 1], (rows[k - 1] >> 1) | (east[k - 1] << 63),
+                                (rows[k] << 1) | west[k], rows[k], (rows[k] >> 1) | (east[k] << 63),
+                                (rows[k + 1] << 1) | west[k + 1], rows[k + 1], (rows[k + 1] >> 1) | (east[k + 1] << 63), rule);
+        }
+}
+
+/**
+ * Steps the plane one generation, growing it where cells reach the border of a chunk and dropping chunks that die out
+ * @param *sparse the plane
+ */
+void sparse_step(struct sparse_t *sparse)
+{
+        size_t i;
+        size_t count = sparse->count;
+        int j;
+        uint64_t left;
+        uint64_t right;
+        uint64_t any;
+        uint64_t key;
+        long long births = 0;
+        long long deaths = 0;
+        struct chunk_t *chunk;
+
+        for (i = 0; i < count; i++) { /* only the chunks that were there before, new ones are all dead */
+                chunk = sparse->list[i];
+                left = 0;
+                right = 0;
+                any = 0;
+
+                for (j = 0; j < CHUNK_SIZE; j++) {
+                        left |= chunk->cells[j] & 1;
+                        right |= chunk->cells[j] >> 63;
+                        any |= chunk->cells[j];
+                }
+
+                if (!any) {
+                        continue;
+                }
+
+                if (chunk->cells[0]) {
+                        get_chunk(sparse, chunk->row - 1, chunk->col);
+                }
+                if (chunk->cells[CHUNK_SIZE - 1]) {
+                        get_chunk(sparse, chunk->row + 1, chunk->col);
+                }
+                if (left) {
+                        get_chunk(sparse, chunk->row, chunk->col - 1);
+                }
+                if (right) {
+                        get_chunk(sparse, chunk->row, chunk->col + 1);
+                }
+                if (chunk->cells[0] & 1) {
+                        get_chunk(sparse, chunk->row - 1, chunk->col - 1);
+                }
+                if (chunk->cells[0] >> 63) {
+                        get_chunk(sparse, chunk->row - 1, chunk->col + 1);
+                }
+                if (chunk->cells[CHUNK_SIZE - 1] & 1) {
+                        get_chunk(sparse, chunk->row + 1, chunk->col - 1);
+                }
+                if (chunk->cells[CHUNK_SIZE - 1] >> 63) {
+                        get_chunk(sparse, chunk->row + 1, chunk->col + 1);
+                }
+        }
+
+        for (i = 0; i < sparse->count; i++) {
+                step_chunk(sparse, sparse->list[i]);
+        }
+
+        for (i = sparse->count; i > 0; i--) { /* backwards since removing moves the last chunk into the gap */
+                chunk = sparse->list[i - 1];
+                any = 0;
+
+                for (j = 0; j < CHUNK_SIZE; j++) {
+                        births += __builtin_popcountll(chunk->next_cells[j] & ~chunk->cells[j]);
+                        deaths += __builtin_popcountll(chunk->cells[j] & ~chunk->next_cells[j]);
+                        any |= chunk->next_cells[j];
+
+                        if (chunk->next_cells[j] != chunk->cells[j]) {
+                                key = chunk_key(chunk, j);
+                                sparse->hash ^= hash_word(chunk->cells[j], key) ^ hash_word(chunk->next_cells[j], key);
+                        }
+                }
+                memcpy(chunk->cells, chunk->next_cells, sizeof(chunk->cells));
+
+                if (!any) {
+                        remove_chunk(sparse, i - 1);
+                }
+        }
+
+        sparse->births = births;
+        sparse->deaths = deaths;
+        sparse->generation++;
+}
+
+/**
+ * copies the part of the plane starting at row, col into a grid so it can be rendered
+ * @param *sparse the plane
+ * @param *grid the grid to fill, cleared first
+ * @param row the row of the plane that goes in row 0 of the grid
+ * @param col the col of the plane that goes in col 0 of the grid
+ */
+void sparse_view(struct sparse_t *sparse, struct grid_t *grid, long long row, long long col)
+{
+        size_t n;
+        int i;
+        int j;
+        long long grid_row;
+        long long grid_col;
+        uint64_t bits;
+        struct chunk_t *chunk;
+
+        set_zero(grid);
+
+        for (n = 0; n < sparse->count; n++) {
+                chunk = sparse->list[n];
+                grid_row = chunk->row * CHUNK_SIZE - row;
+                grid_col = chunk->col * CHUNK_SIZE - col;
+
+                if (grid_row >= grid->rows || grid_col >= grid->cols || grid_row + CHUNK_SIZE <= 0 || grid_col + CHUNK_SIZE <= 0) {
+                        continue;
+                }
+
+                for (i = 0; i < CHUNK_SIZE; i++) {
+                        if (grid_row + i < 0 || grid_row + i >= grid->rows) {
+                                continue;
+                        }
+
+                        for (bits = chunk->cells[i]; bits; bits &= bits - 1) {
+                                j = __builtin_ctzll(bits);
+
+                                if (grid_col + j >= 0 && grid_col + j < grid->cols) {
+                                        grid->cell[grid_row + i][grid_col + j] = 1;
+                                }
+                        }
+                }
+        }
+}
+
+/**
+ * counts the alive cells on the plane
+ * @param *sparse the plane
+ * @return the number of alive cells
+ */
+long long sparse_population(struct sparse_t *sparse)
+{
+        size_t n;
+        int i;
+        long long count = 0;
+
+        for (n = 0; n < sparse->count; n++) {
+                for (i = 0; i < CHUNK_SIZE; i++) {
+                        count += __builtin_popcountll(sparse->list[n]->cells[i]);
+                }
+        }
+
+        return count;
+}
+
+/**
+ * hands the row and col of every alive cell on the plane to fn
+ * @param *sparse the plane
+ * @param fn called with target and the row and col of every alive cell
+ * @param *target passed to fn
+ */
+void sparse_cells(struct sparse_t *sparse, cell_fn fn, void *target)
+{
+        size_t n;
+        int i;
+        uint64_t bits;
+        struct chunk_t *chunk;
+
+        for (n = 0; n < sparse->count; n++) {
+                chunk = sparse->list[n];
+
+                for (i = 0; i < CHUNK_SIZE; i++) {
+                        for (bits = chunk->cells[i]; bits; bits &= bits - 1) {
+                                fn(target, chunk->row * CHUNK_SIZE + i, chunk->col * CHUNK_SIZE + __builtin_ctzll(bits));
+                        }
+                }
+        }
+}
+
+/**
+ * puts one cell from a file on the plane
+ * @param *target the sparse_place_t
+ * @param row the row from the file
+ * @param col the col from the file
+ */
+static void place_sparse(void *target, long long row, long long col)
+{
+        struct sparse_place_t *place = target;
+
+        sparse_set(place->sparse, row + place->x, col + place->y);
+}
+
+/**
+ * reads a pattern file of any format load_pattern knows and puts its cells on the plane, nothing is ever off the board
+ * @param *sparse the plane to fill
+ * @param *filepath the file to read
+ * @param x the offset for the x value that the user entered
+ * @param y the offset for the y value that the user entered
+ * @param *rule where the rule named in the file is copied, RULE_SIZE chars and left empty if there is none, may be NULL
+ * @return 0 on success, -1 if the file could not be read
+ */
+int parse_file_sparse(struct sparse_t *sparse, char *filepath, int x, int y, char *rule)
+{
+        struct sparse_place_t place = { sparse, x, y };
+        struct pattern_t pattern;
+
+        if (load_pattern(filepath, &pattern) == -1) {
+                return -1;
+        }
+
+        if (rule) {
+                strcpy(rule, pattern.rule);
+        }
+
+        pattern_cells(&pattern, place_sparse, &place);
+        free_pattern(&pattern);
+
+        return 0;
+}
@@ -0,0 +1,70 @@
+#include <stdint.h>
+#include "life.h"
+
+/**
+ * @file sparse.h
+ * @breif headers for the infinite plane in sparse.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef SPARSE_H_
+#define SPARSE_H_
+
+/* chunks are CHUNK_SIZE by CHUNK_SIZE cells, one 64 bit word per row */
+#define CHUNK_SIZE 64
+/* chunks are handed out of blocks this many at a time */
+#define CHUNK_BLOCK 256
+
+/* the cells from row * CHUNK_SIZE and col * CHUNK_SIZE on, bit j of cells[i] is col j of row i */
+struct chunk_t {
+        long long row;
+        long long col;
+        uint64_t cells[CHUNK_SIZE];
+        uint64_t next_cells[CHUNK_SIZE];
+        struct chunk_t *next; /* next chunk in the same hash bucket, or on the free list */
+};
+
+struct chunk_block_t {
+        struct chunk_block_t *next;
+        struct chunk_t chunks[CHUNK_BLOCK];
+};
+
+struct sparse_t {
+        struct chunk_t **table;
+        size_t buckets;
+        struct chunk_t **list; /* every chunk in use */
+        size_t count;
+        size_t capacity;
+        struct chunk_t *free_list;
+        struct chunk_block_t *blocks;
+        unsigned long long generation;
+        long long births; /* cells born and cells that died in the last generation */
+        long long deaths;
+        uint64_t hash; /* hash_word of every row of every chunk XORed together, kept up to date as cells change */
+};
+
+struct sparse_t *init_sparse(void);
+
+void free_sparse(struct sparse_t *sparse);
+
+void sparse_set(struct sparse_t *sparse, long long row, long long col);
+
+void sparse_set_chunk(struct sparse_t *sparse, long long row, long long col, const uint64_t *cells);
+
+void sparse_clear(struct sparse_t *sparse);
+
+void sparse_shift(struct sparse_t *sparse, long long rows, long long cols);
+
+void sparse_step(struct sparse_t *sparse);
+
+void sparse_view(struct sparse_t *sparse, struct grid_t *grid, long long row, long long col);
+
+long long sparse_population(struct sparse_t *sparse);
+
+void sparse_cells(struct sparse_t *sparse, cell_fn fn, void *target);
+
+int parse_file_sparse(struct sparse_t *sparse, char *filepath, int x, int y, char *rule);
+
+#endif
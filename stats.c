@@ -0,0 +1,211 @@
+#include "stats.h"
+#include "pace.h"
+
+/**
+ * @file stats.c
+ * @breif times the phases of every generation and samples the board, for a log line and the overlay in the window
+ * @details Timing a phase is two reads of the clock and adding the difference to a total under the lock, cheap enough to leave on for every generation. The counters that cost a pass over the board, the population and the cells born and dead, are only worked out when a sample is due, every so many generations for the log line or a few times a second while the overlay is showing. A sample turns the totals into the average time of each phase since the sample before and starts them again, so the log and the overlay show how the run is doing now and not since it started.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+static const char *phase_names[STATS_PHASES] = { "step", "publish", "render", "events", "history" };
+
+/**
+ * sets up the stats with nothing timed yet
+ * @param *stats the stats
+ * @param every generations between log lines, 0 for none
+ */
+void init_stats(struct stats_t *stats, unsigned long long every)
+{
+        int p;
+
+        memset(stats, 0, sizeof(struct stats_t));
+        pthread_mutex_init(&stats->lock, NULL);
+
+        for (p = 0; p < STATS_PHASES; p++) {
+                stats->average[p] = -1;
+        }
+        stats->active_tiles = -1;
+        stats->every = every;
+        stats->sampled = pace_now();
+}
+
+/**
+ * frees what init_stats set up
+ * @param *stats the stats
+ */
+void free_stats(struct stats_t *stats)
+{
+        pthread_mutex_destroy(&stats->lock);
+}
+
+/**
+ * turns the overlay on or off, while it is on the board is sampled a few times a second
+ * @param *stats the stats
+ * @param overlay 1 to show it, 0 to hide it
+ */
+void stats_show(struct stats_t *stats, int overlay)
+{
+        pthread_mutex_lock(&stats->lock);
+        stats->overlay = overlay;
+        pthread_mutex_unlock(&stats->lock);
+}
+
+/**
+ * starts timing a phase
+ * @return the time to hand to stats_end
+ */
+double stats_begin(void)
+{
+        return pace_now();
+}
+
+/**
+ * adds the time since stats_begin to a phase
+ * @param *stats the stats, may be NULL when nothing is being timed
+ * @param phase the phase, one of the STATS_ defines
+ * @param start what stats_begin returned
+ */
+void stats_end(struct stats_t *stats, int phase, double start)
+{
+        stats_end_many(stats, phase, start, 1);
+}
+
+/**
+ * adds the time since stats_begin to a phase that did the work of several calls at once, like a
+ * pass of the byte engine stepping several generations
+ * @param *stats the stats, may be NULL when nothing is being timed
+ * @param phase the phase, one of the STATS_ defines
+ * @param start what stats_begin returned
+ * @param calls how many calls the time was for
+ */
+void stats_end_many(struct stats_t *stats, int phase, double start, unsigned long long calls)
+{
+        double seconds;
+
+        if (!stats) {
+                return;
+        }
+
+        seconds = pace_now() - start;
+        pthread_mutex_lock(&stats->lock);
+        stats->total[phase] += seconds;
+        stats->calls[phase] += calls;
+        pthread_mutex_unlock(&stats->lock);
+}
+
+/**
+ * says whether the board should be sampled after a generation
+ * @param *stats the stats, may be NULL
+ * @param generation the generation just stepped
+ * @return 1 when a log line is due, 2 when only the overlay needs a fresh sample, 0 when neither is
+ */
+int stats_due(struct stats_t *stats, unsigned long long generation)
+{
+        int due;
+
+        if (!stats) {
+                return 0;
+        }
+
+        if (stats->every > 0 && generation % stats->every == 0) {
+                return 1;
+        }
+
+        pthread_mutex_lock(&stats->lock);
+        due = stats->overlay && pace_now() - stats->sampled >= STATS_OVERLAY_SECONDS;
+        pthread_mutex_unlock(&stats->lock);
+
+        return due ? 2 : 0;
+}
+
+/**
+ * counts the board and turns the phase totals into averages, called from the thread that steps the sim
+ * @param *stats the stats
+ * @param *sim the sim, it has to have stepped at least once since it was loaded
+ */
+void stats_sample(struct stats_t *stats, struct sim_t *sim)
+{
+        int p;
+        long long births;
+        long long deaths;
+        long long population = sim_population(sim);
+        double now;
+
+        sim_changes(sim, &births, &deaths);
+
+        pthread_mutex_lock(&stats->lock);
+        now = pace_now();
+
+        for (p = 0; p < STATS_PHASES; p++) {
+                stats->average[p] = (stats->calls[p] > 0) ? stats->total[p] / stats->calls[p] : -1;
+        }
+        stats->rate = (now > stats->sampled) ? stats->calls[STATS_STEP] / (now - stats->sampled) : 0;
+        memset(stats->total, 0, sizeof(stats->total));
+        memset(stats->calls, 0, sizeof(stats->calls));
+        stats->sampled = now;
+
+        stats->generation = sim->generation;
+        stats->population = population;
+        stats->births = births;
+        stats->deaths = deaths;
+        stats->active_tiles = sim->active ? sim->active->active : -1;
+        stats->tiles = sim->active ? sim->active->tile_rows * sim->active->tile_cols : 0;
+        pthread_mutex_unlock(&stats->lock);
+}
+
+/**
+ * writes the last sample as one log line
+ * @param *stats the stats
+ * @param *line where the line goes, without a newline
+ * @param size the room in line
+ */
+void stats_line(struct stats_t *stats, char *line, size_t size)
+{
+        int p;
+        int used;
+
+        pthread_mutex_lock(&stats->lock);
+        used = snprintf(line, size, "generation %llu population %lld births %lld deaths %lld generations/s %.1f",
+                        stats->generation, stats->population, stats->births, stats->deaths, stats->rate);
+
+        if (stats->active_tiles >= 0 && used >= 0 && (size_t)used < size) {
+                used += snprintf(line + used, size - used, " tiles %d/%d", stats->active_tiles, stats->tiles);
+        }
+
+        for (p = 0; p < STATS_PHASES; p++) {
+                if (stats->average[p] >= 0 && used >= 0 && (size_t)used < size) {
+                        used += snprintf(line + used, size - used, " %s %.3f ms", phase_names[p], stats->average[p] * 1e3);
+                }
+        }
+        pthread_mutex_unlock(&stats->lock);
+}
+
+/**
+ * writes the last sample as the lines the window draws over the board, in the letters render_frame has
+ * @param *stats the stats
+ * @param *text where the lines go, one after another with a newline between them
+ * @param size the room in text
+ */
+void stats_overlay(struct stats_t *stats, char *text, size_t size)
+{
+        int p;
+        int used;
+
+        pthread_mutex_lock(&stats->lock);
+        used = snprintf(text, size, "GEN %llu\nPOP %lld +%lld -%lld\n%.1f GEN/S", stats->generation, stats->population,
+                        stats->births, stats->deaths, stats->rate);
+
+        if (stats->active_tiles >= 0 && used >= 0 && (size_t)used < size) {
+                used += snprintf(text + used, size - used, "\nTILES %d/%d", stats->active_tiles, stats->tiles);
+        }
+
+        for (p = 0; p < STATS_PHASES; p++) {
+                if (stats->average[p] >= 0 && used >= 0 && (size_t)used < size) {
+                        used += snprintf(text + used, size - used, "\n%s %.3f MS", phase_names[p], stats->average[p] * 1e3);
+                }
+        }
+        pthread_mutex_unlock(&stats->lock);
+}
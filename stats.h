@@ -0,0 +1,68 @@
+#include <pthread.h>
+#include "sim.h"
+
+/**
+ * @file stats.h
+ * @breif headers for timing the phases of a generation and sampling the board, in stats.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+/* the phases that get timed */
+#define STATS_STEP 0 /* sim_step */
+#define STATS_PUBLISH 1 /* handing a generation to the window through the triple buffer */
+#define STATS_RENDER 2 /* render_frame */
+#define STATS_EVENTS 3 /* polling and handling SDL events */
+#define STATS_HISTORY 4 /* recording a generation in the history and seeking through it */
+#define STATS_PHASES 5
+
+/* seconds between samples when only the overlay wants them */
+#define STATS_OVERLAY_SECONDS 0.25
+
+/* the timings of every phase and a sample of the board. total and calls add up until the next
+ * sample, which turns them into average and leaves the board counters next to them. every is the
+ * generations between log lines and overlay is set while the window shows the numbers, the stats
+ * are only sampled when one of them wants them. lock guards all of it, the stepping thread and the
+ * window both write to it */
+struct stats_t {
+        pthread_mutex_t lock;
+        double total[STATS_PHASES];
+        unsigned long long calls[STATS_PHASES];
+        double average[STATS_PHASES]; /* seconds each call took between the last two samples */
+        double rate; /* calls a second between the last two samples */
+        double sampled; /* when the last sample was taken */
+        unsigned long long generation;
+        long long population;
+        long long births;
+        long long deaths;
+        int active_tiles; /* tiles the active engine stepped, -1 for the other engines */
+        int tiles;
+        unsigned long long every;
+        int overlay;
+};
+
+void init_stats(struct stats_t *stats, unsigned long long every);
+
+void free_stats(struct stats_t *stats);
+
+void stats_show(struct stats_t *stats, int overlay);
+
+double stats_begin(void);
+
+void stats_end(struct stats_t *stats, int phase, double start);
+
+void stats_end_many(struct stats_t *stats, int phase, double start, unsigned long long calls);
+
+int stats_due(struct stats_t *stats, unsigned long long generation);
+
+void stats_sample(struct stats_t *stats, struct sim_t *sim);
+
+void stats_line(struct stats_t *stats, char *line, size_t size);
+
+void stats_overlay(struct stats_t *stats, char *text, size_t size);
+
+#endif
@@ -0,0 +1,271 @@
+#include "temporal.h"
+
+/**
+ * @file temporal.c
+ * @breif steps the byte engine several generations for every pass over the board, for boards too big for the cache
+ * @details A plain generation reads the whole board and writes the whole board, so once the board is bigger than the cache every generation waits on memory twice. Here the board is cut into tiles small enough that two copies of one stay in L2, and each tile is stepped depth generations before moving on. The first generation reads the tile and a halo of depth cells on every side of it from the board, the generations after it go back and forth between two scratch grids, and the last one writes the tile into the next grid. Every generation the cells that can still be worked out shrink by one on every side, since the cells at the edge are missing their outer neighbors, so after depth generations exactly the tile itself is right. Rows of the halo come around the torus through the row pointers and are dead past the hedge, tiles whose halo reaches past the sides are copied into scratch first so their cols can come around too. The halo is stepped again by the tiles around it, a little more work, but the board only goes through memory once every depth generations. Tiles only read the current grid and only write their own part of the next one, so they run on the pool with no locking, each thread on its own scratch.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/* what every tile of a pass needs */
+struct temporal_pass_t {
+        struct grid_t *grid;
+        struct grid_t *next_grid;
+        struct temporal_t *temporal;
+        int wrap; /* 1 on the torus, 0 on the hedge */
+        int depth;
+        int tile_cols; /* tiles across the board */
+        int width; /* cols in every tile but the last of a row */
+};
+
+/**
+ * Intilizes the scratch for stepping tiles up to depth generations at a time
+ * @param depth the most generations a pass will step, at most TEMPORAL_MAX_DEPTH
+ * @param threads the threads of the pool that will run the tiles, 1 with no pool
+ * @return the scratch, or NULL if an allocation failed
+ */
+struct temporal_t *init_temporal(int depth, int threads)
+{
+        int i;
+        unsigned char **cells;
+        struct temporal_t *temporal = calloc(1, sizeof(struct temporal_t));
+
+        if (!temporal) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        temporal->depth = (depth > TEMPORAL_MAX_DEPTH) ? TEMPORAL_MAX_DEPTH : depth;
+        temporal->threads = (threads < 1) ? 1 : threads;
+        temporal->scratch = calloc(2 * temporal->threads, sizeof(struct grid_t *));
+
+        if (!temporal->scratch) {
+                printf("Malloc failed\n");
+                free(temporal);
+                return NULL;
+        }
+
+        temporal->window = calloc(2 * temporal->threads, sizeof(struct grid_t));
+
+        if (!temporal->window) {
+                printf("Malloc failed\n");
+                free_temporal(temporal);
+                return NULL;
+        }
+
+        for (i = 0; i < 2 * temporal->threads; i++) {
+                temporal->scratch[i] = init_grid(TEMPORAL_ROWS + 2 * temporal->depth, TEMPORAL_COLS + 2 * temporal->depth);
+                cells = malloc(sizeof(unsigned char *) * (TEMPORAL_ROWS + 2 * temporal->depth + 2));
+                temporal->window[i].cell = (cells) ? cells + 1 : NULL; /* the same -1 to rows as a grid */
+
+                if (!temporal->scratch[i] || !cells) {
+                        printf("Malloc failed\n");
+                        free_temporal(temporal);
+                        return NULL;
+                }
+        }
+
+        return temporal;
+}
+
+/**
+ * frees the scratch made by init_temporal
+ * @param *temporal the scratch, may be NULL
+ */
+void free_temporal(struct temporal_t *temporal)
+{
+        int i;
+
+        if (!temporal) {
+                return;
+        }
+
+        for (i = 0; i < 2 * temporal->threads; i++) {
+                free_grid(temporal->scratch[i]);
+
+                if (temporal->window && temporal->window[i].cell) {
+                        free(temporal->window[i].cell - 1);
+                }
+        }
+        free(temporal->scratch);
+        free(temporal->window);
+        free(temporal);
+}
+
+/**
+ * says whether a pass of depth generations can be stepped in tiles. The halo has to come from the
+ * edge the same way every generation, which only the torus and the hedge do with a single wrap, and
+ * a rule reaching further than one cell would need a halo of depth times its radius
+ * @param *grid the board
+ * @param edge the edge of the board
+ * @param depth the generations in the pass
+ * @return 1 if it can, 0 if the board has to be stepped one generation at a time
+ */
+int temporal_fits(struct grid_t *grid, int edge, int depth)
+{
+        return (edge == EDGE_TORUS || edge == EDGE_HEDGE) && get_rule()->radius == 1 && depth <= grid->rows && depth <= grid->cols;
+}
+
+/**
+ * copies part of a row of the board into scratch, cols before 0 or past the last come around the torus or are dead
+ * @param *out where the cells go
+ * @param *row the row of the board, NULL for a row past the hedge
+ * @param cols the cols on the board
+ * @param first the first col to copy, no further before 0 than cols
+ * @param width how many cols to copy, no further past the last col than cols
+ * @param wrap 1 on the torus, 0 on the hedge
+ */
+static void fetch_row(unsigned char *out, const unsigned char *row, int cols, int first, int width, int wrap)
+{
+        int done = 0;
+        int n;
+
+        if (!row) {
+                memset(out, 0, width);
+                return;
+        }
+
+        if (first < 0) {
+                done = (-first < width) ? -first : width;
+                if (wrap) {
+                        memcpy(out, row + cols + first, done);
+                } else {
+                        memset(out, 0, done);
+                }
+                first = 0;
+        }
+
+        n = (width - done < cols - first) ? width - done : cols - first;
+        memcpy(out + done, row + first, n);
+        done += n;
+
+        if (done < width) {
+                if (wrap) {
+                        memcpy(out + done, row, width - done);
+                } else {
+                        memset(out + done, 0, width - done);
+                }
+        }
+}
+
+/**
+ * steps one tile of the board depth generations in the scratch of the thread and writes it to the next grid
+ * @param *arg the temporal_pass_t for the pass
+ * @param task which tile to step
+ * @param id the thread stepping it, it owns scratch and window 2 * id and 2 * id + 1
+ */
+static void step_tile(void *arg, int task, int id)
+{
+        int i;
+        int s;
+        int row;
+        struct temporal_pass_t *pass = arg;
+        struct grid_t *grid = pass->grid;
+        struct grid_t *a = pass->temporal->scratch[2 * id];
+        struct grid_t *b = pass->temporal->scratch[2 * id + 1];
+        struct grid_t *in = &pass->temporal->window[2 * id];
+        struct grid_t *out = &pass->temporal->window[2 * id + 1];
+        struct grid_t *from;
+        struct grid_t *to;
+        int depth = pass->depth;
+        int first = (task / pass->tile_cols) * TEMPORAL_ROWS;
+        int col = (task % pass->tile_cols) * pass->width;
+        int rows = (first + TEMPORAL_ROWS > grid->rows) ? grid->rows - first : TEMPORAL_ROWS;
+        int width = (col + pass->width > grid->cols) ? grid->cols - col : pass->width;
+        int height = rows + 2 * depth;
+        int span = width + 2 * depth;
+        /* the part of the scratch that is on the board, on the hedge nothing past it is ever stepped */
+        int top = (!pass->wrap && first < depth) ? depth - first : 0;
+        int bottom = (!pass->wrap && first + rows + depth > grid->rows) ? grid->rows - first + depth : height;
+        int left = (!pass->wrap && col < depth) ? depth - col : 0;
+        int right = (!pass->wrap && col + width + depth > grid->cols) ? grid->cols - col + depth : span;
+        int low;
+        int high;
+        int west;
+        int east;
+
+        if (col >= depth && col + width + depth <= grid->cols) {
+                /* the halo cols are all on the board, so the first generation reads the board where it is */
+                for (i = 0; i < height; i++) {
+                        row = first - depth + i;
+                        if (pass->wrap) {
+                                row = (row + grid->rows) % grid->rows;
+                        } else if (row < -1 || row > grid->rows) {
+                                row = -1; /* never read, the ghost rows are as far out as the hedge reaches */
+                        }
+                        in->cell[i] = grid->cell[row] + col - depth;
+                }
+                from = in;
+        } else {
+                for (i = 0; i < height; i++) {
+                        row = first - depth + i;
+                        if (pass->wrap) {
+                                row = (row + grid->rows) % grid->rows;
+                        }
+                        fetch_row(a->cell[i], (row >= 0 && row < grid->rows) ? grid->cell[row] : NULL, grid->cols, col - depth, span, pass->wrap);
+                }
+                from = a;
+        }
+
+        if (top > 0 || bottom < height || left > 0 || right < span) {
+                for (i = 0; i < height; i++) { /* the cells past the hedge have to read as dead from both copies */
+                        if (from != a) {
+                                memset(a->cell[i], 0, span);
+                        }
+                        memset(b->cell[i], 0, span);
+                }
+        }
+
+        for (i = depth; i < depth + rows; i++) { /* the last generation goes straight into the next grid */
+                out->cell[i] = pass->next_grid->cell[first - depth + i] + col - depth;
+        }
+
+        for (s = 1; s <= depth; s++) {
+                low = (s > top) ? s : top;
+                high = (height - s < bottom) ? height - s : bottom;
+                west = (s > left) ? s : left;
+                east = (span - s < right) ? span - s : right;
+                to = (s == depth) ? out : (from == a) ? b : a;
+
+                step_block(from, to, low, high, west, east - west);
+                from = to;
+        }
+}
+
+/**
+ * Does the same as depth calls of check_board, but a tile at a time so each tile stays in the cache for all of them
+ * @param *grid the grid to be checked, it is only read
+ * @param *next_grid the grid to be filled with the generation depth after grid
+ * @param *matrix_data a pointer to the main data for the matrix
+ * @param *temporal the scratch, made for at least depth generations and the threads of the pool
+ * @param *pool the pool to step the tiles on, NULL to step them on this thread
+ * @param depth the generations to step, temporal_fits has to say the board can take them
+ */
+void check_board_temporal(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data, struct temporal_t *temporal,
+                struct pool_t *pool, int depth)
+{
+        int i;
+        int tiles;
+        struct temporal_pass_t pass;
+
+        pass.grid = grid;
+        pass.next_grid = next_grid;
+        pass.temporal = temporal;
+        pass.wrap = matrix_data->edge == EDGE_TORUS;
+        pass.depth = depth;
+        pass.width = (grid->cols < TEMPORAL_COLS) ? grid->cols : TEMPORAL_COLS;
+        pass.tile_cols = (grid->cols + pass.width - 1) / pass.width;
+        tiles = (grid->rows + TEMPORAL_ROWS - 1) / TEMPORAL_ROWS * pass.tile_cols;
+
+        fill_ghost(grid, matrix_data->edge); /* the hedge tiles read the dead ghost border */
+
+        if (pool) {
+                pool_run(pool, tiles, step_tile, &pass);
+        } else {
+                for (i = 0; i < tiles; i++) {
+                        step_tile(&pass, i, 0);
+                }
+        }
+}
@@ -0,0 +1,41 @@
+#include "life.h"
+#include "pool.h"
+
+/**
+ * @file temporal.h
+ * @breif headers for stepping the byte engine several generations per pass over the board, in temporal.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef TEMPORAL_H_
+#define TEMPORAL_H_
+
+/* the part of the board a thread steps on its own, with its halo two of these stay in L2 */
+#define TEMPORAL_ROWS 128
+#define TEMPORAL_COLS 1024
+/* the most generations a pass steps, the halo grows by a cell on every side for each */
+#define TEMPORAL_MAX_DEPTH 16
+
+/* scratch for stepping tiles depth generations at a time, two grids for every thread of the pool.
+ * Every thread also has two windows, grids with no block of their own whose rows point into the
+ * board a tile is read from and the board it is written to, so a tile away from the sides of the
+ * board is stepped straight out of one and into the other */
+struct temporal_t {
+        int depth;
+        int threads;
+        struct grid_t **scratch;
+        struct grid_t *window;
+};
+
+struct temporal_t *init_temporal(int depth, int threads);
+
+void free_temporal(struct temporal_t *temporal);
+
+int temporal_fits(struct grid_t *grid, int edge, int depth);
+
+void check_board_temporal(struct grid_t *grid, struct grid_t *next_grid, struct data_t *matrix_data, struct temporal_t *temporal,
+                struct pool_t *pool, int depth);
+
+#endif
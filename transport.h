@@ -0,0 +1,34 @@
+#include <stddef.h>
+
+/**
+ * @file transport.h
+ * @breif the links worker processes send their edge rows over, and the shared memory rings behind them in ring.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+/* the two neighbors of a worker, the strip above it and the strip below it. The workers are a
+ * ring, the strip above worker 0 is the last one whether the edge wraps or not */
+#define LINK_UP 0
+#define LINK_DOWN 1
+
+/* how the workers of a distributed run talk to each other. Every worker can send bytes to the
+ * neighbor above or below it and read what they sent it, in the order it was sent. send and recv
+ * block until all len bytes have gone or come, and give -1 if the link broke. The shared memory
+ * rings made by init_ring_transport are one way to do it, anything else that keeps these
+ * promises, like a socket to another machine, can be put in its place */
+struct transport_t {
+        int procs;
+        int (*send)(struct transport_t *transport, int self, int link, const void *data, size_t len);
+        int (*recv)(struct transport_t *transport, int self, int link, void *data, size_t len);
+        void (*close)(struct transport_t *transport);
+        void *state;
+};
+
+struct transport_t *init_ring_transport(int procs, size_t capacity);
+
+#endif
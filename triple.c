@@ -0,0 +1,324 @@
+#include "triple.h"
+
+/**
+ * @file triple.c
+ * @breif A triple buffer of views of the board so the stepping thread and the window never wait on each other
+ * @details The stepping thread brings the back grid up to a finished generation and swaps it with the middle one in a single atomic exchange, marking it fresh. The window swaps its front grid with the middle one only when the middle is fresh. Each side always has a grid of its own, so neither ever blocks, and the window always gets the newest generation that was handed over. The grids are not the whole board, only a region around what the window shows, the window asks for the region it wants and the next hand-over moves there. The rest of the board is handed over as the alive count of each tile, which is all a zoomed out window needs. Only the tiles of the region that differ are copied. Each grid keeps a map of the tiles that changed in the hand-overs since it was last filled, those are copied whole, and any other tile is already the same as in the grid handed over before, so it is compared against itself and only its rows that differ are copied. If the region moved every tile of it is copied. Tiles outside the region are counted again every hand-over. The tiles that differ from the grid handed over before are flagged, so if the window took that one it only has to redraw the flagged tiles.
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+/**
+ * makes the three grids, all empty, each only as big as a region the window can show from its cells
+ * @param rows the number of rows on the board
+ * @param cols the number of cols on the board
+ * @param across the most rows of cells the window draws from the cells at once
+ * @param down the most cols of cells the window draws from the cells at once
+ * @return the triple buffer, or NULL if an allocation failed
+ */
+struct triple_t *init_triple(int rows, int cols, int across, int down)
+{
+        int i;
+        size_t tiles;
+        size_t region_tiles;
+        struct triple_t *triple = calloc(1, sizeof(struct triple_t));
+
+        if (!triple) {
+                printf("Malloc failed\n");
+                return NULL;
+        }
+
+        /* room for a tile either side, so a region starting on a whole tile still covers the view */
+        triple->rows = rows;
+        triple->cols = cols;
+        triple->region_rows = (across + TRIPLE_TILE - 1) / TRIPLE_TILE * TRIPLE_TILE + 2 * TRIPLE_TILE;
+        triple->region_cols = (down + TRIPLE_TILE - 1) / TRIPLE_TILE * TRIPLE_TILE + 2 * TRIPLE_TILE;
+        triple->region_rows = (triple->region_rows > rows) ? rows : triple->region_rows;
+        triple->region_cols = (triple->region_cols > cols) ? cols : triple->region_cols;
+        triple->tile_rows = (rows + TRIPLE_TILE - 1) / TRIPLE_TILE;
+        triple->tile_cols = (cols + TRIPLE_TILE - 1) / TRIPLE_TILE;
+        triple->region_tile_rows = (triple->region_rows + TRIPLE_TILE - 1) / TRIPLE_TILE;
+        triple->region_tile_cols = (triple->region_cols + TRIPLE_TILE - 1) / TRIPLE_TILE;
+        tiles = (size_t)triple->tile_rows * triple->tile_cols;
+        region_tiles = (size_t)triple->region_tile_rows * triple->region_tile_cols;
+
+        for (i = 0; i < 3; i++) {
+                triple->grid[i] = init_grid(triple->region_rows, triple->region_cols);
+                triple->dirty[i] = calloc(tiles, 1);
+                triple->count[i] = calloc(tiles, sizeof(int));
+                triple->stale[i] = malloc(region_tiles);
+
+                if (!triple->grid[i] || !triple->dirty[i] || !triple->count[i] || !triple->stale[i]) {
+                        printf("Malloc failed\n");
+                        free_triple(triple);
+                        return NULL;
+                }
+
+                /* nothing has been copied in yet */
+                memset(triple->stale[i], 1, region_tiles);
+                triple->row[i] = -1;
+                triple->col[i] = -1;
+        }
+
+        triple->last = -1;
+        triple->back = 0;
+        atomic_init(&triple->want, 0);
+        atomic_init(&triple->middle, 1);
+        triple->front = 2;
+
+        return triple;
+}
+
+/**
+ * frees a triple buffer, neither side may be using it
+ * @param *triple the triple buffer, may be NULL
+ */
+void free_triple(struct triple_t *triple)
+{
+        int i;
+
+        if (!triple) {
+                return;
+        }
+
+        for (i = 0; i < 3; i++) {
+                free_grid(triple->grid[i]);
+                free(triple->dirty[i]);
+                free(triple->count[i]);
+                free(triple->stale[i]);
+        }
+        free(triple);
+}
+
+/**
+ * whether the window has taken the last generation handed over, so a new one is worth copying
+ * @param *triple the triple buffer
+ * @return 1 if the middle grid has been taken, 0 if it is still waiting
+ */
+int triple_wanted(struct triple_t *triple)
+{
+        return !(atomic_load(&triple->middle) & TRIPLE_FRESH);
+}
+
+/**
+ * asks for the region the next hand-over holds, only called from the window
+ * @param *triple the triple buffer
+ * @param *row the board row of the top left corner, taken down to a whole tile and kept on the board
+ * @param *col the board col of the top left corner, taken down to a whole tile and kept on the board
+ */
+void triple_want(struct triple_t *triple, int *row, int *col)
+{
+        /* a region going past the end of the board is moved back until it only goes past by part of a tile */
+        *row = (*row > triple->rows - triple->region_rows) ? triple->rows - triple->region_rows + TRIPLE_TILE - 1 : *row;
+        *col = (*col > triple->cols - triple->region_cols) ? triple->cols - triple->region_cols + TRIPLE_TILE - 1 : *col;
+        *row = (*row < 0) ? 0 : *row / TRIPLE_TILE * TRIPLE_TILE;
+        *col = (*col < 0) ? 0 : *col / TRIPLE_TILE * TRIPLE_TILE;
+        atomic_store(&triple->want, (unsigned long long)*row << 32 | (unsigned int)*col);
+}
+
+/**
+ * whether the window asked for a region other than the one handed over last, so the same
+ * generation is worth handing over again, only called from the stepping thread
+ * @param *triple the triple buffer
+ * @return 1 if it did, 0 if not
+ */
+int triple_moved(struct triple_t *triple)
+{
+        unsigned long long want = atomic_load(&triple->want);
+
+        return triple->last >= 0 && ((int)(want >> 32) != triple->row[triple->last] || (int)(want & 0xffffffff) != triple->col[triple->last]);
+}
+
+/**
+ * counts the alive cells in one tile
+ * @param *grid the board
+ * @param t the tile row
+ * @param u the tile col
+ * @return the count
+ */
+static int count_tile(struct grid_t *grid, int t, int u)
+{
+        int i;
+        int j;
+        int count = 0;
+
+        for (i = t * TRIPLE_TILE; i < (t + 1) * TRIPLE_TILE && i < grid->rows; i++) {
+                for (j = u * TRIPLE_TILE; j < (u + 1) * TRIPLE_TILE && j < grid->cols; j++) {
+                        count += grid->cell[i][j] == 1; /* dying cells are not alive */
+                }
+        }
+
+        return count;
+}
+
+/**
+ * copies the rows of one tile of the board that differ into a region
+ * @param *region the region, a grid of the triple buffer
+ * @param row the board row of the top left corner of the region
+ * @param col the board col of the top left corner of the region
+ * @param *grid the board
+ * @param t the tile row on the board, inside the region
+ * @param u the tile col on the board, inside the region
+ * @param whole 1 to copy every row without comparing, for a tile the region is behind on
+ * @return 1 if any row was copied, 0 if the tile was already the same
+ */
+static int copy_tile(struct grid_t *region, int row, int col, struct grid_t *grid, int t, int u, int whole)
+{
+        int i;
+        int k = u * TRIPLE_TILE;
+        int width = (k + TRIPLE_TILE > grid->cols) ? grid->cols - k : TRIPLE_TILE;
+        int differed = 0;
+
+        for (i = t * TRIPLE_TILE; i < (t + 1) * TRIPLE_TILE && i < grid->rows; i++) {
+                if (whole || memcmp(region->cell[i - row] + k - col, grid->cell[i] + k, width) != 0) {
+                        memcpy(region->cell[i - row] + k - col, grid->cell[i] + k, width);
+                        differed = 1;
+                }
+        }
+
+        return differed;
+}
+
+/**
+ * whether one tile of the board differs from the grid handed over last, which is of the same region
+ * @param *last the grid handed over last, only ever read by either side so comparing against it is safe
+ * @param row the board row of the top left corner of the region
+ * @param col the board col of the top left corner of the region
+ * @param *grid the board
+ * @param t the tile row on the board, inside the region
+ * @param u the tile col on the board, inside the region
+ * @return 1 if it differs, 0 if not
+ */
+static int tile_differs(struct grid_t *last, int row, int col, struct grid_t *grid, int t, int u)
+{
+        int i;
+        int k = u * TRIPLE_TILE;
+        int width = (k + TRIPLE_TILE > grid->cols) ? grid->cols - k : TRIPLE_TILE;
+
+        for (i = t * TRIPLE_TILE; i < (t + 1) * TRIPLE_TILE && i < grid->rows; i++) {
+                if (memcmp(last->cell[i - row] + k - col, grid->cell[i] + k, width) != 0) {
+                        return 1;
+                }
+        }
+
+        return 0;
+}
+
+/**
+ * brings the back grid up to the region of the board the window asked for, flags the tiles that differ
+ * from the grid handed over last in its dirty map and counts them again. A tile of the region that is
+ * not stale in the back grid is the same as in the grid handed over last, so copying it tells whether it
+ * differs, a stale one is copied whole. A tile outside the region is counted and flagged if its count changed
+ * @param *triple the triple buffer
+ * @param *grid the generation about to be handed over, the whole board
+ */
+static void fill_back(struct triple_t *triple, struct grid_t *grid)
+{
+        int k;
+        int t;
+        int u;
+        int a;
+        int b;
+        int tile;
+        int moved;
+        int back = triple->back;
+        unsigned long long want = atomic_load(&triple->want);
+        int row = want >> 32;
+        int col = want & 0xffffffff;
+        struct grid_t *region = triple->grid[back];
+        unsigned char *dirty = triple->dirty[back];
+        unsigned char *stale = triple->stale[back];
+        int *count = triple->count[back];
+        int *last_count = (triple->last < 0) ? NULL : triple->count[triple->last];
+        struct grid_t *last = (triple->last < 0) ? NULL : triple->grid[triple->last];
+        size_t region_tiles = (size_t)triple->region_tile_rows * triple->region_tile_cols;
+
+        moved = !last || row != triple->row[triple->last] || col != triple->col[triple->last];
+
+        if (row != triple->row[back] || col != triple->col[back]) {
+                memset(stale, 1, region_tiles);
+                triple->row[back] = row;
+                triple->col[back] = col;
+        }
+
+        for (t = 0; t < triple->tile_rows; t++) {
+                for (u = 0; u < triple->tile_cols; u++) {
+                        tile = t * triple->tile_cols + u;
+                        a = t - row / TRIPLE_TILE;
+                        b = u - col / TRIPLE_TILE;
+
+                        if (a < 0 || a >= triple->region_tile_rows || b < 0 || b >= triple->region_tile_cols) {
+                                count[tile] = count_tile(grid, t, u);
+                                dirty[tile] = !last_count || count[tile] != last_count[tile];
+                                continue;
+                        }
+
+                        k = a * triple->region_tile_cols + b;
+                        if (stale[k]) {
+                                copy_tile(region, row, col, grid, t, u, 1);
+                                dirty[tile] = moved || tile_differs(last, row, col, grid, t, u);
+                                stale[k] = 0;
+                        } else {
+                                dirty[tile] = copy_tile(region, row, col, grid, t, u, 0);
+                        }
+
+                        count[tile] = dirty[tile] ? count_tile(grid, t, u) : last_count[tile];
+                }
+        }
+
+        /* the other two grids are behind on every tile that just changed, or on all of it when the region moved */
+        for (k = 0; k < 3; k++) {
+                if (k == back) {
+                        continue;
+                }
+
+                if (moved || triple->row[k] != row || triple->col[k] != col) {
+                        memset(triple->stale[k], 1, region_tiles);
+                        continue;
+                }
+
+                for (a = 0; a < triple->region_tile_rows && a + row / TRIPLE_TILE < triple->tile_rows; a++) {
+                        for (b = 0; b < triple->region_tile_cols && b + col / TRIPLE_TILE < triple->tile_cols; b++) {
+                                triple->stale[k][a * triple->region_tile_cols + b] |= dirty[(a + row / TRIPLE_TILE) * triple->tile_cols + b + col / TRIPLE_TILE];
+                        }
+                }
+        }
+}
+
+/**
+ * hands a generation over to the window, only called from the stepping thread
+ * @param *triple the triple buffer
+ * @param *grid the generation, the whole board
+ * @param generation which generation it is
+ */
+void triple_publish(struct triple_t *triple, struct grid_t *grid, unsigned long long generation)
+{
+        int back = triple->back;
+
+        fill_back(triple, grid);
+        triple->generation[back] = generation;
+        triple->seq[back] = (triple->last < 0) ? 1 : triple->seq[triple->last] + 1;
+        triple->last = back;
+        /* the copy is seen by the window before the exchange is */
+        triple->back = atomic_exchange(&triple->middle, triple->back | TRIPLE_FRESH) & ~TRIPLE_FRESH;
+}
+
+/**
+ * gets the newest generation handed over, only called from the window
+ * @param *triple the triple buffer
+ * @param *generation set to which generation the grid holds, may be NULL
+ * @return the grid, only the region from row and col of the front grid, it stays the window's until the next triple_take
+ */
+struct grid_t *triple_take(struct triple_t *triple, unsigned long long *generation)
+{
+        if (atomic_load(&triple->middle) & TRIPLE_FRESH) {
+                triple->front = atomic_exchange(&triple->middle, triple->front) & ~TRIPLE_FRESH;
+        }
+
+        if (generation) {
+                *generation = triple->generation[triple->front];
+        }
+
+        return triple->grid[triple->front];
+}
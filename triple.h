@@ -0,0 +1,70 @@
+#include <stdatomic.h>
+#include "life.h"
+
+/**
+ * @file triple.h
+ * @breif headers for handing finished generations from the stepping thread to the window, in triple.c
+ * @author Elijah Johnson
+ * @date 12/5/2016
+ * @bug none known
+ */
+
+#ifndef TRIPLE_H_
+#define TRIPLE_H_
+
+/* set in middle when the grid there has not been taken by the window yet */
+#define TRIPLE_FRESH 4
+/* cells on a side of the tiles that changes are tracked in */
+#define TRIPLE_TILE 32
+
+/* three grids, one the stepping thread is filling, one the window is drawing and one
+ * waiting in the middle. middle holds the index of the waiting grid and TRIPLE_FRESH,
+ * back is only touched by the stepping thread and front only by the window. Each grid only
+ * holds a region of region_rows by region_cols cells of the board, with row[k] and col[k] the
+ * board cell in its top left corner, a whole tile from the top left of the board, so a board
+ * bigger than the window is never copied whole. want is the top left corner the window asks for,
+ * the row in the high 32 bits. seq counts the grids handed over. dirty[k] and count[k] are for
+ * every tile of the board: dirty[k] flags the tiles that differ from the grid handed over before it,
+ * inside the region by their cells and outside it by their alive count, and count[k] holds the
+ * alive cells in each tile so a zoomed out window can draw the whole board from it. last is the
+ * grid handed over most recently or -1. stale[k] flags the tiles of the region of grid k that may
+ * differ from grid last, only the stepping thread uses it */
+struct triple_t {
+        struct grid_t *grid[3];
+        int row[3];
+        int col[3];
+        unsigned long long generation[3];
+        unsigned long long seq[3];
+        unsigned char *dirty[3];
+        int *count[3];
+        unsigned char *stale[3];
+        int rows;
+        int cols;
+        int region_rows;
+        int region_cols;
+        int tile_rows;
+        int tile_cols;
+        int region_tile_rows;
+        int region_tile_cols;
+        atomic_ullong want;
+        atomic_int middle;
+        int back;
+        int front;
+        int last;
+};
+
+struct triple_t *init_triple(int rows, int cols, int across, int down);
+
+void free_triple(struct triple_t *triple);
+
+int triple_wanted(struct triple_t *triple);
+
+void triple_want(struct triple_t *triple, int *row, int *col);
+
+int triple_moved(struct triple_t *triple);
+
+void triple_publish(struct triple_t *triple, struct grid_t *grid, unsigned long long generation);
+
+struct grid_t *triple_take(struct triple_t *triple, unsigned long long *generation);
+
+#endif